@@ -0,0 +1,254 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "counting_new.h"
+
+#include "vector_tree/drift_bvh.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * Compares drift_bvh with a pointer BVH of the same hierarchy
+ * - build_binned, build_sweep: drift_bvh with the binned and the sweep SAH builder
+ * - build: the pointer BVH, copied node by node from the binned hierarchy
+ * - rays: 2^16 segments of length 0.25, counts the primitives whose box they hit
+ * - packets: the same rays in packets of four, each packet shares its origin (drift_bvh only)
+ * - overlap: 2^14 boxes of twice the primitive size, counts the overlapping primitives
+ * - memory: bytes allocated per primitive after the build
+ *
+ * The scene has clusters of small boxes in the unit cube.
+ * The pointer BVH allocates every node and traverses with a stack, children are visited left to right.
+ * Builds are reported per primitive, queries per query (the nodes column is the number of queries),
+ * bytes_per_node counts requested heap bytes per primitive.
+ *
+ * usage: bench_bvh [primitives...]
+ */
+
+namespace {
+
+using bvh_t = vt::drift_bvh;
+
+const size_t ray_count = size_t(1) << 16;
+const size_t box_query_count = size_t(1) << 14;
+
+// classic BVH with individually allocated nodes and child pointers
+struct pointer_bvh {
+    struct node {
+        vt::aabb bounds;
+        std::vector<std::unique_ptr<node>> children;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    // the same hierarchy as the drift_bvh
+    explicit pointer_bvh(const bvh_t& bvh) : primitives(bvh.primitives()) {
+        const auto& tree = bvh.tree();
+        std::vector<node*> path;
+        size_t level = 0;
+        for (const auto& n : tree) {
+            auto made = new node;
+            made->bounds = n.data.bounds;
+            if (n.data.is_leaf()) {
+                made->first = n.data.link;
+                made->count = n.data.count();
+            }
+            path.resize(level);
+            if (level) path.back()->children.emplace_back(made);
+            else root.reset(made);
+            path.push_back(made);
+            level = level + 1 - vt::drift_of(n);
+        }
+    }
+
+    template<typename Hit, typename Leaf>
+    void traverse(Hit hit, Leaf leaf) const {
+        std::vector<const node*> stack;
+        if (root) stack.push_back(root.get());
+        while (!stack.empty()) {
+            auto n = stack.back();
+            stack.pop_back();
+            if (!hit(n->bounds)) continue;
+            for (auto i = n->first; i < n->first + n->count; ++i) leaf(primitives[i]);
+            for (auto it = n->children.rbegin(); it != n->children.rend(); ++it) stack.push_back(it->get());
+        }
+    }
+
+    std::unique_ptr<node> root;
+    std::vector<uint32_t> primitives;
+};
+
+std::vector<vt::aabb>
+make_scene(size_t count) {
+    bench::xorshift random(42);
+    auto uniform = [&] { return float(random.below(1u << 24)) / float(1u << 24); };
+    auto size = 0.5f / std::cbrt(float(count));
+    std::vector<vt::aabb> boxes;
+    boxes.reserve(count);
+    while (boxes.size() < count) {
+        float center[3] = {uniform(), uniform(), uniform()};
+        auto members = std::min<size_t>(1 + random.below(64), count - boxes.size());
+        for (size_t k = 0; k < members; ++k) {
+            float lo[3];
+            for (int a = 0; a < 3; ++a) lo[a] = center[a] + (uniform() - 0.5f) * 0.05f;
+            boxes.emplace_back(lo[0], lo[1], lo[2], lo[0] + size * uniform(), lo[1] + size * uniform(),
+                               lo[2] + size * uniform());
+        }
+    }
+    return boxes;
+}
+
+// groups of four rays share the origin and differ by a small angle, like neighboring pixels
+std::vector<vt::ray>
+make_rays() {
+    bench::xorshift random(7);
+    auto uniform = [&] { return float(random.below(1u << 24)) / float(1u << 24); };
+    std::vector<vt::ray> rays(ray_count);
+    float origin[3] = {}, direction[3] = {};
+    for (size_t k = 0; k < rays.size(); ++k) {
+        if (0 == k % vt::ray_packet::width) {
+            for (int a = 0; a < 3; ++a) {
+                origin[a] = uniform();
+                direction[a] = uniform() - 0.5f;
+            }
+        }
+        auto& r = rays[k];
+        float length = 0;
+        for (int a = 0; a < 3; ++a) {
+            r.origin[a] = origin[a];
+            r.direction[a] = direction[a] + (uniform() - 0.5f) * 0.01f;
+            length += r.direction[a] * r.direction[a];
+        }
+        length = std::sqrt(length);
+        for (auto& d : r.direction) d /= length;
+        r.t_max = 0.25f;
+    }
+    return rays;
+}
+
+std::vector<vt::aabb>
+make_queries(const std::vector<vt::aabb>& boxes) {
+    std::vector<vt::aabb> queries;
+    for (size_t k = 0; k < box_query_count; ++k) {
+        auto query = boxes[boxes.size() * k / box_query_count];
+        for (int a = 0; a < 3; ++a) query.hi[a] += query.extent(a);
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+template<typename Fn>
+double
+bytes_per_primitive(size_t primitives, Fn build) {
+    auto before = bench::allocated_bytes().load();
+    build();
+    return double(bench::allocated_bytes().load() - before) / double(primitives);
+}
+
+void
+run(size_t count) {
+    auto boxes = make_scene(count);
+    auto rays = make_rays();
+    auto queries = make_queries(boxes);
+
+    std::unique_ptr<bvh_t> bvh;
+    vt::bvh_options sweep;
+    sweep.builder = vt::bvh_builder::sweep_sah;
+    auto build_sweep = bench::measure([&] { bvh.reset(new bvh_t(boxes, sweep)); }, 1);
+    bench::report("build_sweep", "drift_bvh", count, build_sweep, 0);
+    auto build = bench::measure([&] { bvh.reset(new bvh_t(boxes)); }, 3);
+    bvh.reset();
+    auto bytes = bytes_per_primitive(count, [&] { bvh.reset(new bvh_t(boxes)); });
+    bench::report("build_binned", "drift_bvh", count, build, bytes);
+    bench::report("memory", "drift_bvh", count, 0, bytes);
+
+    std::unique_ptr<pointer_bvh> pointer;
+    auto pointer_build = bench::measure([&] { pointer.reset(new pointer_bvh(*bvh)); }, 3);
+    pointer.reset();
+    auto pointer_bytes = bytes_per_primitive(count, [&] { pointer.reset(new pointer_bvh(*bvh)); });
+    bench::report("build", "pointer_bvh", count, pointer_build, pointer_bytes);
+    bench::report("memory", "pointer_bvh", count, 0, pointer_bytes);
+
+    auto hit_count = [&](const vt::ray& r, const float inverse[3], uint32_t primitive) {
+        return vt::intersects(r.origin, inverse, r.t_min, r.t_max, boxes[primitive]) ? 1 : 0;
+    };
+
+    auto drift_rays = bench::measure([&] {
+        size_t hits = 0;
+        for (auto r : rays) {
+            float inverse[3] = {1 / r.direction[0], 1 / r.direction[1], 1 / r.direction[2]};
+            bvh->intersect(r, [&](uint32_t primitive, vt::ray& ray) { hits += hit_count(ray, inverse, primitive); });
+        }
+        bench::keep(hits);
+    });
+    bench::report("rays", "drift_bvh", ray_count, drift_rays, bytes);
+
+    auto drift_packets = bench::measure([&] {
+        size_t hits = 0;
+        for (size_t k = 0; k < rays.size(); k += vt::ray_packet::width) {
+            vt::ray_packet packet(rays.data() + k, std::min(size_t(vt::ray_packet::width), rays.size() - k));
+            bvh->intersect(packet, [&](uint32_t primitive, unsigned mask, const vt::ray_packet&) {
+                hits += std::bitset<vt::ray_packet::width>(mask & packet.hit_mask(boxes[primitive])).count();
+            });
+        }
+        bench::keep(hits);
+    });
+    bench::report("packets", "drift_bvh", ray_count, drift_packets, bytes);
+
+    auto pointer_rays = bench::measure([&] {
+        size_t hits = 0;
+        for (const auto& r : rays) {
+            float inverse[3] = {1 / r.direction[0], 1 / r.direction[1], 1 / r.direction[2]};
+            pointer->traverse([&](const vt::aabb& bounds) {
+                return vt::intersects(r.origin, inverse, r.t_min, r.t_max, bounds);
+            }, [&](uint32_t primitive) { hits += hit_count(r, inverse, primitive); });
+        }
+        bench::keep(hits);
+    });
+    bench::report("rays", "pointer_bvh", ray_count, pointer_rays, pointer_bytes);
+
+    auto drift_overlap = bench::measure([&] {
+        size_t found = 0;
+        for (const auto& query : queries)
+            bvh->overlap(query, [&](uint32_t primitive) { found += boxes[primitive].overlaps(query); });
+        bench::keep(found);
+    });
+    bench::report("overlap", "drift_bvh", box_query_count, drift_overlap, bytes);
+
+    auto pointer_overlap = bench::measure([&] {
+        size_t found = 0;
+        for (const auto& query : queries)
+            pointer->traverse([&](const vt::aabb& bounds) { return bounds.overlaps(query); },
+                              [&](uint32_t primitive) { found += boxes[primitive].overlaps(query); });
+        bench::keep(found);
+    });
+    bench::report("overlap", "pointer_bvh", box_query_count, pointer_overlap, pointer_bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto count : bench::sizes(argc, argv, {100000, 1000000, 4000000})) run(count);
+}
@@ -0,0 +1,86 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+
+#include <utility>
+#include <vector>
+
+/*
+ * Cost of side columns for structural edits
+ * - build: push_back_* with 0, 1 and 4 attached columns
+ * - bulk_insert: insert_child_trees with one subtree every 16 nodes
+ *
+ * bytes_per_node counts the node and the column values
+ *
+ * usage: bench_columns [nodes...]
+ */
+
+namespace {
+
+using tree_t = vt::drift_tree<uint32_t>;
+
+const size_t max_level = 64;
+
+void
+attach(tree_t& tree, size_t columns) {
+    for (size_t c = 0; c < columns; ++c) tree.attach_column<float>();
+}
+
+void
+run(const char* variant, size_t columns, size_t nodes) {
+    auto bytes = double(sizeof(tree_t::node_t) + columns * sizeof(float));
+
+    tree_t tree;
+    auto build = bench::measure([&] {
+        tree = tree_t();
+        attach(tree, columns);
+        bench::random_tree(tree, nodes, max_level, 42, [](size_t i) { return uint32_t(i); });
+    }, 3);
+    bench::report("build", variant, nodes, build, bytes);
+
+    tree_t sub;
+    sub.push_root(1);
+    sub.push_back_child(2);
+    sub.push_back_sibling(3);
+    std::vector<std::pair<size_t, tree_t>> entries;
+    for (size_t pos = 0; pos < nodes; pos += 16) entries.emplace_back(pos, sub);
+    auto bulk = bench::measure_prepared([&] {
+        tree = tree_t();
+        attach(tree, columns);
+        bench::random_tree(tree, nodes, max_level, 42, [](size_t i) { return uint32_t(i); });
+    }, [&] {
+        tree.insert_child_trees(entries.begin(), entries.end());
+        bench::keep(tree);
+    }, 3);
+    bench::report("bulk_insert", variant, nodes, bulk, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {100000, 1000000, 10000000})) {
+        run("none", 0, nodes);
+        run("one", 1, nodes);
+        run("four", 4, nodes);
+    }
+}
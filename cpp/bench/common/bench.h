@@ -0,0 +1,143 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace bench {
+
+// keeps the optimizer from removing a computed value
+template<typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+}
+
+// best wall time of repeated runs in seconds
+template<typename Fn>
+double measure(Fn&& fn, int repeat = 5) {
+        auto best = 1e300;
+        for (int r = 0; r < repeat; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                fn();
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+        }
+        return best;
+}
+
+// best wall time of repeated runs, prepare runs untimed before each run
+template<typename Prepare, typename Fn>
+double measure_prepared(Prepare&& prepare, Fn&& fn, int repeat = 5) {
+        auto best = 1e300;
+        for (int r = 0; r < repeat; ++r) {
+                prepare();
+                auto start = std::chrono::steady_clock::now();
+                fn();
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+        }
+        return best;
+}
+
+// node counts from the command line, defaults otherwise
+inline std::vector<size_t> sizes(int argc, char** argv, std::vector<size_t> defaults) {
+        if (argc < 2) return defaults;
+        std::vector<size_t> result;
+        for (int i = 1; i < argc; ++i) result.push_back(std::strtoull(argv[i], nullptr, 10));
+        return result;
+}
+
+// csv rows, one per measurement
+inline void print_header() {
+        std::printf("benchmark,variant,nodes,seconds,ns_per_node,bytes_per_node\n");
+}
+
+inline void report(const char* benchmark, const char* variant, size_t nodes, double seconds, double bytes_per_node) {
+        std::printf("%s,%s,%zu,%.9f,%.3f,%.2f\n", benchmark, variant, nodes, seconds,
+                    nodes ? seconds * 1e9 / nodes : 0.0, bytes_per_node);
+        std::fflush(stdout);
+}
+
+// csv rows for benchmarks that vary the tree shape
+// ops counts the timed operations, one per node for whole tree passes, one per edit for edits
+inline void print_shaped_header() {
+        std::printf("benchmark,variant,shape,nodes,ops,seconds,ns_per_op,bytes_per_node\n");
+}
+
+inline void report(const char* benchmark, const char* variant, const char* shape, size_t nodes, size_t ops,
+                   double seconds, double bytes_per_node) {
+        std::printf("%s,%s,%s,%zu,%zu,%.9f,%.3f,%.2f\n", benchmark, variant, shape, nodes, ops, seconds,
+                    ops ? seconds * 1e9 / ops : 0.0, bytes_per_node);
+        std::fflush(stdout);
+}
+
+// whole tree passes, one op per node
+inline void report(const char* benchmark, const char* variant, const char* shape, size_t nodes, double seconds,
+                   double bytes_per_node) {
+        report(benchmark, variant, shape, nodes, nodes, seconds, bytes_per_node);
+}
+
+// deterministic pseudo random numbers
+struct xorshift {
+        explicit xorshift(uint64_t seed) : state_m(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+        uint64_t operator()() noexcept {
+                state_m ^= state_m << 13;
+                state_m ^= state_m >> 7;
+                state_m ^= state_m << 17;
+                return state_m;
+        }
+        uint64_t below(uint64_t bound) noexcept { return (*this)() % bound; }
+
+private:
+        uint64_t state_m;
+};
+
+// random tree with a single root and levels up to max_level
+template<typename tree_t, typename Make>
+void random_tree(tree_t& tree, size_t nodes, size_t max_level, uint64_t seed, Make make) {
+        xorshift random(seed);
+        tree.clear();
+        tree.reserve(nodes);
+        tree.push_root(make(0));
+        size_t level = 0;
+        for (size_t i = 1; i < nodes; ++i) {
+                auto next = 1 + random.below(level + 1);
+                if (next > level && level < max_level) {
+                        tree.push_back_child(make(i));
+                        level += 1;
+                }
+                else {
+                        level = std::min(next, level);
+                        tree.push_back_level(make(i), level);
+                }
+        }
+}
+
+} // namespace bench
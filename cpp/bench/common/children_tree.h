@@ -0,0 +1,119 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+/*!
+ * Tree with all nodes in one vector and a vector of child indices per node
+ *
+ * The common layout of scene graphs and DOM implementations.
+ * Erased nodes stay in the vector, they are only unlinked from their parent.
+ */
+template<typename _data_t>
+struct children_tree
+{
+        using data_t = _data_t;
+        using index_t = uint32_t;
+
+        static constexpr index_t npos = index_t(-1);
+
+        struct node {
+                data_t data;
+                index_t parent;
+                std::vector<index_t> children;
+        };
+
+        size_t size() const noexcept { return size_m; }
+        const node& operator[](index_t i) const noexcept { return nodes_m[i]; }
+
+        void reserve(size_t count) { nodes_m.reserve(count); }
+
+        void clear() {
+                nodes_m.clear();
+                size_m = 0;
+        }
+
+        // appends a node as last child of parent, npos makes it the root
+        index_t add(index_t parent, data_t data) {
+                auto i = index_t(nodes_m.size());
+                nodes_m.push_back({data, parent, {}});
+                if (parent != npos) nodes_m[parent].children.push_back(i);
+                size_m += 1;
+                return i;
+        }
+
+        // inserts a node as first child of parent
+        index_t add_first(index_t parent, data_t data) {
+                auto i = index_t(nodes_m.size());
+                nodes_m.push_back({data, parent, {}});
+                auto& children = nodes_m[parent].children;
+                children.insert(children.begin(), i);
+                size_m += 1;
+                return i;
+        }
+
+        // unlinks a node without children
+        void erase_leaf(index_t i) {
+                auto& children = nodes_m[nodes_m[i].parent].children;
+                children.erase(std::find(children.begin(), children.end(), i));
+                size_m -= 1;
+        }
+
+        // copies the shape and data of a drift tree with a single root
+        template<typename tree_t>
+        void assign(const tree_t& tree) {
+                clear();
+                reserve(tree.size());
+                std::vector<index_t> path;
+                size_t level = 0;
+                for (const auto& n : tree) {
+                        path.resize(level);
+                        path.push_back(add(level ? path[level - 1] : npos, n.data));
+                        level = level + 1 - drift_of(n);
+                }
+        }
+
+        // calls fn for every node of the subtree of top before its descendants
+        template<typename Fn>
+        void pre_order(index_t top, Fn fn) const {
+                std::vector<index_t> stack{top};
+                while (!stack.empty()) {
+                        auto& n = nodes_m[stack.back()];
+                        stack.pop_back();
+                        fn(n);
+                        stack.insert(stack.end(), n.children.rbegin(), n.children.rend());
+                }
+        }
+
+        template<typename Fn>
+        void pre_order(Fn fn) const {
+                if (!nodes_m.empty()) pre_order(0, fn);
+        }
+
+private:
+        std::vector<node> nodes_m;
+        size_t size_m = 0;
+};
+
+} // namespace bench
@@ -0,0 +1,117 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace bench {
+
+// one timing of an operation at a tree size
+struct sample {
+        size_t nodes;
+        double ns_per_op;
+};
+
+/*!
+ * Exponent b of the power law ns_per_op = a * nodes^b
+ *
+ * Least squares fit of log(ns_per_op) over log(nodes).
+ * O(1) operations fit to about 0, O(n) operations to about 1.
+ * Cache effects bend the curves, compare with a tolerance.
+ */
+inline double fit_exponent(const std::vector<sample>& samples) {
+        if (samples.size() < 2) return 0;
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (const auto& s : samples) {
+                auto x = std::log(double(s.nodes));
+                auto y = std::log(s.ns_per_op > 0 ? s.ns_per_op : 1e-3);
+                sx += x;
+                sy += y;
+                sxx += x * x;
+                sxy += x * y;
+        }
+        auto n = double(samples.size());
+        auto denominator = n * sxx - sx * sx;
+        return denominator != 0 ? (n * sxy - sx * sy) / denominator : 0;
+}
+
+/*!
+ * ns_per_op of an earlier run, read from its csv output
+ *
+ * Rows are keyed by benchmark, variant, position and nodes,
+ * the columns are found by the names in the header line.
+ */
+struct baseline {
+        using key_t = std::tuple<std::string, std::string, std::string, size_t>;
+
+        bool load(const char* path) {
+                auto file = std::fopen(path, "r");
+                if (!file) return false;
+                std::vector<std::string> header;
+                char line[1024];
+                while (std::fgets(line, sizeof(line), file)) {
+                        auto fields = split(line);
+                        if (header.empty()) {
+                                header = fields;
+                                continue;
+                        }
+                        auto field = [&](const char* name) -> std::string {
+                                for (size_t i = 0; i < header.size() && i < fields.size(); ++i)
+                                        if (header[i] == name) return fields[i];
+                                return {};
+                        };
+                        auto ns = field("ns_per_op");
+                        if (ns.empty()) continue;
+                        key_t key(field("benchmark"), field("variant"), field("position"),
+                                  std::strtoull(field("nodes").c_str(), nullptr, 10));
+                        values_m[key] = std::strtod(ns.c_str(), nullptr);
+                }
+                std::fclose(file);
+                return !header.empty();
+        }
+
+        // 0 if the run had no such measurement
+        double find(const std::string& benchmark, const std::string& variant, const std::string& position,
+                    size_t nodes) const {
+                auto it = values_m.find(key_t(benchmark, variant, position, nodes));
+                return it != values_m.end() ? it->second : 0;
+        }
+
+        bool empty() const noexcept { return values_m.empty(); }
+
+private:
+        static std::vector<std::string> split(const char* line) {
+                std::vector<std::string> fields(1);
+                for (auto c = line; *c && *c != '\n' && *c != '\r'; ++c) {
+                        if (*c == ',') fields.emplace_back();
+                        else fields.back() += *c;
+                }
+                return fields;
+        }
+
+        std::map<key_t, double> values_m;
+};
+
+} // namespace bench
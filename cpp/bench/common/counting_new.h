@@ -0,0 +1,83 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Replaces the global operator new and delete to count the live heap bytes of the process
+ *
+ * Every allocation stores its size in front of the returned memory.
+ * The replacements are ordinary definitions, so include this header
+ * in exactly one translation unit of a benchmark.
+ */
+
+namespace bench {
+
+// requested heap bytes that are not freed yet, without the overhead of malloc
+inline std::atomic<size_t>& allocated_bytes() {
+        static std::atomic<size_t> bytes{0};
+        return bytes;
+}
+
+namespace detail {
+
+// kept out of line, otherwise the compiler matches the free() against an inlined new expression
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+inline void* counted_allocate(size_t size) noexcept {
+        auto p = static_cast<size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+        if (!p) return nullptr;
+        *p = size;
+        allocated_bytes() += size;
+        return reinterpret_cast<char*>(p) + sizeof(std::max_align_t);
+}
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+inline void counted_free(void* ptr) noexcept {
+        if (!ptr) return;
+        auto p = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - sizeof(std::max_align_t));
+        allocated_bytes() -= *p;
+        std::free(p);
+}
+
+} // namespace detail
+} // namespace bench
+
+void* operator new(size_t size) {
+        auto p = bench::detail::counted_allocate(size);
+        if (!p) throw std::bad_alloc();
+        return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return bench::detail::counted_allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return bench::detail::counted_allocate(size); }
+
+void operator delete(void* ptr) noexcept { bench::detail::counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { bench::detail::counted_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { bench::detail::counted_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { bench::detail::counted_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { bench::detail::counted_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { bench::detail::counted_free(ptr); }
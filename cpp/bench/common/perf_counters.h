@@ -0,0 +1,210 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+/*!
+ * Hardware and software event counters of the calling thread
+ *
+ * Uses perf_event_open on Linux. Every event is opened on its own, so events
+ * the CPU, the kernel or a virtual machine do not provide are just missing.
+ * Counts are scaled when the kernel multiplexes the events.
+ * Set VT_BENCH_NO_COUNTERS to skip the counters altogether.
+ *
+ * HINT: counting user space only works with kernel.perf_event_paranoid <= 2
+ */
+struct perf_counters
+{
+        enum event { cycles, instructions, l1d_misses, cache_misses, tlb_misses, branch_misses, page_faults, event_count };
+
+        static const char* name(event e) noexcept {
+                static const char* names[event_count] = {"cycles", "instructions", "l1d_misses", "cache_misses",
+                                                         "tlb_misses", "branch_misses", "page_faults"};
+                return names[e];
+        }
+
+        // counts of one measured run, missing events are not valid
+        struct values {
+                uint64_t count[event_count] = {};
+                bool valid[event_count] = {};
+
+                bool has(event e) const noexcept { return valid[e]; }
+                double per(event e, size_t n) const noexcept { return n ? double(count[e]) / double(n) : 0.0; }
+                double ipc() const noexcept {
+                        return valid[cycles] && valid[instructions] && count[cycles]
+                                ? double(count[instructions]) / double(count[cycles]) : 0.0;
+                }
+        };
+
+        perf_counters() {
+                for (auto& fd : fds_m) fd = -1;
+                if (std::getenv("VT_BENCH_NO_COUNTERS")) return;
+#if defined(__linux__)
+                const struct { uint32_t type; uint64_t config; } events[event_count] = {
+                        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D)},
+                        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB)},
+                        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+                };
+                for (int e = 0; e < event_count; ++e) {
+                        perf_event_attr attr;
+                        std::memset(&attr, 0, sizeof(attr));
+                        attr.size = sizeof(attr);
+                        attr.type = events[e].type;
+                        attr.config = events[e].config;
+                        attr.disabled = 1;
+                        attr.exclude_kernel = 1;
+                        attr.exclude_hv = 1;
+                        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                        fds_m[e] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+                }
+#endif
+        }
+        ~perf_counters() {
+#if defined(__linux__)
+                for (auto fd : fds_m)
+                        if (fd >= 0) close(fd);
+#endif
+        }
+        perf_counters(const perf_counters&) = delete;
+        perf_counters& operator =(const perf_counters&) = delete;
+
+        bool available(event e) const noexcept { return fds_m[e] >= 0; }
+        bool any_available() const noexcept {
+                for (auto fd : fds_m)
+                        if (fd >= 0) return true;
+                return false;
+        }
+
+        void start() noexcept {
+#if defined(__linux__)
+                for (auto fd : fds_m) {
+                        if (fd < 0) continue;
+                        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif
+        }
+
+        void stop() noexcept {
+#if defined(__linux__)
+                for (auto fd : fds_m)
+                        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+        }
+
+        // counts since the last start, scaled up if the event did not run all the time
+        values read() const noexcept {
+                values result;
+#if defined(__linux__)
+                for (int e = 0; e < event_count; ++e) {
+                        if (fds_m[e] < 0) continue;
+                        uint64_t data[3] = {};
+                        if (::read(fds_m[e], data, sizeof(data)) != ssize_t(sizeof(data)) || 0 == data[2]) continue;
+                        result.count[e] = data[2] < data[1] ? uint64_t(double(data[0]) * double(data[1]) / double(data[2]))
+                                                            : data[0];
+                        result.valid[e] = true;
+                }
+#endif
+                return result;
+        }
+
+private:
+#if defined(__linux__)
+        static constexpr uint64_t cache_event(uint64_t cache) noexcept {
+                return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8)
+                        | (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+        }
+#endif
+
+        int fds_m[event_count];
+};
+
+// wall time and counters of the fastest run
+struct counted {
+        double seconds = 1e300;
+        perf_counters::values values;
+};
+
+// best run of repeated runs with counters, prepare runs untimed before each run
+template<typename Prepare, typename Fn>
+counted measure_counted_prepared(perf_counters& counters, Prepare&& prepare, Fn&& fn, int repeat = 5) {
+        counted best;
+        for (int r = 0; r < repeat; ++r) {
+                prepare();
+                auto start = std::chrono::steady_clock::now();
+                counters.start();
+                fn();
+                counters.stop();
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (elapsed.count() < best.seconds) {
+                        best.seconds = elapsed.count();
+                        best.values = counters.read();
+                }
+        }
+        return best;
+}
+
+template<typename Fn>
+counted measure_counted(perf_counters& counters, Fn&& fn, int repeat = 5) {
+        return measure_counted_prepared(counters, [] {}, std::forward<Fn>(fn), repeat);
+}
+
+// csv rows with counters per node, events that are not available stay empty
+inline void print_counter_header() {
+        std::printf("benchmark,variant,nodes,seconds,ns_per_node,bytes_per_node,ipc");
+        for (int e = 0; e < perf_counters::event_count; ++e)
+                std::printf(",%s_per_node", perf_counters::name(perf_counters::event(e)));
+        std::printf("\n");
+}
+
+inline void report(const char* benchmark, const char* variant, size_t nodes, const counted& run,
+                   double bytes_per_node) {
+        std::printf("%s,%s,%zu,%.9f,%.3f,%.2f,", benchmark, variant, nodes, run.seconds,
+                    nodes ? run.seconds * 1e9 / nodes : 0.0, bytes_per_node);
+        if (run.values.has(perf_counters::cycles) && run.values.has(perf_counters::instructions))
+                std::printf("%.3f", run.values.ipc());
+        for (int e = 0; e < perf_counters::event_count; ++e) {
+                auto event = perf_counters::event(e);
+                if (run.values.has(event)) std::printf(",%.4f", run.values.per(event, nodes));
+                else std::printf(",");
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+}
+
+} // namespace bench
@@ -0,0 +1,172 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+
+namespace bench {
+
+/*!
+ * Classical tree with individually allocated nodes
+ * linked to their parent, first child and next sibling
+ *
+ * Used as the baseline for the vector based trees.
+ */
+template<typename _data_t>
+struct pointer_tree
+{
+        using data_t = _data_t;
+
+        struct node {
+                data_t data;
+                node* parent;
+                node* first_child;
+                node* last_child;
+                node* next_sibling;
+        };
+
+        pointer_tree() = default;
+        pointer_tree(const pointer_tree&) = delete;
+        pointer_tree& operator =(const pointer_tree&) = delete;
+        ~pointer_tree() { clear(); }
+
+        node* root() const noexcept { return root_m; }
+        size_t size() const noexcept { return size_m; }
+
+        // appends a node as last child of parent, nullptr makes it the root
+        node* add(node* parent, data_t data) {
+                auto n = new node{data, parent, nullptr, nullptr, nullptr};
+                size_m += 1;
+                if (!parent) {
+                        root_m = n;
+                        return n;
+                }
+                if (parent->last_child)
+                        parent->last_child->next_sibling = n;
+                else
+                        parent->first_child = n;
+                parent->last_child = n;
+                return n;
+        }
+
+        // inserts a node as first child of parent
+        node* add_first(node* parent, data_t data) {
+                auto n = new node{data, parent, nullptr, nullptr, parent->first_child};
+                size_m += 1;
+                parent->first_child = n;
+                if (!parent->last_child) parent->last_child = n;
+                return n;
+        }
+
+        // copies the shape and data of a drift tree with a single root
+        template<typename tree_t>
+        void assign(const tree_t& tree) {
+                clear();
+                std::vector<node*> path;
+                size_t level = 0;
+                for (const auto& n : tree) {
+                        path.resize(level);
+                        path.push_back(add(level ? path[level - 1] : nullptr, n.data));
+                        level = level + 1 - drift_of(n);
+                }
+        }
+
+        // removes a node without children
+        void erase_leaf(node* n) {
+                auto parent = n->parent;
+                if (!parent) {
+                        root_m = nullptr;
+                }
+                else if (parent->first_child == n) {
+                        parent->first_child = n->next_sibling;
+                        if (parent->last_child == n) parent->last_child = nullptr;
+                }
+                else {
+                        auto prev = parent->first_child;
+                        while (prev->next_sibling != n) prev = prev->next_sibling;
+                        prev->next_sibling = n->next_sibling;
+                        if (parent->last_child == n) parent->last_child = prev;
+                }
+                delete n;
+                size_m -= 1;
+        }
+
+        void clear() {
+                // post order without recursion
+                auto n = root_m;
+                while (n) {
+                        if (n->first_child) {
+                                auto child = n->first_child;
+                                n->first_child = nullptr;
+                                n = child;
+                                continue;
+                        }
+                        auto next = n->next_sibling ? n->next_sibling : n->parent;
+                        delete n;
+                        n = next;
+                }
+                root_m = nullptr;
+                size_m = 0;
+        }
+
+        // calls fn for every node after its descendants
+        template<typename Fn>
+        void post_order(Fn fn) const {
+                auto n = root_m;
+                if (!n) return;
+                while (n->first_child) n = n->first_child;
+                while (n) {
+                        fn(*n);
+                        if (n->next_sibling) {
+                                n = n->next_sibling;
+                                while (n->first_child) n = n->first_child;
+                        }
+                        else {
+                                n = n->parent;
+                        }
+                }
+        }
+
+        // calls fn for every node before its descendants
+        template<typename Fn>
+        void pre_order(Fn fn) const {
+                pre_order(root_m, fn);
+        }
+
+        // pre order of the subtree of top including top
+        template<typename Fn>
+        void pre_order(const node* top, Fn fn) const {
+                auto n = top;
+                while (n) {
+                        fn(*n);
+                        if (n->first_child) {
+                                n = n->first_child;
+                                continue;
+                        }
+                        while (n != top && !n->next_sibling) n = n->parent;
+                        n = n == top ? nullptr : n->next_sibling;
+                }
+        }
+
+private:
+        node* root_m = nullptr;
+        size_t size_m = 0;
+};
+
+} // namespace bench
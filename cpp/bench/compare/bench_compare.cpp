@@ -0,0 +1,254 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "counting_new.h"
+#include "children_tree.h"
+#include "pointer_tree.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/tree_shapes.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Compares drift_tree with a parent/child pointer tree and a children vector tree
+ * - build: from a level stream, each tree with its own append operation
+ * - dfs: pre order visit of all nodes
+ * - subtree: pre order of 64 subtrees rooted at evenly spaced nodes
+ * - insert_front/middle/back: 64 first children added to the node at that position
+ * - erase_front/middle/back: the 64 added leaves removed again
+ * - memory: bytes allocated per node after the build
+ *
+ * Shapes from tree_shapes.h: random (depth <= 64), deep (mostly chains),
+ * wide (one root with n-1 leaves), binary (complete binary tree), dom and filesystem.
+ * Edit rows count one op per edit, so ns_per_op is the time of one insert or erase,
+ * the other rows count one op per node.
+ * bytes_per_node counts requested heap bytes, without the overhead of malloc.
+ *
+ * usage: bench_compare [nodes...]
+ * sizes from 10^3 to 10^8 are supported, the default stops at 10^6
+ */
+
+namespace {
+
+using data_t = uint32_t;
+using drift_tree_t = vt::drift_tree<data_t>;
+using pointer_tree_t = bench::pointer_tree<data_t>;
+using children_tree_t = bench::children_tree<data_t>;
+
+const size_t edits = 64;
+
+// levels of the nodes in pre order, the first node is the root
+using levels_t = std::vector<uint32_t>;
+
+template<typename shape_t>
+levels_t levels_of(shape_t shape, size_t nodes) {
+    levels_t levels(nodes);
+    vt::generate_levels(shape, nodes, levels.begin());
+    return levels;
+}
+
+template<typename Fn>
+double
+bytes_per_node(size_t nodes, Fn build) {
+    auto before = bench::allocated_bytes().load();
+    build();
+    return double(bench::allocated_bytes().load() - before) / double(nodes);
+}
+
+// best of three rounds of inserting and erasing edits nodes below position
+template<typename Insert, typename Erase>
+void
+run_edits(const char* variant, const char* shape, const char* where, size_t nodes, double bytes, Insert insert,
+          Erase erase) {
+    double best_insert = 1e300, best_erase = 1e300;
+    for (int r = 0; r < 3; ++r) {
+        best_insert = std::min(best_insert, bench::measure([&] { for (size_t k = 0; k < edits; ++k) insert(); }, 1));
+        best_erase = std::min(best_erase, bench::measure([&] { for (size_t k = 0; k < edits; ++k) erase(); }, 1));
+    }
+    std::string name = std::string("insert_") + where;
+    bench::report(name.c_str(), variant, shape, nodes, edits, best_insert, bytes);
+    name = std::string("erase_") + where;
+    bench::report(name.c_str(), variant, shape, nodes, edits, best_erase, bytes);
+}
+
+const char* const positions[] = {"front", "middle", "back"};
+
+size_t position(size_t nodes, int where) {
+    return where == 0 ? std::min<size_t>(1, nodes - 1) : where == 1 ? nodes / 2 : nodes - 1;
+}
+
+void
+run_drift_tree(const char* shape, const levels_t& levels) {
+    auto nodes = levels.size();
+    const char* variant = "drift_tree";
+    drift_tree_t tree;
+    auto build_tree = [&] {
+        tree.clear();
+        tree.reserve(nodes);
+        tree.push_root(0);
+        for (size_t i = 1; i < nodes; ++i) tree.emplace_back_drifted(1 + levels[i - 1] - levels[i], data_t(i));
+    };
+    auto build = bench::measure(build_tree, 3);
+    tree = drift_tree_t();
+    auto bytes = bytes_per_node(nodes, build_tree);
+    bench::report("build", variant, shape, nodes, build, bytes);
+    bench::report("memory", variant, shape, nodes, 0, bytes);
+
+    auto dfs = bench::measure([&] {
+        uint64_t sum = 0;
+        for (const auto& node : tree) sum += node.data;
+        bench::keep(sum);
+    });
+    bench::report("dfs", variant, shape, nodes, dfs, bytes);
+
+    auto subtree = bench::measure([&] {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < 64; ++k) {
+            vt::subtree<drift_tree_t> st(tree.begin() + nodes * k / 64);
+            for (const auto& node : st) sum += node.data;
+        }
+        bench::keep(sum);
+    });
+    bench::report("subtree", variant, shape, nodes, subtree, bytes);
+
+    for (int where = 0; where < 3; ++where) {
+        auto pos = position(nodes, where);
+        run_edits(variant, shape, positions[where], nodes, bytes,
+                  [&] { tree.insert_first_child(tree.begin() + pos, data_t(0)); },
+                  [&] { tree.erase_leaf(tree.begin() + pos + 1); });
+    }
+}
+
+void
+run_pointer_tree(const char* shape, const levels_t& levels) {
+    auto nodes = levels.size();
+    const char* variant = "pointer_tree";
+    pointer_tree_t tree;
+    std::vector<pointer_tree_t::node*> path;
+    auto build_tree = [&] {
+        tree.clear();
+        path.clear();
+        for (size_t i = 0; i < nodes; ++i) {
+            path.resize(levels[i]);
+            path.push_back(tree.add(levels[i] ? path[levels[i] - 1] : nullptr, data_t(i)));
+        }
+    };
+    auto build = bench::measure(build_tree, 3);
+    tree.clear();
+    path.shrink_to_fit();
+    auto bytes = bytes_per_node(nodes, build_tree);
+    bench::report("build", variant, shape, nodes, build, bytes);
+    bench::report("memory", variant, shape, nodes, 0, bytes);
+
+    auto dfs = bench::measure([&] {
+        uint64_t sum = 0;
+        tree.pre_order([&](const pointer_tree_t::node& n) { sum += n.data; });
+        bench::keep(sum);
+    });
+    bench::report("dfs", variant, shape, nodes, dfs, bytes);
+
+    // nodes by pre order position, collected untimed
+    std::vector<pointer_tree_t::node*> order;
+    order.reserve(nodes);
+    tree.pre_order([&](const pointer_tree_t::node& n) { order.push_back(const_cast<pointer_tree_t::node*>(&n)); });
+    auto subtree = bench::measure([&] {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < 64; ++k)
+            tree.pre_order(order[nodes * k / 64], [&](const pointer_tree_t::node& n) { sum += n.data; });
+        bench::keep(sum);
+    });
+    bench::report("subtree", variant, shape, nodes, subtree, bytes);
+
+    for (int where = 0; where < 3; ++where) {
+        auto parent = order[position(nodes, where)];
+        run_edits(variant, shape, positions[where], nodes, bytes,
+                  [&] { tree.add_first(parent, data_t(0)); },
+                  [&] { tree.erase_leaf(parent->first_child); });
+    }
+}
+
+void
+run_children_tree(const char* shape, const levels_t& levels) {
+    auto nodes = levels.size();
+    const char* variant = "children_tree";
+    children_tree_t tree;
+    std::vector<children_tree_t::index_t> path;
+    auto build_tree = [&] {
+        tree.clear();
+        tree.reserve(nodes);
+        path.clear();
+        for (size_t i = 0; i < nodes; ++i) {
+            path.resize(levels[i]);
+            path.push_back(tree.add(levels[i] ? path[levels[i] - 1] : children_tree_t::npos, data_t(i)));
+        }
+    };
+    auto build = bench::measure(build_tree, 3);
+    tree = children_tree_t();
+    auto bytes = bytes_per_node(nodes, build_tree);
+    bench::report("build", variant, shape, nodes, build, bytes);
+    bench::report("memory", variant, shape, nodes, 0, bytes);
+
+    auto dfs = bench::measure([&] {
+        uint64_t sum = 0;
+        tree.pre_order([&](const children_tree_t::node& n) { sum += n.data; });
+        bench::keep(sum);
+    });
+    bench::report("dfs", variant, shape, nodes, dfs, bytes);
+
+    std::vector<children_tree_t::index_t> order;
+    order.reserve(nodes);
+    tree.pre_order([&](const children_tree_t::node& n) { order.push_back(children_tree_t::index_t(&n - &tree[0])); });
+    auto subtree = bench::measure([&] {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < 64; ++k)
+            tree.pre_order(order[nodes * k / 64], [&](const children_tree_t::node& n) { sum += n.data; });
+        bench::keep(sum);
+    });
+    bench::report("subtree", variant, shape, nodes, subtree, bytes);
+
+    for (int where = 0; where < 3; ++where) {
+        auto parent = order[position(nodes, where)];
+        run_edits(variant, shape, positions[where], nodes, bytes,
+                  [&] { tree.add_first(parent, data_t(0)); },
+                  [&] { tree.erase_leaf(tree[parent].children.front()); });
+    }
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_shaped_header();
+    for (auto nodes : bench::sizes(argc, argv, {1000, 10000, 100000, 1000000})) {
+        std::pair<const char*, levels_t> shapes[] = {
+            {"random", levels_of(vt::random_shape(64, 42), nodes)},
+            {"deep", levels_of(vt::branching_shape(0.90, 0.08, 0.5, size_t(-1), 42), nodes)},
+            {"wide", levels_of(vt::kary_shape(nodes, nodes), nodes)},
+            {"binary", levels_of(vt::kary_shape(2, nodes), nodes)},
+            {"dom", levels_of(vt::dom_shape(42), nodes)},
+            {"filesystem", levels_of(vt::filesystem_shape(42), nodes)}};
+        for (auto& shape : shapes) {
+            run_drift_tree(shape.first, shape.second);
+            run_pointer_tree(shape.first, shape.second);
+            run_children_tree(shape.first, shape.second);
+        }
+    }
+}
@@ -0,0 +1,328 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "complexity.h"
+
+#include "vector_tree/double_ended_vector.h"
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/tree_shapes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Checks the documented complexity of the drift_tree operations
+ *
+ * Every operation runs in batches on copies of random trees of growing size,
+ * at the front, middle and back of the tree where the position matters.
+ * The exponent of the fitted power law is compared with the documentation:
+ * - constant: O(1), exponent 0
+ * - linear:   O(n) in the tree size, exponent 1
+ * - behind:   O(n) in the nodes behind the position, exponent 1 except at the back
+ * - shorter:  O(n) in the nodes on the shorter side of the position (double_ended_vector),
+ *             exponent 1 in the middle only
+ *
+ * Measurements slower than a stored baseline beyond the tolerance are flagged too.
+ * Each measurement is the best of several runs, raise --repeat on noisy machines.
+ * The exit code is 1 if anything was flagged.
+ *
+ * usage: bench_complexity [--json] [--baseline earlier.csv] [--exponent-tolerance 0.35]
+ *                         [--regression-tolerance 0.25] [--max-nodes 1048576] [--repeat 11]
+ *
+ * The csv output of a run is a valid baseline for later runs.
+ */
+
+namespace {
+
+enum class complexity { constant, linear, behind, shorter };
+
+const char* documented(complexity c) {
+    switch (c) {
+    case complexity::constant: return "O(1)";
+    case complexity::linear: return "O(n)";
+    case complexity::behind: return "O(n behind)";
+    default: return "O(n shorter)";
+    }
+}
+
+struct position {
+    const char* name;
+    double fraction;
+};
+
+const position front{"front", 0.0};
+const position middle{"middle", 0.5};
+const position back{"back", 1.0};
+
+double expected_exponent(complexity c, const position& where) {
+    switch (c) {
+    case complexity::constant: return 0;
+    case complexity::linear: return 1;
+    case complexity::behind: return where.fraction < 1 ? 1 : 0;
+    default: return 0 < where.fraction && where.fraction < 1 ? 1 : 0;
+    }
+}
+
+struct options {
+    bool json = false;
+    const char* baseline_path = nullptr;
+    double exponent_tolerance = 0.35;
+    double regression_tolerance = 0.25;
+    size_t max_nodes = size_t(1) << 20;
+    int repeat = 11;
+};
+
+struct measurement {
+    std::string benchmark, variant, position;
+    size_t nodes;
+    size_t ops;
+    double seconds;
+    double ns_per_op;
+    double baseline_ns_per_op;
+    const char* status;
+};
+
+struct fit {
+    std::string benchmark, variant, position;
+    const char* documented;
+    double expected;
+    double exponent;
+    const char* status;
+};
+
+struct report_t {
+    std::vector<measurement> measurements;
+    std::vector<fit> fits;
+    bool flagged = false;
+};
+
+// headroom at both ends, so the timed batch does not include a reallocation
+template<typename tree_t>
+auto reserve_ends(tree_t& tree, size_t extra, int)
+    -> decltype(std::declval<typename tree_t::vector_t&>().reserve_front(0), void()) {
+    tree.reserve_front(tree.size() + extra);
+    tree.reserve(tree.size() + extra);
+}
+template<typename tree_t>
+void reserve_ends(tree_t& tree, size_t extra, long) {
+    tree.reserve(tree.size() + extra);
+}
+
+// constant operations need long batches to rise above the timer resolution,
+// linear ones are kept at about the same amount of work for each size
+// HINT: edits near an end shift the nodes of the batch, so their batch has a fixed length
+size_t batch_for(complexity c, double exponent, size_t nodes) {
+    if (c == complexity::constant) return 4096;
+    if (exponent == 0) return 64;
+    return std::max<size_t>(16, std::min<size_t>(nodes / 16, (size_t(1) << 24) / nodes));
+}
+
+template<typename tree_t>
+struct sweep {
+    const char* variant;
+    const options& opts;
+    const bench::baseline& baseline;
+    report_t& report;
+    std::vector<std::pair<size_t, tree_t>> trees;
+
+    sweep(const char* variant, const options& opts, const bench::baseline& baseline, report_t& report)
+        : variant(variant), opts(opts), baseline(baseline), report(report) {
+        for (size_t nodes = 1024; nodes <= opts.max_nodes; nodes *= 4) {
+            trees.emplace_back(nodes, tree_t());
+            auto shape = vt::random_shape(64, 42);
+            vt::generate_tree(trees.back().second, shape, nodes, [](size_t i, size_t) { return uint32_t(i); });
+        }
+    }
+
+    // prepare(tree, pos, batch) runs untimed on a fresh copy, op(tree, pos, k) is timed for k < batch
+    template<typename Prepare, typename Op>
+    void run(const char* benchmark, complexity c, std::initializer_list<position> positions,
+             Prepare prepare, Op op) {
+        for (const auto& where : positions) {
+            std::vector<bench::sample> samples;
+            for (const auto& entry : trees) {
+                auto nodes = entry.first;
+                auto batch = batch_for(c, expected_exponent(c, where), nodes);
+                auto pos = size_t(where.fraction * double(nodes - 1));
+                tree_t tree;
+                auto seconds = bench::measure_prepared([&] {
+                    tree = entry.second;
+                    reserve_ends(tree, 16 * batch, 0);
+                    prepare(tree, pos, batch);
+                }, [&] {
+                    for (size_t k = 0; k < batch; ++k) op(tree, pos, k);
+                    bench::keep(tree);
+                }, opts.repeat);
+                auto ns = seconds * 1e9 / double(batch);
+                samples.push_back({nodes, ns});
+                add_measurement(benchmark, where.name, nodes, batch, seconds, ns);
+            }
+            add_fit(benchmark, c, where, bench::fit_exponent(samples));
+        }
+    }
+
+    void add_measurement(const char* benchmark, const char* where, size_t nodes, size_t ops, double seconds,
+                         double ns) {
+        auto base = baseline.find(benchmark, variant, where, nodes);
+        auto status = "ok";
+        if (base <= 0) status = baseline.empty() ? "ok" : "new";
+        else if (ns > base * (1 + opts.regression_tolerance)) status = "regression";
+        if (std::strcmp(status, "regression") == 0) report.flagged = true;
+        report.measurements.push_back({benchmark, variant, where, nodes, ops, seconds, ns, base, status});
+    }
+
+    void add_fit(const char* benchmark, complexity c, const position& where, double exponent) {
+        auto expected = expected_exponent(c, where);
+        auto deviates = std::fabs(exponent - expected) > opts.exponent_tolerance;
+        if (deviates) report.flagged = true;
+        report.fits.push_back({benchmark, variant, where.name, documented(c), expected, exponent,
+                               deviates ? "deviation" : "ok"});
+    }
+};
+
+template<typename tree_t>
+void
+run(const char* variant, complexity push_root, complexity edit, const options& opts,
+    const bench::baseline& baseline, report_t& report) {
+    sweep<tree_t> s(variant, opts, baseline, report);
+    auto none = [](tree_t&, size_t, size_t) {};
+    // a chain of 8 nodes for the subtree operations
+    tree_t sub;
+    sub.push_root(0u);
+    for (size_t k = 1; k < 8; ++k) sub.push_back_child(0u);
+
+    s.run("push_back_child", complexity::constant, {back}, none,
+          [](tree_t& tree, size_t, size_t) { tree.push_back_child(0u); });
+    s.run("push_back_level", complexity::constant, {back}, none,
+          [](tree_t& tree, size_t, size_t) { tree.push_back_level(0u, 1); });
+    s.run("pop_back", complexity::constant, {back}, [](tree_t& tree, size_t, size_t batch) {
+        for (size_t k = 0; k < batch; ++k) tree.push_back_child(0u);
+    }, [](tree_t& tree, size_t, size_t) { tree.pop_back(); });
+    s.run("push_root", push_root, {front}, none,
+          [](tree_t& tree, size_t, size_t) { tree.push_root(0u); });
+    s.run("insert_first_child", edit, {front, middle, back}, none,
+          [](tree_t& tree, size_t pos, size_t) { tree.insert_first_child(tree.begin() + pos, 0u); });
+    s.run("insert_sibling", edit, {front, middle, back}, none, [](tree_t& tree, size_t pos, size_t) {
+        tree.insert_sibling(tree.begin() + std::max<size_t>(1, pos), 0u);
+    });
+    s.run("erase_leaf", edit, {front, middle, back}, [](tree_t& tree, size_t pos, size_t batch) {
+        for (size_t k = 0; k < batch; ++k) tree.insert_first_child(tree.begin() + pos, 0u);
+    }, [](tree_t& tree, size_t pos, size_t) { tree.erase_leaf(tree.begin() + pos + 1); });
+    s.run("insert_child_tree", edit, {front, middle, back}, none, [&](tree_t& tree, size_t pos, size_t) {
+        tree.insert_child_tree(tree.begin() + pos, sub.begin(), sub.end());
+    });
+    // erase_subtree keeps the root, each call empties the next chain
+    s.run("erase_subtree", edit, {front, middle, back}, [&](tree_t& tree, size_t pos, size_t batch) {
+        for (size_t k = 0; k < batch; ++k) tree.insert_child_tree(tree.begin() + pos, sub.begin(), sub.end());
+    }, [](tree_t& tree, size_t pos, size_t k) {
+        tree.erase_subtree(vt::subtree<tree_t>(tree.begin() + pos + 1 + k));
+    });
+    // the subtree of the root covers the tree
+    s.run("find_subtree_end", complexity::linear, {front}, none, [](tree_t& tree, size_t pos, size_t) {
+        bench::keep(vt::find_subtree_end(tree.begin() + pos));
+    });
+}
+
+options
+parse(int argc, char** argv) {
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = std::string(argv[i]);
+        auto value = [&] {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "missing value for %s\n", argv[i]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--json") opts.json = true;
+        else if (arg == "--baseline") opts.baseline_path = value();
+        else if (arg == "--exponent-tolerance") opts.exponent_tolerance = std::strtod(value(), nullptr);
+        else if (arg == "--regression-tolerance") opts.regression_tolerance = std::strtod(value(), nullptr);
+        else if (arg == "--max-nodes") opts.max_nodes = std::strtoull(value(), nullptr, 10);
+        else if (arg == "--repeat") opts.repeat = std::max(1, std::atoi(value()));
+        else {
+            std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+            std::exit(2);
+        }
+    }
+    return opts;
+}
+
+void
+print_csv(const report_t& report) {
+    std::printf("benchmark,variant,position,nodes,ops,seconds,ns_per_op,baseline_ns_per_op,status\n");
+    for (const auto& m : report.measurements)
+        std::printf("%s,%s,%s,%zu,%zu,%.9f,%.3f,%.3f,%s\n", m.benchmark.c_str(), m.variant.c_str(),
+                    m.position.c_str(), m.nodes, m.ops, m.seconds, m.ns_per_op, m.baseline_ns_per_op, m.status);
+    // the fits go to stderr, so that stdout stays a baseline for the next run
+    for (const auto& f : report.fits)
+        std::fprintf(stderr, "%-20s %-13s %-7s %-12s exponent %5.2f expected %4.2f %s\n", f.benchmark.c_str(),
+                     f.variant.c_str(), f.position.c_str(), f.documented, f.exponent, f.expected, f.status);
+}
+
+void
+print_json(const report_t& report) {
+    std::printf("{\n  \"measurements\": [");
+    auto first = true;
+    for (const auto& m : report.measurements) {
+        std::printf("%s\n    {\"benchmark\": \"%s\", \"variant\": \"%s\", \"position\": \"%s\", \"nodes\": %zu, "
+                    "\"ops\": %zu, \"seconds\": %.9f, \"ns_per_op\": %.3f, \"baseline_ns_per_op\": %.3f, "
+                    "\"status\": \"%s\"}", first ? "" : ",", m.benchmark.c_str(), m.variant.c_str(),
+                    m.position.c_str(), m.nodes, m.ops, m.seconds, m.ns_per_op, m.baseline_ns_per_op, m.status);
+        first = false;
+    }
+    std::printf("\n  ],\n  \"fits\": [");
+    first = true;
+    for (const auto& f : report.fits) {
+        std::printf("%s\n    {\"benchmark\": \"%s\", \"variant\": \"%s\", \"position\": \"%s\", "
+                    "\"documented\": \"%s\", \"expected\": %.2f, \"exponent\": %.3f, \"status\": \"%s\"}",
+                    first ? "" : ",", f.benchmark.c_str(), f.variant.c_str(), f.position.c_str(), f.documented,
+                    f.expected, f.exponent, f.status);
+        first = false;
+    }
+    std::printf("\n  ],\n  \"flagged\": %s\n}\n", report.flagged ? "true" : "false");
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    auto opts = parse(argc, argv);
+    bench::baseline baseline;
+    if (opts.baseline_path && !baseline.load(opts.baseline_path)) {
+        std::fprintf(stderr, "cannot read baseline %s\n", opts.baseline_path);
+        return 2;
+    }
+    report_t report;
+    run<vt::drift_tree<uint32_t>>("std_vector", complexity::linear, complexity::behind, opts, baseline, report);
+    run<vt::double_ended_drift_tree<uint32_t>>("double_ended", complexity::constant, complexity::shorter, opts,
+                                               baseline, report);
+    if (opts.json) print_json(report);
+    else print_csv(report);
+    return report.flagged ? 1 : 0;
+}
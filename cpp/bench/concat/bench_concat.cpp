@@ -0,0 +1,97 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/parallel_builder.h"
+#include "vector_tree/relocatable_vector.h"
+
+#include <cstdio>
+#include <thread>
+
+/*
+ * Scaling of parallel_builder::concat with the thread count
+ * - concat: joins 64 random fragments with 1, 2, 4, ... threads up to the hardware concurrency
+ *   vector: std::vector storage, value initialized on one thread before the threads move the nodes
+ *   relocating: relocatable_vector storage, the threads construct the nodes in place
+ * - value_init: resize of an empty tree to the same size, the part of concat that runs on one thread
+ *
+ * usage: bench_concat [nodes...]
+ */
+
+namespace {
+
+using tree_t = vt::drift_tree<uint32_t>;
+using relocating_tree_t = vt::relocating_drift_tree<uint32_t>;
+
+const size_t fragments = 64;
+const size_t max_level = 64;
+
+template<typename builder_t>
+void
+fill(builder_t& builder, size_t nodes) {
+    for (size_t k = 0; k < fragments; ++k) {
+        auto first = nodes * k / fragments;
+        auto last = nodes * (k + 1) / fragments;
+        bench::random_tree(builder.fragment(k), last - first, max_level, 42 + k,
+                           [first](size_t i) { return uint32_t(first + i); });
+    }
+}
+
+template<typename tree_t>
+void
+run_concat(const char* storage, size_t nodes) {
+    auto bytes = double(sizeof(typename tree_t::node_t));
+    vt::parallel_builder<tree_t> builder(fragments);
+    auto max_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t threads = 1;; threads = std::min(2 * threads, max_threads)) {
+        tree_t result;
+        auto concat = bench::measure_prepared([&] {
+            result = tree_t();
+            fill(builder, nodes);
+        }, [&] {
+            result = builder.concat(threads);
+            bench::keep(result);
+        }, 3);
+        char variant[48];
+        std::snprintf(variant, sizeof(variant), "%s/threads_%zu", storage, threads);
+        bench::report("concat", variant, nodes, concat, bytes);
+        if (threads == max_threads) break;
+    }
+}
+
+void
+run(size_t nodes) {
+    auto init = bench::measure([&] {
+        tree_t tree;
+        tree.resize(nodes);
+        bench::keep(tree);
+    }, 3);
+    bench::report("value_init", "resize", nodes, init, double(sizeof(tree_t::node_t)));
+
+    run_concat<tree_t>("vector", nodes);
+    run_concat<relocating_tree_t>("relocating", nodes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {1000000, 10000000, 50000000})) run(nodes);
+}
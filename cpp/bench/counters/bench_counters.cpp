@@ -0,0 +1,146 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "perf_counters.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/node_layout.h"
+#include "vector_tree/tree_shapes.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Hardware counters per node for the traversal and edit kernels
+ * - generate: generate_tree into presized storage
+ * - push_back: the same tree appended with push_back_child and push_back_level
+ * - scan: depth first iteration with level tracking over the subtree of the root
+ * - erase_subtree: the descendants of the largest child of the root, the nodes behind them move up
+ *
+ * Variants compare drift types (uint32_t payload), payload sizes (uint32_t drifts)
+ * and node layouts of a payload {uint32_t id; uint32_t spare; uint64_t key;}.
+ *
+ * Columns of events the machine does not count stay empty, ex. in virtual machines.
+ *
+ * usage: bench_counters [nodes...]
+ */
+
+namespace {
+
+const size_t max_level = 64;
+
+// payload of a given size
+template<size_t bytes>
+struct blob {
+    blob() = default;
+    blob(size_t i) { words[0] = uint32_t(i); }
+
+    uint32_t words[bytes / 4];
+};
+
+// one payload type per layout, the layout is selected by the payload
+template<int variant>
+struct item {
+    item() = default;
+    item(size_t i) : id(uint32_t(i)), key(i * 7) {}
+
+    uint32_t id;
+    uint32_t spare; // padding in the default layout
+    uint64_t key;
+};
+
+enum { DEFAULT, PACKED, FIELD };
+
+} // namespace
+
+namespace vt {
+template<typename drift_t>
+struct node_layout<item<PACKED>, drift_t> { using type = packed_drift_node<item<PACKED>, uint32_t>; };
+template<typename drift_t>
+struct node_layout<item<FIELD>, drift_t> { using type = field_drift_node<item<FIELD>, uint32_t, &item<FIELD>::spare>; };
+} // namespace vt
+
+namespace {
+
+template<typename tree_t>
+void
+run(bench::perf_counters& counters, const char* variant, size_t nodes) {
+    using data_t = typename tree_t::data_t;
+    auto bytes = double(sizeof(typename tree_t::node_t));
+
+    tree_t tree;
+    auto generate = bench::measure_counted(counters, [&] {
+        auto shape = vt::random_shape(max_level, 42);
+        vt::generate_tree(tree, shape, nodes, [](size_t i, size_t) { return data_t(i); });
+        bench::keep(tree);
+    }, 3);
+    bench::report("generate", variant, nodes, generate, bytes);
+
+    auto push_back = bench::measure_counted(counters, [&] {
+        bench::random_tree(tree, nodes, max_level, 42, [](size_t i) { return data_t(i); });
+        bench::keep(tree);
+    }, 3);
+    bench::report("push_back", variant, nodes, push_back, bytes);
+
+    auto scan = bench::measure_counted(counters, [&] {
+        vt::subtree<tree_t> st(tree.begin());
+        size_t sum = 0;
+        for (auto it = st.begin(); it != st.end(); ++it) sum += it.level();
+        bench::keep(sum);
+    });
+    bench::report("scan", variant, nodes, scan, bytes);
+
+    size_t largest = 1, largest_size = 0;
+    for (auto it = tree.begin() + 1; it != tree.end();) {
+        auto end = vt::find_subtree_end(it);
+        if (size_t(end - it) > largest_size) {
+            largest = size_t(it - tree.begin());
+            largest_size = size_t(end - it);
+        }
+        it = end;
+    }
+    tree_t work;
+    auto erase = bench::measure_counted_prepared(counters, [&] { work = tree; }, [&] {
+        work.erase_subtree(vt::subtree<tree_t>(work.begin() + largest));
+        bench::keep(work);
+    }, 3);
+    bench::report("erase_subtree", variant, nodes, erase, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::perf_counters counters;
+    if (!counters.available(bench::perf_counters::cycles))
+        std::fprintf(stderr, "hardware counters are not available, only wall times and software events are reported\n");
+    bench::print_counter_header();
+    for (auto nodes : bench::sizes(argc, argv, {100000, 1000000, 10000000})) {
+        run<vt::drift_tree<uint32_t, uint8_t>>(counters, "drift8", nodes);
+        run<vt::drift_tree<uint32_t, uint16_t>>(counters, "drift16", nodes);
+        run<vt::drift_tree<uint32_t, uint32_t>>(counters, "drift32", nodes);
+        run<vt::drift_tree<uint32_t, uint64_t>>(counters, "drift64", nodes);
+        run<vt::drift_tree<blob<16>, uint32_t>>(counters, "payload16", nodes);
+        run<vt::drift_tree<blob<64>, uint32_t>>(counters, "payload64", nodes);
+        run<vt::drift_tree<item<DEFAULT>>>(counters, "layout_default", nodes);
+        run<vt::drift_tree<item<PACKED>>>(counters, "layout_packed", nodes);
+        run<vt::drift_tree<item<FIELD>>>(counters, "layout_field", nodes);
+    }
+}
@@ -0,0 +1,82 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/widening_drift_tree.h"
+
+/*
+ * Compares drift types for the same tree shape
+ * - bytes per node of the vector
+ * - build time with push_back_*
+ * - full depth first scan with level tracking
+ *
+ * usage: bench_drift_width [nodes...]
+ */
+
+namespace {
+
+// deep enough to stress the drifts, small enough for 8 bit drifts
+const size_t max_level = 200;
+
+template<typename drift_t>
+void
+run(const char* variant, size_t nodes) {
+    using tree_t = vt::drift_tree<uint16_t, drift_t>;
+    auto bytes = double(sizeof(typename tree_t::node_t));
+
+    tree_t tree;
+    auto build = bench::measure([&] {
+        bench::random_tree(tree, nodes, max_level, 42, [](size_t i) { return uint16_t(i); });
+    }, 3);
+    bench::report("build", variant, nodes, build, bytes);
+
+    auto scan = bench::measure([&] {
+        vt::subtree<tree_t> st(tree.begin());
+        size_t sum = 0;
+        for (auto it = st.begin(); it != st.end(); ++it) sum += it.level();
+        bench::keep(sum);
+    });
+    bench::report("scan", variant, nodes, scan, bytes);
+}
+
+void
+run_widening(size_t nodes) {
+    vt::widening_drift_tree<uint16_t> tree;
+    auto build = bench::measure([&] {
+        tree.clear();
+        bench::random_tree(tree, nodes, max_level, 42, [](size_t i) { return uint16_t(i); });
+    }, 3);
+    auto bytes = tree.visit([](const auto& t) { return double(sizeof(*t.begin())); });
+    bench::report("build", "widening", nodes, build, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {100000, 1000000, 10000000})) {
+        run<uint8_t>("uint8", nodes);
+        run<uint16_t>("uint16", nodes);
+        run<uint32_t>("uint32", nodes);
+        run<uint64_t>("uint64", nodes);
+        run_widening(nodes);
+    }
+}
@@ -0,0 +1,187 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/eval_reverse.h"
+#include "vector_tree/subtree_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * Evaluates random binary expression trees for many rows of inputs
+ * - pointer_recursive: a pointer AST, evaluated recursively per row
+ * - drift_recursive: the drift_tree, evaluated recursively per row, siblings found by subtree_index
+ * - eval_reverse: the drift_tree with reverse_evaluator per row
+ * - batch8: the drift_tree with batch_evaluator, eight rows in the lanes
+ *
+ * The operators keep the values in [-1, 1]: average, half difference, product and maximum.
+ * Leaves are one of eight inputs or a constant.
+ * Times are per row, ns_per_node is the time per node and row.
+ *
+ * usage: bench_eval [nodes...]
+ */
+
+namespace {
+
+const size_t rows = 1 << 14;
+const size_t inputs = 8;
+const size_t width = 8;
+
+enum op_t : uint8_t { AVG, HALF_DIFF, MUL, MAX, INPUT, CONSTANT };
+
+struct expr {
+    op_t op;
+    uint8_t input;
+    float value;
+};
+
+inline float
+apply(op_t op, float a, float b) {
+    switch (op) {
+    case AVG: return 0.5f * (a + b);
+    case HALF_DIFF: return 0.5f * (a - b);
+    case MUL: return a * b;
+    default: return std::max(a, b);
+    }
+}
+
+// inputs[input][row], padded to whole batches
+using columns_t = std::vector<std::vector<float>>;
+
+struct pointer_expr {
+    expr e;
+    std::unique_ptr<pointer_expr> left, right;
+};
+
+float
+eval_pointer(const pointer_expr& n, const columns_t& columns, size_t row) {
+    switch (n.e.op) {
+    case INPUT: return columns[n.e.input][row];
+    case CONSTANT: return n.e.value;
+    default: return apply(n.e.op, eval_pointer(*n.left, columns, row), eval_pointer(*n.right, columns, row));
+    }
+}
+
+using tree_t = vt::drift_tree<expr, uint32_t>;
+
+float
+eval_drift(const tree_t& tree, const vt::subtree_index<tree_t>& index, size_t pos, const columns_t& columns,
+           size_t row) {
+    const auto& e = tree[pos].data;
+    switch (e.op) {
+    case INPUT: return columns[e.input][row];
+    case CONSTANT: return e.value;
+    default: return apply(e.op, eval_drift(tree, index, pos + 1, columns, row),
+                          eval_drift(tree, index, index.end(pos + 1), columns, row));
+    }
+}
+
+// a random binary expression with nodes (odd) nodes, appended in pre order
+std::unique_ptr<pointer_expr>
+make_expr(size_t nodes, bench::xorshift& random, tree_t& tree, size_t level) {
+    std::unique_ptr<pointer_expr> n(new pointer_expr);
+    if (1 == nodes) {
+        n->e = random.below(4) ? expr{INPUT, uint8_t(random.below(inputs)), 0}
+                               : expr{CONSTANT, 0, float(random.below(200)) / 100 - 1};
+    }
+    else n->e = expr{op_t(random.below(4)), 0, 0};
+
+    tree.push_at_level(n->e, level);
+
+    if (1 < nodes) {
+        auto left = 1 + 2 * random.below((nodes - 1) / 2);
+        n->left = make_expr(left, random, tree, level + 1);
+        n->right = make_expr(nodes - 1 - left, random, tree, level + 1);
+    }
+    return n;
+}
+
+void
+run(size_t nodes) {
+    nodes |= 1;
+    bench::xorshift random(42);
+    tree_t tree;
+    auto root = make_expr(nodes, random, tree, 0);
+    vt::subtree_index<tree_t> index(tree);
+
+    columns_t columns(inputs, std::vector<float>(rows + width));
+    for (auto& column : columns)
+        for (size_t row = 0; row < rows; ++row) column[row] = float(random.below(2000)) / 1000 - 1;
+    std::vector<float> results(rows);
+    auto bytes = double(sizeof(tree_t::node_t));
+
+    auto pointer = bench::measure([&] {
+        for (size_t row = 0; row < rows; ++row) results[row] = eval_pointer(*root, columns, row);
+        bench::keep(results);
+    });
+    bench::report("eval", "pointer_recursive", nodes, pointer / rows, double(sizeof(pointer_expr)));
+    auto expected = results;
+
+    auto drift = bench::measure([&] {
+        for (size_t row = 0; row < rows; ++row) results[row] = eval_drift(tree, index, 0, columns, row);
+        bench::keep(results);
+    });
+    bench::report("eval", "drift_recursive", nodes, drift / rows, bytes);
+
+    vt::reverse_evaluator<float> eval;
+    size_t row = 0;
+    auto op = [&](const expr& e, const float* args, size_t) {
+        switch (e.op) {
+        case INPUT: return columns[e.input][row];
+        case CONSTANT: return e.value;
+        default: return apply(e.op, args[0], args[1]);
+        }
+    };
+    auto reverse = bench::measure([&] {
+        for (row = 0; row < rows; ++row) results[row] = eval(tree, op);
+        bench::keep(results);
+    });
+    bench::report("eval", "eval_reverse", nodes, reverse / rows, bytes);
+
+    using lanes_t = vt::value_lanes<float, width>;
+    vt::batch_evaluator<float, width> batch;
+    auto batch_op = [&](const expr& e, const lanes_t* args, size_t, lanes_t& out, vt::lane_rows r) {
+        switch (e.op) {
+        case INPUT: std::copy(&columns[e.input][r.first], &columns[e.input][r.first] + width, out.lane); break;
+        case CONSTANT: std::fill(out.lane, out.lane + width, e.value); break;
+        case AVG: for (size_t k = 0; k < width; ++k) out[k] = 0.5f * (args[0][k] + args[1][k]); break;
+        case HALF_DIFF: for (size_t k = 0; k < width; ++k) out[k] = 0.5f * (args[0][k] - args[1][k]); break;
+        case MUL: for (size_t k = 0; k < width; ++k) out[k] = args[0][k] * args[1][k]; break;
+        default: for (size_t k = 0; k < width; ++k) out[k] = std::max(args[0][k], args[1][k]); break;
+        }
+    };
+    auto batched = bench::measure([&] {
+        batch(tree, rows, results.data(), batch_op);
+        bench::keep(results);
+    });
+    bench::report("eval", "batch8", nodes, batched / rows, bytes);
+    if (results != expected) std::fprintf(stderr, "batch8 results differ for %zu nodes\n", nodes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {15, 255, 4095})) run(nodes);
+}
@@ -0,0 +1,105 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/instrumentation.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Cost of the instrumentation policies
+ * - push_back: build of a random tree
+ * - insert_erase: insert_first_child and erase_leaf below the root
+ *
+ * Variants: none (default policy), counting, latency (counting with histograms).
+ * The counters of the last run are printed to stderr.
+ *
+ * usage: bench_instrumentation [nodes...]
+ */
+
+namespace {
+
+template<typename instrument_t>
+using tree_for_t = vt::drift_tree<uint32_t, uint32_t, std::allocator<vt::drift_node<uint32_t, uint32_t>>,
+                                  std::vector<vt::drift_node<uint32_t, uint32_t>>, instrument_t>;
+
+template<typename snapshot_t>
+void
+print_stats(const char* variant, const snapshot_t& stats) {
+    stats.for_each([&](const char* name, const vt::operation_stats& op) {
+        if (op.calls)
+            std::fprintf(stderr, "%s %s calls=%llu moved_nodes=%llu moved_bytes=%llu reallocations=%llu scanned_nodes=%llu\n",
+                         variant, name, (unsigned long long)op.calls, (unsigned long long)op.moved_nodes,
+                         (unsigned long long)op.moved_bytes, (unsigned long long)op.reallocations,
+                         (unsigned long long)op.scanned_nodes);
+    });
+}
+void
+print_stats(const char*, const vt::no_instrumentation&) {}
+
+template<typename tree_t>
+auto
+stats_of(const tree_t& tree, int) -> decltype(tree.instrumentation().snapshot()) { return tree.instrumentation().snapshot(); }
+template<typename tree_t>
+vt::no_instrumentation
+stats_of(const tree_t&, long) { return {}; }
+
+template<typename instrument_t>
+void
+run(const char* variant, size_t nodes) {
+    using tree_t = tree_for_t<instrument_t>;
+    auto bytes = double(sizeof(typename tree_t::node_t));
+
+    tree_t tree;
+    auto push_back = bench::measure([&] {
+        bench::random_tree(tree, nodes, 64, 42, [](size_t i) { return uint32_t(i); });
+        bench::keep(tree);
+    }, 3);
+    bench::report("push_back", variant, nodes, push_back, bytes);
+
+    // a short tree keeps the shifts small against the hooks
+    const size_t edits = nodes;
+    tree.clear();
+    tree.push_root(0);
+    for (uint32_t i = 1; i < 64; ++i) tree.push_back_child(i);
+    auto insert_erase = bench::measure([&] {
+        for (size_t i = 0; i < edits; ++i) {
+            tree.insert_first_child(tree.begin(), uint32_t(i));
+            tree.erase_leaf(tree.begin() + 1);
+        }
+        bench::keep(tree);
+    }, 3);
+    bench::report("insert_erase", variant, edits, insert_erase, bytes);
+    print_stats(variant, stats_of(tree, 0));
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {100000, 1000000, 10000000})) {
+        run<vt::no_instrumentation>("none", nodes);
+        run<vt::counting_instrumentation<>>("counting", nodes);
+        run<vt::counting_instrumentation<true>>("latency", nodes);
+    }
+}
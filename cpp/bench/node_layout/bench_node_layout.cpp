@@ -0,0 +1,127 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/node_layout.h"
+
+#include <cstdint>
+
+/*
+ * Compares node layouts for a payload {uint32_t id; uint64_t key;}
+ * - default: drift_node with size_t drifts
+ * - drift32: drift_node with uint32_t drifts, the padding stays
+ * - packed: drift behind the data, byte aligned nodes
+ * - field: drift in the padding slot after id
+ * - bits: drift in the upper 16 bits of key
+ *
+ * Each variant reports bytes per node for
+ * - build with push_back_*
+ * - full depth first scan with level tracking
+ * - subtree_end: the end of every child subtree of the root
+ * - sum: payload access only
+ *
+ * usage: bench_node_layout [nodes...]
+ */
+
+namespace {
+
+const size_t max_level = 200;
+
+// one payload type per variant, the layout is selected by the payload
+template<int variant>
+struct item {
+    item() = default;
+    item(size_t i) : id(uint32_t(i)), key(i * 7) {}
+
+    uint32_t id;
+    uint32_t spare; // padding in the default layout
+    uint64_t key;
+};
+
+enum { DEFAULT, DRIFT32, PACKED, FIELD, BITS };
+
+template<typename node_t>
+uint64_t key_of(const node_t& node) { return node.data.key; }
+template<typename data_t, typename drift_t>
+uint64_t key_of(const vt::packed_drift_node<data_t, drift_t>& node) { return node.load().key; }
+template<typename data_t, typename word_t, word_t data_t::*word, unsigned shift, unsigned width>
+uint64_t key_of(const vt::bits_drift_node<data_t, word_t, word, shift, width>& node) { return node.payload_bits(); }
+
+} // namespace
+
+namespace vt {
+template<typename drift_t>
+struct node_layout<item<PACKED>, drift_t> { using type = packed_drift_node<item<PACKED>, uint32_t>; };
+template<typename drift_t>
+struct node_layout<item<FIELD>, drift_t> { using type = field_drift_node<item<FIELD>, uint32_t, &item<FIELD>::spare>; };
+template<typename drift_t>
+struct node_layout<item<BITS>, drift_t> { using type = bits_drift_node<item<BITS>, uint64_t, &item<BITS>::key, 48, 16>; };
+} // namespace vt
+
+namespace {
+
+template<typename tree_t>
+void
+run(const char* variant, size_t nodes) {
+    using data_t = typename tree_t::data_t;
+    auto bytes = double(sizeof(typename tree_t::node_t));
+
+    tree_t tree;
+    auto build = bench::measure([&] {
+        bench::random_tree(tree, nodes, max_level, 42, [](size_t i) { return data_t(i); });
+    }, 3);
+    bench::report("build", variant, nodes, build, bytes);
+
+    auto scan = bench::measure([&] {
+        vt::subtree<tree_t> st(tree.begin());
+        size_t sum = 0;
+        for (auto it = st.begin(); it != st.end(); ++it) sum += it.level();
+        bench::keep(sum);
+    });
+    bench::report("scan", variant, nodes, scan, bytes);
+
+    auto subtree_end = bench::measure([&] {
+        size_t sum = 0;
+        for (auto it = tree.begin() + 1; it != tree.end(); it = vt::find_subtree_end(it)) sum += size_t(it - tree.begin());
+        bench::keep(sum);
+    });
+    bench::report("subtree_end", variant, nodes, subtree_end, bytes);
+
+    auto sum = bench::measure([&] {
+        uint64_t total = 0;
+        for (const auto& node : tree) total += key_of(node);
+        bench::keep(total);
+    });
+    bench::report("sum", variant, nodes, sum, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {100000, 1000000, 10000000})) {
+        run<vt::drift_tree<item<DEFAULT>>>("default", nodes);
+        run<vt::drift_tree<item<DRIFT32>, uint32_t>>("drift32", nodes);
+        run<vt::drift_tree<item<PACKED>>>("packed", nodes);
+        run<vt::drift_tree<item<FIELD>>>("field", nodes);
+        run<vt::drift_tree<item<BITS>>>("bits", nodes);
+    }
+}
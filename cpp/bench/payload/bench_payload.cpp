@@ -0,0 +1,109 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Building trees with heap allocated payloads
+ * - copy_twice: a copy passed by value and copied into the node (the former API)
+ * - copy: a single copy from an lvalue
+ * - move: a prepared payload moved into the node
+ * - emplace: the payload constructed in place from its arguments
+ *
+ * usage: bench_payload [nodes...]
+ */
+
+namespace {
+
+template<typename data_t, typename Make, typename Emplace>
+void
+run(const char* benchmark, size_t nodes, Make make, Emplace emplace) {
+    using tree_t = vt::drift_tree<data_t>;
+    auto shape = [&](tree_t& tree, auto&& push) {
+        tree.clear();
+        tree.reserve(nodes);
+        push(tree, 0, vt::drift_tree<int>::DRIFT_CHILD, true);
+        for (size_t i = 1; i < nodes; ++i) push(tree, i, i % 4 ? 1 : 0, false);
+    };
+    tree_t tree;
+    auto bytes = sizeof(typename tree_t::node_t);
+
+    auto copy_twice = bench::measure([&] {
+        auto value = make(0);
+        shape(tree, [&](tree_t& t, size_t, size_t drift, bool root) {
+            data_t copy = value;
+            if (root) t.push_root(copy);
+            else t.push_back_drifted(copy, drift);
+        });
+        bench::keep(tree);
+    });
+    bench::report(benchmark, "copy_twice", nodes, copy_twice, bytes);
+
+    auto copy = bench::measure([&] {
+        auto value = make(0);
+        shape(tree, [&](tree_t& t, size_t, size_t drift, bool root) {
+            if (root) t.push_root(value);
+            else t.push_back_drifted(value, drift);
+        });
+        bench::keep(tree);
+    });
+    bench::report(benchmark, "copy", nodes, copy, bytes);
+
+    std::vector<data_t> values;
+    auto move = bench::measure_prepared([&] {
+        tree.clear();
+        values.assign(nodes, make(0));
+    }, [&] {
+        shape(tree, [&](tree_t& t, size_t i, size_t drift, bool root) {
+            if (root) t.push_root(std::move(values[i]));
+            else t.push_back_drifted(std::move(values[i]), drift);
+        });
+        bench::keep(tree);
+    });
+    bench::report(benchmark, "move", nodes, move, bytes);
+
+    auto in_place = bench::measure([&] {
+        shape(tree, [&](tree_t& t, size_t, size_t drift, bool root) {
+            if (root) emplace(t, [&](auto&&... args) { t.emplace_root(args...); });
+            else emplace(t, [&](auto&&... args) { t.emplace_back_drifted(drift, args...); });
+        });
+        bench::keep(tree);
+    });
+    bench::report(benchmark, "emplace", nodes, in_place, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {10000, 100000, 1000000})) {
+        run<std::string>("string_payload", nodes,
+                         [](size_t) { return std::string(48, 'x'); },
+                         [](auto&, auto&& emplace) { emplace(size_t(48), 'x'); });
+        run<std::vector<int>>("vector_payload", nodes,
+                              [](size_t) { return std::vector<int>(16, 1); },
+                              [](auto&, auto&& emplace) { emplace(size_t(16), 1); });
+    }
+}
@@ -0,0 +1,75 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "pointer_tree.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/post_order.h"
+
+/*
+ * Bottom up traversal of the same tree
+ * - drift tree post order with a stack of open positions
+ * - drift tree reverse pre order without a stack
+ * - pointer tree post order with parent links
+ *
+ * usage: bench_post_order [nodes...]
+ */
+
+namespace {
+
+using tree_t = vt::drift_tree<uint32_t>;
+
+void
+run(size_t nodes) {
+    tree_t tree;
+    bench::random_tree(tree, nodes, 64, 7, [](size_t i) { return uint32_t(i); });
+    bench::pointer_tree<uint32_t> pointers;
+    pointers.assign(tree);
+
+    auto post = bench::measure([&] {
+        size_t sum = 0;
+        auto po = vt::post_order(tree);
+        for (auto it = po.begin(); it != po.end(); ++it) sum += it->data + it.level();
+        bench::keep(sum);
+    });
+    bench::report("post_order", "drift_stack", nodes, post, sizeof(tree_t::node_t));
+
+    auto reverse = bench::measure([&] {
+        size_t sum = 0;
+        auto rpo = vt::reverse_pre_order(tree);
+        for (auto it = rpo.begin(); it != rpo.end(); ++it) sum += it->data + it.level();
+        bench::keep(sum);
+    });
+    bench::report("post_order", "drift_reverse", nodes, reverse, sizeof(tree_t::node_t));
+
+    auto pointer = bench::measure([&] {
+        size_t sum = 0;
+        pointers.post_order([&](const auto& n) { sum += n.data; });
+        bench::keep(sum);
+    });
+    bench::report("post_order", "pointer", nodes, pointer, sizeof(bench::pointer_tree<uint32_t>::node));
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {100000, 1000000, 10000000})) run(nodes);
+}
@@ -0,0 +1,76 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/double_ended_vector.h"
+
+/*
+ * Bottom up construction and forward iteration
+ * - push_root: every node becomes the new root of the tree built so far
+ * - insert_front: insert_first_child below the root, the parsers way to add an early sibling
+ * - iterate: sum over all nodes of a random tree
+ *
+ * std::vector shifts all nodes on each push_root, it is skipped above 50000 nodes.
+ *
+ * usage: bench_push_root [nodes...]
+ */
+
+namespace {
+
+template<typename tree_t>
+void
+run(const char* variant, size_t nodes) {
+    auto bytes = sizeof(typename tree_t::node_t);
+    tree_t tree;
+    auto push_root = bench::measure([&] {
+        tree.clear();
+        tree.push_root(0);
+        for (size_t i = 1; i < nodes; ++i) tree.push_root(uint32_t(i));
+        bench::keep(tree);
+    }, 3);
+    bench::report("push_root", variant, nodes, push_root, bytes);
+
+    auto insert_front = bench::measure([&] {
+        tree.clear();
+        tree.push_root(0);
+        tree.push_back_child(1);
+        for (size_t i = 2; i < nodes; ++i) tree.insert_first_child(tree.begin(), uint32_t(i));
+        bench::keep(tree);
+    }, 3);
+    bench::report("insert_front", variant, nodes, insert_front, bytes);
+
+    bench::random_tree(tree, nodes, 64, 7, [](size_t i) { return uint32_t(i); });
+    auto iterate = bench::measure([&] {
+        size_t sum = 0;
+        for (const auto& node : tree) sum += node.data + node.drift;
+        bench::keep(sum);
+    });
+    bench::report("iterate", variant, nodes, iterate, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {10000, 50000, 1000000, 10000000})) {
+        if (nodes <= 50000) run<vt::drift_tree<uint32_t>>("std_vector", nodes);
+        run<vt::double_ended_drift_tree<uint32_t>>("double_ended", nodes);
+    }
+}
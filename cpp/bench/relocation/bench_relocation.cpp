@@ -0,0 +1,102 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/relocatable_vector.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Node shifts of std::vector versus relocatable_vector storage
+ * - grow: push_back without reserve, every reallocation moves all nodes
+ * - insert: insert_first_child at random positions shifts the tail
+ * - erase: erase_leaf at random positions compacts the tail
+ *
+ * Payloads: uint64_t, unique_ptr<int>, vector<int> and std::string.
+ * Strings are not relocatable with libstdc++ and use std::vector in both variants.
+ *
+ * usage: bench_relocation [nodes...]
+ */
+
+namespace {
+
+template<typename tree_t, typename Make>
+void
+run_tree(const char* benchmark, const char* variant, size_t nodes, Make make) {
+    using data_t = typename tree_t::data_t;
+    auto bytes = sizeof(typename tree_t::node_t);
+    auto edits = std::max<size_t>(nodes / 100, 10);
+    tree_t tree;
+
+    auto grow = bench::measure([&] {
+        tree_t t;
+        t.push_root(make(0));
+        for (size_t i = 1; i < nodes; ++i) t.push_back_drifted(make(i), i % 4 ? 1 : 0);
+        bench::keep(t);
+    });
+    bench::report(benchmark, (std::string(variant) + "_grow").c_str(), nodes, grow, bytes);
+
+    auto build = [&] {
+        tree.clear();
+        tree.reserve(nodes + edits);
+        tree.push_root(make(0));
+        for (size_t i = 1; i < nodes; ++i) tree.push_back_drifted(make(i), i % 4 ? 1 : 0);
+    };
+
+    auto insert = bench::measure_prepared(build, [&] {
+        bench::xorshift random(3);
+        for (size_t i = 0; i < edits; ++i) tree.insert_first_child(tree.begin() + random.below(tree.size()), make(i));
+        bench::keep(tree);
+    });
+    bench::report(benchmark, (std::string(variant) + "_insert").c_str(), edits, insert, bytes);
+
+    auto erase = bench::measure_prepared(build, [&] {
+        bench::xorshift random(5);
+        for (size_t i = 0; i < edits; ++i) {
+            auto it = tree.begin() + 1 + random.below(tree.size() - 1);
+            while (!it->is_leaf()) ++it;
+            tree.erase_leaf(it);
+        }
+        bench::keep(tree);
+    });
+    bench::report(benchmark, (std::string(variant) + "_erase").c_str(), edits, erase, bytes);
+    (void)sizeof(data_t);
+}
+
+template<typename data_t, typename Make>
+void
+run(const char* benchmark, size_t nodes, Make make) {
+    run_tree<vt::drift_tree<data_t>>(benchmark, "std_vector", nodes, make);
+    run_tree<vt::relocating_drift_tree<data_t>>(benchmark, "relocating", nodes, make);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {10000, 100000, 1000000})) {
+        run<uint64_t>("uint64_payload", nodes, [](size_t i) { return uint64_t(i); });
+        run<std::unique_ptr<int>>("unique_ptr_payload", nodes, [](size_t i) { return std::make_unique<int>(int(i)); });
+        run<std::vector<int>>("vector_payload", nodes, [](size_t i) { return std::vector<int>(4, int(i)); });
+        run<std::string>("string_payload", nodes, [](size_t i) { return std::string(32, char('a' + i % 26)); });
+    }
+}
@@ -0,0 +1,92 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/tree_shapes.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Setup cost of benchmark trees for each shape
+ * - generate: generate_tree into presized storage
+ * - push_back: the same levels appended with emplace_back_drifted
+ * - levels: the raw level stream into a presized vector
+ *
+ * GB/s of the node storage = bytes_per_node / ns_per_node
+ *
+ * usage: bench_shapes [nodes...]
+ */
+
+namespace {
+
+using tree_t = vt::drift_tree<uint32_t, uint32_t>;
+
+template<typename Make>
+void
+run(const char* shape_name, size_t nodes, Make make_shape) {
+    auto bytes = double(sizeof(tree_t::node_t));
+    auto payload = [](size_t i, size_t) { return uint32_t(i); };
+
+    tree_t tree;
+    auto generate = bench::measure([&] {
+        auto shape = make_shape();
+        vt::generate_tree(tree, shape, nodes, payload);
+        bench::keep(tree);
+    }, 3);
+    bench::report("generate", shape_name, nodes, generate, bytes);
+
+    auto push_back = bench::measure([&] {
+        auto shape = make_shape();
+        tree.clear();
+        tree.reserve(nodes);
+        size_t back_level = 0;
+        vt::generate(shape, nodes, [&](size_t i, size_t level) {
+            if (0 == i) tree.emplace_root(uint32_t(i));
+            else tree.emplace_back_drifted(uint32_t(1 + back_level - level), uint32_t(i));
+            back_level = level;
+        });
+        bench::keep(tree);
+    }, 3);
+    bench::report("push_back", shape_name, nodes, push_back, bytes);
+
+    std::vector<uint32_t> levels(nodes);
+    auto stream = bench::measure([&] {
+        auto shape = make_shape();
+        vt::generate_levels(shape, nodes, levels.begin());
+        bench::keep(levels);
+    }, 3);
+    bench::report("levels", shape_name, nodes, stream, double(sizeof(uint32_t)));
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto nodes : bench::sizes(argc, argv, {1000000, 10000000, 100000000})) {
+        run("chain", nodes, [] { return vt::chain_shape(1000); });
+        run("binary", nodes, [=] { return vt::kary_shape(2, nodes); });
+        run("star", nodes, [=] { return vt::kary_shape(nodes, nodes); });
+        run("random", nodes, [] { return vt::random_shape(64, 42); });
+        run("dom", nodes, [] { return vt::dom_shape(42); });
+        run("filesystem", nodes, [] { return vt::filesystem_shape(42); });
+    }
+}
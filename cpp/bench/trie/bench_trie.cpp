@@ -0,0 +1,232 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "counting_new.h"
+
+#include "vector_tree/drift_trie.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Compares drift_trie with a pointer trie of one node per key byte
+ * - build: from keys sorted up front
+ * - find: every key, in random order
+ * - longest_prefix: every key with a random suffix
+ * - prefix_scan: all keys below 256 prefixes of two path segments
+ * - memory: bytes allocated per key after the build
+ *
+ * Keys look like paths "/seg/seg/...", segments come from a small random vocabulary
+ * so the keys share long prefixes like routes or file names.
+ * Duplicates are dropped, so small vocabularies give fewer keys than requested.
+ * Times are reported per key (per visited key for prefix_scan),
+ * bytes_per_node counts requested heap bytes per key.
+ *
+ * usage: bench_trie [keys...]
+ */
+
+namespace {
+
+using value_t = uint32_t;
+using pairs_t = std::vector<std::pair<std::string, value_t>>;
+
+// classic trie with a node per byte and the children in a map
+struct pointer_trie {
+    struct node {
+        bool has_value = false;
+        value_t value = 0;
+        std::map<unsigned char, std::unique_ptr<node>> children;
+    };
+
+    void insert(const std::string& key, value_t value) {
+        auto n = &root;
+        for (auto c : key) {
+            auto& child = n->children[(unsigned char)c];
+            if (!child) child.reset(new node);
+            n = child.get();
+        }
+        n->has_value = true;
+        n->value = value;
+    }
+
+    const node* locate(const std::string& key) const {
+        auto n = &root;
+        for (auto c : key) {
+            auto it = n->children.find((unsigned char)c);
+            if (it == n->children.end()) return nullptr;
+            n = it->second.get();
+        }
+        return n;
+    }
+
+    const value_t* find(const std::string& key) const {
+        auto n = locate(key);
+        return n && n->has_value ? &n->value : nullptr;
+    }
+
+    size_t longest_prefix(const std::string& key) const {
+        auto n = &root;
+        size_t length = 0;
+        for (size_t i = 0; i < key.size(); ++i) {
+            auto it = n->children.find((unsigned char)key[i]);
+            if (it == n->children.end()) break;
+            n = it->second.get();
+            if (n->has_value) length = i + 1;
+        }
+        return length;
+    }
+
+    template<typename Fn>
+    static void for_each(const node& n, std::string& key, Fn& fn) {
+        if (n.has_value) fn(key, n.value);
+        for (const auto& child : n.children) {
+            key.push_back(char(child.first));
+            for_each(*child.second, key, fn);
+            key.pop_back();
+        }
+    }
+
+    template<typename Fn>
+    void for_each_prefixed(const std::string& prefix, Fn fn) const {
+        auto n = locate(prefix);
+        if (!n) return;
+        std::string key = prefix;
+        for_each(*n, key, fn);
+    }
+
+    node root;
+};
+
+pairs_t
+make_keys(size_t count) {
+    bench::xorshift random(42);
+    std::vector<std::string> words(64);
+    for (auto& word : words) {
+        auto length = 2 + random.below(8);
+        for (size_t i = 0; i < length; ++i) word += char('a' + random.below(26));
+    }
+    std::vector<std::string> keys;
+    keys.reserve(count + count / 8);
+    while (keys.size() < count + count / 8) {
+        std::string key;
+        auto segments = 2 + random.below(5);
+        for (size_t s = 0; s < segments; ++s) key += "/" + words[random.below(s < 2 ? 8 : words.size())];
+        keys.push_back(std::move(key));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    keys.resize(std::min(keys.size(), count));
+    pairs_t pairs;
+    pairs.reserve(keys.size());
+    for (auto& key : keys) pairs.emplace_back(std::move(key), value_t(pairs.size()));
+    return pairs;
+}
+
+struct queries_t {
+    std::vector<std::string> keys;      // all keys shuffled
+    std::vector<std::string> extended;  // keys with a random suffix
+    std::vector<std::string> prefixes;  // two path segments
+};
+
+queries_t
+make_queries(const pairs_t& pairs) {
+    bench::xorshift random(7);
+    queries_t queries;
+    for (const auto& pair : pairs) queries.keys.push_back(pair.first);
+    for (size_t i = queries.keys.size(); i > 1; --i) std::swap(queries.keys[i - 1], queries.keys[random.below(i)]);
+    for (const auto& key : queries.keys) queries.extended.push_back(key + "/x" + std::to_string(random.below(100)));
+    for (size_t k = 0; k < 256; ++k) {
+        const auto& key = pairs[pairs.size() * k / 256].first;
+        queries.prefixes.push_back(key.substr(0, key.find('/', key.find('/', 1) + 1)));
+    }
+    return queries;
+}
+
+template<typename Fn>
+double
+bytes_per_key(size_t keys, Fn build) {
+    auto before = bench::allocated_bytes().load();
+    build();
+    return double(bench::allocated_bytes().load() - before) / double(keys);
+}
+
+template<typename trie_t, typename Build, typename LongestPrefix>
+void
+run(const char* variant, const pairs_t& pairs, const queries_t& queries, Build build_trie,
+    LongestPrefix longest_prefix) {
+    auto keys = pairs.size();
+    std::unique_ptr<trie_t> trie;
+    auto build = bench::measure([&] { trie = build_trie(); }, 3);
+    trie.reset();
+    auto bytes = bytes_per_key(keys, [&] { trie = build_trie(); });
+    bench::report("build", variant, keys, build, bytes);
+    bench::report("memory", variant, keys, 0, bytes);
+
+    auto find = bench::measure([&] {
+        uint64_t sum = 0;
+        for (const auto& key : queries.keys) sum += *trie->find(key);
+        bench::keep(sum);
+    });
+    bench::report("find", variant, keys, find, bytes);
+
+    auto prefix = bench::measure([&] {
+        uint64_t sum = 0;
+        for (const auto& key : queries.extended) sum += longest_prefix(*trie, key);
+        bench::keep(sum);
+    });
+    bench::report("longest_prefix", variant, keys, prefix, bytes);
+
+    size_t scanned = 0;
+    auto scan = bench::measure([&] {
+        uint64_t sum = 0;
+        scanned = 0;
+        for (const auto& p : queries.prefixes)
+            trie->for_each_prefixed(p, [&](const std::string& key, value_t value) {
+                sum += key.size() + value;
+                scanned += 1;
+            });
+        bench::keep(sum);
+    });
+    bench::report("prefix_scan", variant, scanned, scan, bytes);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    bench::print_header();
+    for (auto count : bench::sizes(argc, argv, {10000, 100000, 1000000})) {
+        auto pairs = make_keys(count);
+        auto queries = make_queries(pairs);
+        using drift_trie_t = vt::drift_trie<value_t>;
+        run<drift_trie_t>("drift_trie", pairs, queries, [&] {
+            return std::unique_ptr<drift_trie_t>(new drift_trie_t(pairs.begin(), pairs.end()));
+        }, [](const drift_trie_t& trie, const std::string& key) { return trie.longest_prefix(key).length; });
+        run<pointer_trie>("pointer_trie", pairs, queries, [&] {
+            std::unique_ptr<pointer_trie> trie(new pointer_trie);
+            for (const auto& pair : pairs) trie->insert(pair.first, pair.second);
+            return trie;
+        }, [](const pointer_trie& trie, const std::string& key) { return trie.longest_prefix(key); });
+    }
+}
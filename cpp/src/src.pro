@@ -25,7 +25,28 @@ TARGET = vector_tree
 SOURCES += \
 
 HEADERS += \
-	vector_tree/drift_tree.h
+	vector_tree/column_registry.h \
+	vector_tree/double_ended_vector.h \
+	vector_tree/drift_bvh.h \
+	vector_tree/drift_tree.h \
+	vector_tree/drift_trie.h \
+	vector_tree/edit_transaction.h \
+	vector_tree/eval_reverse.h \
+	vector_tree/instrumentation.h \
+	vector_tree/level_order.h \
+	vector_tree/memory_report.h \
+	vector_tree/node_layout.h \
+	vector_tree/parallel_builder.h \
+	vector_tree/parallel_traversal.h \
+	vector_tree/partition.h \
+	vector_tree/post_order.h \
+	vector_tree/relocatable_vector.h \
+	vector_tree/relocation.h \
+	vector_tree/static_drift_tree.h \
+	vector_tree/submission_queue.h \
+	vector_tree/subtree_index.h \
+	vector_tree/tree_shapes.h \
+	vector_tree/widening_drift_tree.h
 
 INSTALL_HEADERS += \
 
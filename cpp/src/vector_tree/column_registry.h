@@ -0,0 +1,306 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vt {
+
+// typed slot of a side column, valid for the tree it was attached to and its copies
+template<typename T>
+struct column_handle
+{
+        size_t slot;
+};
+
+namespace detail {
+
+// the structural edits of a tree, applied to one column
+// every edit that may allocate is split into a throwing reserve before the
+// nodes change and a noexcept update afterwards
+struct column_base
+{
+        virtual ~column_base() = default;
+
+        virtual std::unique_ptr<column_base> clone(bool with_values) const = 0;
+        virtual size_t memory_bytes() const noexcept = 0;
+        virtual void reserve(size_t count) = 0;
+        virtual void shrink_to_fit() = 0;
+        // HINT: the updates below rely on a previous reserve
+        virtual void resize(size_t count) noexcept = 0;
+        virtual void insert(size_t pos, size_t count) noexcept = 0;
+        virtual void erase(size_t pos, size_t count) noexcept = 0;
+        virtual void spread(const std::pair<size_t, size_t>* runs, size_t run_count, size_t inserted) noexcept = 0;
+        virtual void append(column_base& other) noexcept = 0;
+        virtual void prepare_gather(size_t count) = 0;
+        virtual void gather(const size_t* sources, size_t count) noexcept = 0;
+};
+
+} // namespace detail
+
+/*!
+ * One value per node of a tree, kept in sync with its structural edits
+ *
+ * Inserted nodes get value initialized entries, erased nodes drop theirs.
+ * Index the column with the position of the node in the tree.
+ * Copies of the tree copy the values, copying a column of move only values throws std::logic_error.
+ *
+ * HINT: values have to be nothrow default and move constructible
+ */
+template<typename T>
+struct side_column final : detail::column_base
+{
+        static_assert(std::is_nothrow_default_constructible<T>::value && std::is_nothrow_move_constructible<T>::value
+                      && std::is_nothrow_move_assignable<T>::value,
+                      "column values need nothrow default construction and moves");
+
+        using value_type = T;
+        using iterator = typename std::vector<T>::iterator;
+        using const_iterator = typename std::vector<T>::const_iterator;
+
+        explicit side_column(std::vector<T> values) noexcept
+                : values_m(std::move(values)) {}
+
+        T& operator[](size_t pos) noexcept { return values_m[pos]; }
+        const T& operator[](size_t pos) const noexcept { return values_m[pos]; }
+
+        size_t size() const noexcept { return values_m.size(); }
+        T* data() noexcept { return values_m.data(); }
+        const T* data() const noexcept { return values_m.data(); }
+
+        iterator begin() noexcept { return values_m.begin(); }
+        const_iterator begin() const noexcept { return values_m.begin(); }
+        iterator end() noexcept { return values_m.end(); }
+        const_iterator end() const noexcept { return values_m.end(); }
+
+        // moves the values out, the storage can be reused by the next attach
+        std::vector<T> release() noexcept { return std::move(values_m); }
+
+        // throws std::logic_error for move only values, an empty layout copy always works
+        std::unique_ptr<detail::column_base> clone(bool with_values) const override {
+                if (!with_values) return std::make_unique<side_column>(std::vector<T>());
+                return std::make_unique<side_column>(copy_values(std::is_copy_constructible<T>{}));
+        }
+
+        // allocated bytes of the values and the gather buffer, without the heap of the values
+        size_t memory_bytes() const noexcept override {
+                return sizeof(*this) + (values_m.capacity() + spare_m.capacity()) * sizeof(T);
+        }
+
+        // grows geometrically, the reserve runs before every single insert
+        void reserve(size_t count) override {
+                if (count > values_m.capacity()) values_m.reserve(std::max(count, 2 * values_m.capacity()));
+        }
+        void shrink_to_fit() override { values_m.shrink_to_fit(); }
+
+        void resize(size_t count) noexcept override { values_m.resize(count); }
+
+        void insert(size_t pos, size_t count) noexcept override {
+                auto old_size = values_m.size();
+                values_m.resize(old_size + count);
+                std::move_backward(values_m.begin() + pos, values_m.begin() + old_size, values_m.end());
+                for (auto i = pos; i < pos + count; ++i) values_m[i] = T();
+        }
+
+        void erase(size_t pos, size_t count) noexcept override {
+                values_m.erase(values_m.begin() + pos, values_m.begin() + pos + count);
+        }
+
+        // runs of (original position, count) insert count values behind the original position
+        // runs are sorted by position, all of them are applied in one pass from the back
+        void spread(const std::pair<size_t, size_t>* runs, size_t run_count, size_t inserted) noexcept override {
+                auto src = values_m.size();
+                values_m.resize(src + inserted);
+                auto dst = values_m.size();
+                for (auto i = run_count; i-- > 0;) {
+                        auto tail = src - (runs[i].first + 1);
+                        std::move_backward(values_m.begin() + (src - tail), values_m.begin() + src, values_m.begin() + dst);
+                        src -= tail;
+                        dst -= tail;
+                        for (size_t k = 0; k < runs[i].second; ++k) values_m[--dst] = T();
+                }
+        }
+
+        void append(detail::column_base& other) noexcept override {
+                auto& values = static_cast<side_column&>(other).values_m;
+                assert(values_m.capacity() >= values_m.size() + values.size());
+                values_m.insert(values_m.end(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+                values.clear();
+        }
+
+        // the gathered values are built in a spare buffer that is kept for the next gather
+        void prepare_gather(size_t count) override {
+                spare_m.clear();
+                spare_m.reserve(count);
+        }
+
+        // sources are original positions, npos for new nodes
+        void gather(const size_t* sources, size_t count) noexcept override {
+                for (size_t i = 0; i < count; ++i) {
+                        if (sources[i] == size_t(-1)) spare_m.emplace_back();
+                        else spare_m.emplace_back(std::move(values_m[sources[i]]));
+                }
+                values_m.swap(spare_m);
+                spare_m.clear();
+        }
+
+private:
+        std::vector<T> copy_values(std::true_type) const { return values_m; }
+        std::vector<T> copy_values(std::false_type) const {
+                throw std::logic_error("side_column of move only values cannot be copied");
+        }
+
+        std::vector<T> values_m;
+        std::vector<T> spare_m;
+};
+
+/*!
+ * The side columns attached to one tree
+ *
+ * Holds a single pointer that stays null while no column is attached,
+ * so every edit hook costs one branch for trees without columns.
+ * Copies of the registry copy the values, moves keep the column objects alive.
+ */
+struct column_registry
+{
+        static constexpr size_t npos = size_t(-1);
+
+        column_registry() = default;
+        column_registry(const column_registry& other) : column_registry(other, true) {}
+        column_registry(column_registry&&) noexcept = default;
+        ~column_registry() = default;
+
+        column_registry& operator =(const column_registry& other) {
+                if (this != &other) {
+                        column_registry copy(other);
+                        slots_m.swap(copy.slots_m);
+                }
+                return *this;
+        }
+        column_registry& operator =(column_registry&&) noexcept = default;
+
+        bool attached() const noexcept { return bool(slots_m); }
+
+        // heap bytes of all columns and the slots
+        size_t memory_bytes() const noexcept {
+                if (!slots_m) return 0;
+                auto bytes = sizeof(slots_t) + slots_m->capacity() * sizeof(slots_t::value_type);
+                for (const auto& c : *slots_m)
+                        if (c) bytes += c->memory_bytes();
+                return bytes;
+        }
+
+        // the same slots without values, ex. for the fragments of a parallel build
+        column_registry layout() const { return column_registry(*this, false); }
+
+        // storage is reused, its values are replaced by size value initialized entries
+        template<typename T>
+        column_handle<T> attach(size_t size, std::vector<T> storage) {
+                storage.clear();
+                storage.resize(size);
+                auto column = std::make_unique<side_column<T>>(std::move(storage));
+                if (!slots_m) slots_m = std::make_unique<slots_t>();
+                auto free = std::find(slots_m->begin(), slots_m->end(), nullptr);
+                if (free == slots_m->end()) free = slots_m->insert(free, nullptr);
+                *free = std::move(column);
+                return {size_t(free - slots_m->begin())};
+        }
+
+        // the registry becomes empty again with its last column
+        template<typename T>
+        std::vector<T> detach(column_handle<T> handle) noexcept {
+                auto values = get(handle).release();
+                (*slots_m)[handle.slot].reset();
+                if (std::all_of(slots_m->begin(), slots_m->end(), [](const auto& c) { return !c; })) slots_m.reset();
+                return values;
+        }
+
+        template<typename T>
+        side_column<T>& get(column_handle<T> handle) noexcept {
+                assert(slots_m && handle.slot < slots_m->size() && (*slots_m)[handle.slot]);
+                return static_cast<side_column<T>&>(*(*slots_m)[handle.slot]);
+        }
+        template<typename T>
+        const side_column<T>& get(column_handle<T> handle) const noexcept {
+                assert(slots_m && handle.slot < slots_m->size() && (*slots_m)[handle.slot]);
+                return static_cast<const side_column<T>&>(*(*slots_m)[handle.slot]);
+        }
+
+        // edit hooks, reserve before the nodes change, update afterwards
+        void reserve(size_t count) {
+                if (slots_m) each([=](auto& c) { c.reserve(count); });
+        }
+        void shrink_to_fit() {
+                if (slots_m) each([](auto& c) { c.shrink_to_fit(); });
+        }
+        void resize(size_t count) noexcept {
+                if (slots_m) each([=](auto& c) { c.resize(count); });
+        }
+        void insert(size_t pos, size_t count) noexcept {
+                if (slots_m) each([=](auto& c) { c.insert(pos, count); });
+        }
+        void erase(size_t pos, size_t count) noexcept {
+                if (slots_m) each([=](auto& c) { c.erase(pos, count); });
+        }
+        void spread(const std::pair<size_t, size_t>* runs, size_t run_count, size_t inserted) noexcept {
+                if (slots_m) each([=](auto& c) { c.spread(runs, run_count, inserted); });
+        }
+        void prepare_gather(size_t count) {
+                if (slots_m) each([=](auto& c) { c.prepare_gather(count); });
+        }
+        void gather(const size_t* sources, size_t count) noexcept {
+                if (slots_m) each([=](auto& c) { c.gather(sources, count); });
+        }
+        // moves the values of a registry with the same layout behind the own values
+        void append(column_registry& other) noexcept {
+                if (!slots_m) return;
+                assert(other.slots_m && other.slots_m->size() == slots_m->size());
+                for (size_t i = 0; i < slots_m->size(); ++i)
+                        if ((*slots_m)[i]) (*slots_m)[i]->append(*(*other.slots_m)[i]);
+        }
+
+private:
+        using slots_t = std::vector<std::unique_ptr<detail::column_base>>;
+
+        column_registry(const column_registry& other, bool with_values) {
+                if (!other.slots_m) return;
+                auto slots = std::make_unique<slots_t>();
+                slots->reserve(other.slots_m->size());
+                for (const auto& c : *other.slots_m) slots->push_back(c ? c->clone(with_values) : nullptr);
+                slots_m = std::move(slots);
+        }
+
+        template<typename Fn>
+        void each(Fn fn) {
+                for (auto& c : *slots_m)
+                        if (c) fn(*c);
+        }
+
+        std::unique_ptr<slots_t> slots_m;
+};
+
+} // namespace vt
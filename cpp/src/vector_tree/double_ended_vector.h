@@ -0,0 +1,238 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/relocation.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vt {
+
+/*!
+ * A vector with free capacity in front of and behind the elements
+ *
+ * buffer_m      begin_m           end_m          capacity_m
+ *    | headroom |     elements     |   tailroom   |
+ *
+ * Inserting at the front uses the headroom, so emplace(begin()) is amortized O(1).
+ * Inserts and erases in the middle move the shorter side of the elements,
+ * the buffer grows when that side has no free capacity left.
+ * The elements stay contiguous, iterators are plain pointers.
+ *
+ * Elements are relocated with memmove for trivially relocatable types,
+ * all other types need a noexcept move constructor.
+ * The interface follows std::vector as far as drift_tree uses it.
+ *
+ * HINT: inserted ranges must not point into the vector itself
+ */
+template<typename _value_t, typename _alloc_t = std::allocator<_value_t>>
+struct double_ended_vector : relocation_buffer<double_ended_vector<_value_t, _alloc_t>, _value_t, _alloc_t>
+{
+        static_assert(is_trivially_relocatable<_value_t>::value || std::is_nothrow_move_constructible<_value_t>::value,
+                      "double_ended_vector requires a trivially relocatable or nothrow movable type");
+
+        using base_t = relocation_buffer<double_ended_vector<_value_t, _alloc_t>, _value_t, _alloc_t>;
+        using typename base_t::value_type;
+        using typename base_t::allocator_type;
+        using typename base_t::alloc_traits;
+        using typename base_t::size_type;
+        using typename base_t::reference;
+        using typename base_t::pointer;
+        using typename base_t::iterator;
+        using typename base_t::const_iterator;
+
+        explicit double_ended_vector(const allocator_type& alloc = allocator_type()) noexcept
+                : base_t(alloc) {}
+
+        double_ended_vector(const double_ended_vector& other)
+                : double_ended_vector(other, alloc_traits::select_on_container_copy_construction(other.alloc_m)) {}
+
+        double_ended_vector(const double_ended_vector& other, const allocator_type& alloc)
+                : base_t(other, alloc) {}
+
+        double_ended_vector(double_ended_vector&& other) noexcept
+                : base_t(std::move(other)) {}
+
+        double_ended_vector& operator =(const double_ended_vector& other) {
+                if (this != &other) {
+                        double_ended_vector copy(other);
+                        swap(copy);
+                }
+                return *this;
+        }
+        // HINT: the allocator moves along with the buffer
+        double_ended_vector& operator =(double_ended_vector&& other) noexcept {
+                double_ended_vector moved(std::move(other));
+                swap(moved);
+                return *this;
+        }
+
+        void swap(double_ended_vector& other) noexcept { this->swap_buffer(other); }
+
+        template< class ForwardIt >
+        void assign(ForwardIt first, ForwardIt last) {
+                clear();
+                insert(this->end(), first, last);
+        }
+
+        // elements that fit without reallocation when prepending
+        size_type front_capacity() const noexcept { return this->end_m - this->buffer_m; }
+
+        // keeps the tailroom, grows the headroom
+        void reserve_front(size_type new_cap) {
+                if (new_cap > front_capacity()) this->reallocate(new_cap - this->size(), this->tailroom());
+        }
+
+        // the free capacity is split evenly between both ends afterwards
+        void clear() noexcept {
+                this->destroy(this->begin_m, this->end_m);
+                this->begin_m = this->end_m = this->buffer_m + (this->capacity_m - this->buffer_m) / 2;
+        }
+
+        template< class... Args >
+        reference emplace_front(Args&&... args) {
+                if (this->begin_m == this->buffer_m) return *this->emplace_grow(0, std::forward<Args>(args)...);
+                alloc_traits::construct(this->alloc_m, this->begin_m - 1, std::forward<Args>(args)...);
+                return *--this->begin_m;
+        }
+
+        template< class... Args >
+        iterator emplace(const_iterator pos, Args&&... args) {
+                auto index = size_type(pos - this->begin_m);
+                if (index == 0) return &emplace_front(std::forward<Args>(args)...);
+                if (index == this->size()) return &this->emplace_back(std::forward<Args>(args)...);
+                auto side = gap_side(index, 1);
+                if (side == side_t::none) return this->emplace_grow(index, std::forward<Args>(args)...);
+                // the arguments may refer to moved elements, construct them aside first
+                typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type buffer;
+                auto value = reinterpret_cast<pointer>(&buffer);
+                alloc_traits::construct(this->alloc_m, value, std::forward<Args>(args)...);
+                auto at = open_gap(side, index, 1);
+                relocate(value, 1, at);
+                return at;
+        }
+
+        template< class ForwardIt >
+        iterator insert(const_iterator pos, ForwardIt first, ForwardIt last) {
+                auto index = size_type(pos - this->begin_m);
+                auto count = size_type(std::distance(first, last));
+                if (0 == count) return this->begin_m + index;
+                auto side = gap_side(index, count);
+                if (side == side_t::none) return this->insert_grow(index, count, first, last);
+                auto at = open_gap(side, index, count);
+                try {
+                        this->construct(at, first, last);
+                }
+                catch (...) {
+                        close_gap(side, index, count);
+                        throw;
+                }
+                return at;
+        }
+
+        iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+        // moves the shorter side to close the gap
+        iterator erase(const_iterator first, const_iterator last) {
+                auto at = this->begin_m + (first - this->begin_m);
+                auto count = size_type(last - first);
+                auto index = size_type(at - this->begin_m);
+                this->destroy(at, at + count);
+                close_gap(index < this->size() - index - count ? side_t::front : side_t::back, index, count);
+                return this->begin_m + index;
+        }
+
+        void pop_front() noexcept {
+                alloc_traits::destroy(this->alloc_m, this->begin_m);
+                this->begin_m += 1;
+        }
+
+private:
+        friend base_t;
+
+        enum class side_t { none, front, back };
+
+        // the shorter side moves to open a gap of count elements at index
+        // moving the longer side instead would make repeated inserts quadratic, the buffer grows then
+        side_t gap_side(size_type index, size_type count) const noexcept {
+                if (index < this->size() - index) return count <= this->headroom() ? side_t::front : side_t::none;
+                return count <= this->tailroom() ? side_t::back : side_t::none;
+        }
+
+        pointer open_gap(side_t side, size_type index, size_type count) noexcept {
+                if (side == side_t::front) {
+                        relocate(this->begin_m, index, this->begin_m - count);
+                        this->begin_m -= count;
+                }
+                else {
+                        relocate(this->begin_m + index, this->size() - index, this->begin_m + index + count);
+                        this->end_m += count;
+                }
+                return this->begin_m + index;
+        }
+
+        void close_gap(side_t side, size_type index, size_type count) noexcept {
+                if (side == side_t::front) {
+                        relocate(this->begin_m, index, this->begin_m + count);
+                        this->begin_m += count;
+                }
+                else {
+                        relocate(this->begin_m + index + count, this->size() - index - count, this->begin_m + index);
+                        this->end_m -= count;
+                }
+        }
+
+        // doubles the size, most of the free capacity goes to the end that ran full
+        typename base_t::grown_buffer allocate_grown(size_type index, size_type count) {
+                auto size = this->size();
+                auto needed = size + count;
+                if (needed > this->max_size() || needed < size) throw std::length_error("double_ended_vector too large");
+                auto free = std::max(needed, size_type(4));
+                if (free > this->max_size() - needed) free = this->max_size() - needed;
+                auto front = 2 * index < size ? free - free / 4 : 2 * index > size ? free / 4 : free / 2;
+                auto capacity = needed + free;
+                auto first = alloc_traits::allocate(this->alloc_m, capacity);
+                return {first, first + front, capacity};
+        }
+};
+
+// the free slots on both ends count, inserts at the front use the headroom
+template<typename value_t, typename alloc_t>
+size_t storage_capacity(const double_ended_vector<value_t, alloc_t>& vector) noexcept {
+        return vector.front_capacity() + vector.capacity() - vector.size();
+}
+
+// the shorter side moves
+template<typename value_t, typename alloc_t>
+size_t shifted_nodes(const double_ended_vector<value_t, alloc_t>&, size_t before, size_t behind) noexcept {
+        return std::min(before, behind);
+}
+
+// drift_tree with amortized O(1) push_root and cheap inserts near the front
+template<typename data_t, typename drift_t = size_t>
+using double_ended_drift_tree = drift_tree<data_t, drift_t, std::allocator<node_layout_t<data_t, drift_t>>,
+        double_ended_vector<node_layout_t<data_t, drift_t>>>;
+
+} // namespace vt
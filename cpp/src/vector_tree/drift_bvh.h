@@ -0,0 +1,521 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/node_layout.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <cassert>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace vt {
+
+// axis aligned bounding box, empty while lo > hi
+struct aabb
+{
+        float lo[3] = {std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+                       std::numeric_limits<float>::infinity()};
+        float hi[3] = {-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                       -std::numeric_limits<float>::infinity()};
+
+        aabb() = default;
+        aabb(float x0, float y0, float z0, float x1, float y1, float z1) noexcept
+                : lo{x0, y0, z0}, hi{x1, y1, z1} {}
+
+        bool empty() const noexcept { return lo[0] > hi[0] || lo[1] > hi[1] || lo[2] > hi[2]; }
+
+        void extend(const aabb& other) noexcept {
+                for (int a = 0; a < 3; ++a) {
+                        lo[a] = std::min(lo[a], other.lo[a]);
+                        hi[a] = std::max(hi[a], other.hi[a]);
+                }
+        }
+        void extend(const float point[3]) noexcept {
+                for (int a = 0; a < 3; ++a) {
+                        lo[a] = std::min(lo[a], point[a]);
+                        hi[a] = std::max(hi[a], point[a]);
+                }
+        }
+
+        float center(int axis) const noexcept { return 0.5f * (lo[axis] + hi[axis]); }
+        float extent(int axis) const noexcept { return hi[axis] - lo[axis]; }
+        int longest_axis() const noexcept {
+                return extent(0) >= extent(1) ? (extent(0) >= extent(2) ? 0 : 2) : (extent(1) >= extent(2) ? 1 : 2);
+        }
+
+        // the cost of a box in the surface area heuristic
+        float area() const noexcept {
+                if (empty()) return 0;
+                auto x = extent(0), y = extent(1), z = extent(2);
+                return 2 * (x * y + y * z + z * x);
+        }
+
+        bool overlaps(const aabb& other) const noexcept {
+                return lo[0] <= other.hi[0] && other.lo[0] <= hi[0] && lo[1] <= other.hi[1] && other.lo[1] <= hi[1]
+                        && lo[2] <= other.hi[2] && other.lo[2] <= hi[2];
+        }
+};
+
+// the ray hits where origin + t * direction for t in [t_min, t_max]
+struct ray
+{
+        float origin[3];
+        float direction[3];
+        float t_min = 0;
+        float t_max = std::numeric_limits<float>::infinity();
+};
+
+/*!
+ * Slab test of a ray against a box, inverse is 1 / direction per axis
+ *
+ * An axis parallel ray starting on a slab face gives 0 * inf = NaN for that face.
+ * The ray lies inside the closed slab, so the axis keeps the current interval
+ * for either sign of the zero direction.
+ */
+inline bool intersects(const float origin[3], const float inverse[3], float t_min, float t_max,
+                       const aabb& box) noexcept {
+        for (int a = 0; a < 3; ++a) {
+                auto t0 = (box.lo[a] - origin[a]) * inverse[a];
+                auto t1 = (box.hi[a] - origin[a]) * inverse[a];
+                if (t0 != t0 || t1 != t1) continue;
+                if (t0 > t1) std::swap(t0, t1);
+                t_min = t0 > t_min ? t0 : t_min;
+                t_max = t1 < t_max ? t1 : t_max;
+        }
+        return t_min <= t_max;
+}
+
+/*!
+ * Four rays in structure of arrays layout, tested against a box at once
+ *
+ * hit_mask uses SSE where available, bit k is set if ray k hits the box.
+ * Lanes without a ray never hit. The intervals can be narrowed per lane, ex. to find the closest hits.
+ */
+struct ray_packet
+{
+        static constexpr size_t width = 4;
+
+        alignas(16) float origin[3][width];
+        alignas(16) float inverse[3][width];
+        alignas(16) float t_min[width];
+        alignas(16) float t_max[width];
+
+        // up to width rays
+        ray_packet(const ray* rays, size_t count) noexcept {
+                assert(count <= width);
+                for (size_t k = 0; k < width; ++k) {
+                        const auto& r = rays[k < count ? k : 0];
+                        for (int a = 0; a < 3; ++a) {
+                                origin[a][k] = r.origin[a];
+                                inverse[a][k] = 1.0f / r.direction[a];
+                        }
+                        t_min[k] = k < count ? r.t_min : 1.0f;
+                        t_max[k] = k < count ? r.t_max : 0.0f;
+                }
+        }
+
+        unsigned hit_mask(const aabb& box) const noexcept {
+#if defined(__SSE__)
+                auto enter = _mm_load_ps(t_min);
+                auto leave = _mm_load_ps(t_max);
+                for (int a = 0; a < 3; ++a) {
+                        auto o = _mm_load_ps(origin[a]);
+                        auto inv = _mm_load_ps(inverse[a]);
+                        auto t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.lo[a]), o), inv);
+                        auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.hi[a]), o), inv);
+                        // the result of min and max depends on the operand order for NaN,
+                        // lanes with a NaN are masked and keep their interval like the scalar test
+                        auto valid = _mm_cmpord_ps(t0, t1);
+                        auto near = _mm_max_ps(_mm_min_ps(t0, t1), enter);
+                        auto far = _mm_min_ps(_mm_max_ps(t0, t1), leave);
+                        enter = _mm_or_ps(_mm_and_ps(valid, near), _mm_andnot_ps(valid, enter));
+                        leave = _mm_or_ps(_mm_and_ps(valid, far), _mm_andnot_ps(valid, leave));
+                }
+                return unsigned(_mm_movemask_ps(_mm_cmple_ps(enter, leave)));
+#else
+                unsigned mask = 0;
+                for (size_t k = 0; k < width; ++k) {
+                        float o[3] = {origin[0][k], origin[1][k], origin[2][k]};
+                        float inv[3] = {inverse[0][k], inverse[1][k], inverse[2][k]};
+                        if (intersects(o, inv, t_min[k], t_max[k], box)) mask |= 1u << k;
+                }
+                return mask;
+#endif
+        }
+};
+
+enum class bvh_builder {
+        binned_sah,     // surface area heuristic over a fixed number of centroid bins, O(n log n)
+        sweep_sah       // surface area heuristic over all sorted centroids, O(n log^2 n)
+};
+
+struct bvh_options
+{
+        bvh_builder builder = bvh_builder::binned_sah;
+        size_t bins = 16;
+        size_t max_leaf_size = 4;
+};
+
+/*!
+ * One node of a drift_bvh, 32 bytes
+ *
+ * Inner nodes link to the position behind their subtree, leaves to their first primitive,
+ * the position behind a leaf is the next node. The tree keeps the drift in the bits
+ * of count_bits above the count, see node_layout<bvh_node>.
+ */
+struct bvh_node
+{
+        static constexpr unsigned count_width = 8;
+        static constexpr uint32_t max_count = (uint32_t(1) << count_width) - 1;
+
+        aabb bounds;
+        uint32_t link = 0;
+        uint32_t count_bits = 0;
+
+        bvh_node() = default;
+        bvh_node(const aabb& bounds, uint32_t link, uint32_t count) noexcept
+                : bounds(bounds), link(link), count_bits(count) {}
+
+        // primitives of a leaf, 0 for inner nodes
+        uint32_t count() const noexcept { return count_bits & max_count; }
+        bool is_leaf() const noexcept { return 0 != count(); }
+};
+
+// leaves hold at most max_count primitives, that leaves 24 bits for the drift
+template<typename drift_t>
+struct node_layout<bvh_node, drift_t>
+{
+        using type = bits_drift_node<bvh_node, uint32_t, &bvh_node::count_bits, bvh_node::count_width,
+                                     32 - bvh_node::count_width>;
+};
+
+/*!
+ * Bounding volume hierarchy of boxes stored in depth first order in a drift_tree
+ *
+ * Queries run without a stack: a hit continues with the next node, a miss jumps behind the subtree.
+ * Finding that position from the drifts would read every skipped node, so inner nodes link to it.
+ * The links are derived from the drifts after the build, the drifts share a field with the leaf count.
+ * Memory is read front to back, skipped subtrees are never touched.
+ * Leaves hold up to max_leaf_size primitives, the indices into the boxes of the build.
+ *
+ * std::vector<vt::aabb> boxes = ...;
+ * vt::drift_bvh bvh(boxes);
+ * bvh.intersect(r, [&](uint32_t primitive, vt::ray& r) { r.t_max = hit_distance(primitive, r); });
+ *
+ * Traversal is in tree order, not front to back. Closest hit queries narrow t_max in the callback.
+ * After the boxes moved, refit() updates the bounds and keeps the hierarchy.
+ */
+struct drift_bvh
+{
+        using tree_t = drift_tree<bvh_node, uint32_t>;
+
+        drift_bvh() = default;
+
+        // O(n log n) for binned_sah  n = number of boxes
+        // throws std::length_error for more than 2^32 - 1 boxes or nodes
+        // throws std::invalid_argument for a max_leaf_size above bvh_node::max_count
+        // throws std::overflow_error for hierarchies deeper than 2^24 - 2 levels
+        explicit drift_bvh(const std::vector<aabb>& boxes, bvh_options options = {}) : options_m(options) {
+                if (boxes.empty()) return;
+                if (boxes.size() >= std::numeric_limits<uint32_t>::max())
+                        throw std::length_error("drift_bvh supports up to 2^32 - 1 boxes");
+                if (options_m.max_leaf_size > bvh_node::max_count)
+                        throw std::invalid_argument("drift_bvh supports up to 255 primitives per leaf");
+                assert(options_m.bins >= 2 && options_m.max_leaf_size >= 1);
+                refs_m.resize(boxes.size());
+                for (size_t i = 0; i < boxes.size(); ++i) {
+                        refs_m[i].box = boxes[i];
+                        refs_m[i].index = uint32_t(i);
+                        for (int a = 0; a < 3; ++a) refs_m[i].center[a] = boxes[i].center(a);
+                }
+                tree_m.reserve(2 * boxes.size() / options_m.max_leaf_size + 1);
+                build();
+                link_subtrees();
+                primitives_m.resize(boxes.size());
+                for (size_t i = 0; i < boxes.size(); ++i) primitives_m[i] = refs_m[i].index;
+                refs_m = std::vector<primitive_ref>();
+                bin_bounds_m = right_bounds_m = std::vector<aabb>();
+                bin_counts_m = std::vector<size_t>();
+                right_areas_m = std::vector<float>();
+        }
+
+        bool empty() const noexcept { return tree_m.empty(); }
+        const tree_t& tree() const noexcept { return tree_m; }
+        // indices of the boxes in leaf order
+        const std::vector<uint32_t>& primitives() const noexcept { return primitives_m; }
+
+        // position behind the subtree of the node at pos
+        size_t subtree_end(size_t pos) const noexcept {
+                const auto& node = tree_m[pos].data;
+                return node.is_leaf() ? pos + 1 : node.link;
+        }
+
+        // calls fn(primitive, r) for all primitives in leaves whose bounds r hits
+        // fn may narrow r.t_max to skip farther nodes
+        template<typename Fn>
+        void intersect(ray& r, Fn fn) const {
+                float inverse[3] = {1.0f / r.direction[0], 1.0f / r.direction[1], 1.0f / r.direction[2]};
+                traverse([&](const aabb& bounds) { return intersects(r.origin, inverse, r.t_min, r.t_max, bounds); },
+                         [&](uint32_t primitive) { fn(primitive, r); });
+        }
+
+        // calls fn(primitive, mask, packet) with the rays of the packet that hit the leaf bounds
+        template<typename Fn>
+        void intersect(ray_packet& packet, Fn fn) const {
+                unsigned mask = 0;
+                traverse([&](const aabb& bounds) { return 0 != (mask = packet.hit_mask(bounds)); },
+                         [&](uint32_t primitive) { fn(primitive, mask, packet); });
+        }
+
+        // calls fn(primitive) for all primitives in leaves whose bounds overlap box
+        template<typename Fn>
+        void overlap(const aabb& box, Fn fn) const {
+                traverse([&](const aabb& bounds) { return bounds.overlaps(box); }, fn);
+        }
+
+        /*!
+         * Updates the bounds after the boxes moved, the hierarchy stays the same
+         *
+         * One reverse pass: the children of a node are behind it,
+         * they are found by jumping from subtree end to subtree end.
+         * O(n)  n = number of boxes
+         */
+        void refit(const std::vector<aabb>& boxes) {
+                assert(boxes.size() == primitives_m.size());
+                for (auto pos = tree_m.size(); pos-- > 0;) {
+                        auto& node = tree_m[pos].data;
+                        aabb bounds;
+                        if (node.is_leaf()) {
+                                for (auto i = node.link; i < node.link + node.count(); ++i)
+                                        bounds.extend(boxes[primitives_m[i]]);
+                        }
+                        else {
+                                for (auto child = pos + 1; child < node.link; child = subtree_end(child))
+                                        bounds.extend(tree_m[child].data.bounds);
+                        }
+                        node.bounds = bounds;
+                }
+        }
+
+        // heap bytes of the primitive indices, the nodes are counted by memory_report(tree())
+        size_t memory_bytes() const noexcept { return primitives_m.capacity() * sizeof(uint32_t); }
+
+private:
+        // a primitive during the build, the splits move them so every pass reads sequentially
+        struct primitive_ref
+        {
+                aabb box;
+                float center[3];
+                uint32_t index;
+        };
+
+        // the primitives [first, last) of a node at level
+        struct build_task
+        {
+                size_t first;
+                size_t last;
+                size_t level;
+        };
+
+        // hit(bounds) decides to enter a node, leaf(primitive) is called for each primitive of an entered leaf
+        template<typename Hit, typename Leaf>
+        void traverse(Hit hit, Leaf leaf) const {
+                size_t pos = 0;
+                auto end = tree_m.size();
+                while (pos < end) {
+                        const auto& node = tree_m[pos].data;
+                        auto count = node.count();
+                        if (!hit(node.bounds)) {
+                                pos = count ? pos + 1 : node.link;
+                                continue;
+                        }
+                        for (auto i = node.link; i < node.link + count; ++i) leaf(primitives_m[i]);
+                        ++pos;
+                }
+        }
+
+        static auto by_center(int axis) {
+                return [axis](const primitive_ref& a, const primitive_ref& b) { return a.center[axis] < b.center[axis]; };
+        }
+
+        // appends the nodes in pre-order, a stack of pending primitive ranges replaces the recursion
+        void build() {
+                std::vector<build_task> tasks = {{0, refs_m.size(), 0}};
+                while (!tasks.empty()) {
+                        auto task = tasks.back();
+                        tasks.pop_back();
+                        aabb bounds, centers;
+                        for (auto i = task.first; i < task.last; ++i) {
+                                bounds.extend(refs_m[i].box);
+                                centers.extend(refs_m[i].center);
+                        }
+                        if (tree_m.size() >= std::numeric_limits<uint32_t>::max())
+                                throw std::length_error("drift_bvh supports up to 2^32 - 1 nodes");
+                        auto count = task.last - task.first;
+                        if (count <= options_m.max_leaf_size) {
+                                tree_m.push_at_level(bvh_node(bounds, uint32_t(task.first), uint32_t(count)), task.level);
+                                continue;
+                        }
+                        tree_m.push_at_level(bvh_node(bounds, 0, 0), task.level);
+
+                        auto mid = options_m.builder == bvh_builder::sweep_sah ? sweep_split(task.first, task.last)
+                                                                               : binned_split(task.first, task.last, centers);
+                        // equal centers or a degenerate heuristic split at the median
+                        if (mid == task.first || mid == task.last) {
+                                auto axis = centers.longest_axis();
+                                mid = task.first + count / 2;
+                                std::nth_element(refs_m.begin() + std::ptrdiff_t(task.first),
+                                                 refs_m.begin() + std::ptrdiff_t(mid),
+                                                 refs_m.begin() + std::ptrdiff_t(task.last), by_center(axis));
+                        }
+                        tasks.push_back({mid, task.last, task.level + 1});
+                        tasks.push_back({task.first, mid, task.level + 1});
+                }
+        }
+
+        // links the inner nodes to the position behind their subtree
+        // a leaf with drift d is the last node of d - 1 open inner nodes
+        void link_subtrees() {
+                std::vector<size_t> open;
+                for (size_t pos = 0; pos < tree_m.size(); ++pos) {
+                        auto drift = size_t(drift_of(tree_m[pos]));
+                        if (0 == drift) open.push_back(pos);
+                        for (; drift > 1; --drift) {
+                                tree_m[open.back()].data.link = uint32_t(pos + 1);
+                                open.pop_back();
+                        }
+                }
+        }
+
+        // partitions by the cheapest bin border of all axes, returns the first primitive of the right side
+        // one pass over the primitives fills the bins of all three axes
+        size_t binned_split(size_t first, size_t last, const aabb& centers) {
+                auto bins = options_m.bins;
+                auto& bounds = bin_bounds_m;
+                auto& right = right_bounds_m;
+                auto& counts = bin_counts_m;
+                bounds.assign(3 * bins, aabb());
+                counts.assign(3 * bins, 0);
+                right.resize(bins);
+                float scale[3];
+                for (int a = 0; a < 3; ++a) scale[a] = centers.extent(a) > 0 ? float(bins) / centers.extent(a) : 0;
+                for (auto i = first; i < last; ++i) {
+                        const auto& ref = refs_m[i];
+                        for (int a = 0; a < 3; ++a) {
+                                auto bin = size_t(a) * bins + bin_of(ref.center[a], centers.lo[a], scale[a]);
+                                bounds[bin].extend(ref.box);
+                                counts[bin] += 1;
+                        }
+                }
+
+                auto best_cost = std::numeric_limits<float>::infinity();
+                int best_axis = -1;
+                size_t best_border = 0;
+                for (int a = 0; a < 3; ++a) {
+                        if (0 == scale[a]) continue;
+                        auto axis_bounds = bounds.begin() + std::ptrdiff_t(size_t(a) * bins);
+                        auto axis_counts = counts.begin() + std::ptrdiff_t(size_t(a) * bins);
+                        // right[b] bounds the bins from b to the end
+                        right[bins - 1] = axis_bounds[std::ptrdiff_t(bins - 1)];
+                        for (auto b = bins - 1; b-- > 0;) {
+                                right[b] = right[b + 1];
+                                right[b].extend(axis_bounds[std::ptrdiff_t(b)]);
+                        }
+                        aabb left;
+                        size_t left_count = 0;
+                        for (size_t border = 1; border < bins; ++border) {
+                                left.extend(axis_bounds[std::ptrdiff_t(border - 1)]);
+                                left_count += axis_counts[std::ptrdiff_t(border - 1)];
+                                auto right_count = (last - first) - left_count;
+                                if (0 == left_count || 0 == right_count) continue;
+                                auto cost = left.area() * float(left_count) + right[border].area() * float(right_count);
+                                if (cost < best_cost) {
+                                        best_cost = cost;
+                                        best_axis = a;
+                                        best_border = border;
+                                }
+                        }
+                }
+                if (best_axis < 0) return first;
+                auto it = std::partition(refs_m.begin() + std::ptrdiff_t(first), refs_m.begin() + std::ptrdiff_t(last),
+                                         [&](const primitive_ref& ref) {
+                        return bin_of(ref.center[best_axis], centers.lo[best_axis], scale[best_axis]) < best_border;
+                });
+                return size_t(it - refs_m.begin());
+        }
+
+        size_t bin_of(float center, float lo, float scale) const noexcept {
+                auto bin = size_t((center - lo) * scale);
+                return std::min(bin, options_m.bins - 1);
+        }
+
+        // sorts by the cheapest of all splits between sorted centers, returns the first primitive of the right side
+        size_t sweep_split(size_t first, size_t last) {
+                auto count = last - first;
+                auto range_first = refs_m.begin() + std::ptrdiff_t(first);
+                auto range_last = refs_m.begin() + std::ptrdiff_t(last);
+                auto& right = right_areas_m;
+                right.resize(count);
+                auto best_cost = std::numeric_limits<float>::infinity();
+                int best_axis = -1;
+                size_t best_split = 0;
+                for (int a = 0; a < 3; ++a) {
+                        std::sort(range_first, range_last, by_center(a));
+                        // right[k] is the area of the primitives from k to the end
+                        aabb bounds;
+                        for (auto k = count; k-- > 0;) {
+                                bounds.extend(refs_m[first + k].box);
+                                right[k] = bounds.area();
+                        }
+                        bounds = aabb();
+                        for (size_t k = 1; k < count; ++k) {
+                                bounds.extend(refs_m[first + k - 1].box);
+                                auto cost = bounds.area() * float(k) + right[k] * float(count - k);
+                                if (cost < best_cost) {
+                                        best_cost = cost;
+                                        best_axis = a;
+                                        best_split = k;
+                                }
+                        }
+                }
+                if (best_axis < 0) return first;
+                if (best_axis != 2) std::sort(range_first, range_last, by_center(best_axis));
+                return first + best_split;
+        }
+
+        tree_t tree_m;
+        std::vector<uint32_t> primitives_m;
+        // primitives and split buffers, only kept during the build
+        std::vector<primitive_ref> refs_m;
+        std::vector<aabb> bin_bounds_m, right_bounds_m;
+        std::vector<size_t> bin_counts_m;
+        std::vector<float> right_areas_m;
+        bvh_options options_m;
+};
+
+} // namespace vt
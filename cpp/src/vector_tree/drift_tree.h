@@ -18,17 +18,41 @@
  */
 #pragma once
 
+#include "vector_tree/column_registry.h"
+#include "vector_tree/instrumentation.h"
+#include "vector_tree/relocation.h"
+
 #include <vector>
+#include <iterator>
 #include <utility>
 #include <cstdint>
 #include <stdexcept>
 #include <cassert>
+#include <limits>
+#include <type_traits>
 
 namespace vt {
 
 template<typename _tree_t>
 struct subtree;
 
+// narrows a drift computed in a wider type
+// throws std::overflow_error if the drift type is too small for the tree depth
+template<typename drift_t, typename value_t>
+constexpr drift_t checked_drift(value_t drift, uintmax_t max_drift = std::numeric_limits<drift_t>::max()) {
+        return static_cast<typename std::make_unsigned<value_t>::type>(drift) > max_drift
+                ? throw std::overflow_error("drift does not fit into the drift type")
+                : static_cast<drift_t>(drift);
+}
+
+// smallest drift type for trees with levels up to max_level
+// the largest drift is max_level + 1 for the deepest node at the end of the tree
+template<size_t max_level>
+using drift_for_level_t =
+        std::conditional_t<(max_level < UINT8_MAX), uint8_t,
+        std::conditional_t<(max_level < UINT16_MAX), uint16_t,
+        std::conditional_t<(max_level < UINT32_MAX), uint32_t, uint64_t>>>;
+
 // This is external to make it easier to construct a allocator
 template<typename _data_t, typename _drift_t = size_t>
 struct drift_node
@@ -36,16 +60,60 @@ struct drift_node
         using data_t = _data_t;
         using drift_t = _drift_t;
 
-        drift_node(drift_t drift, data_t data) noexcept
-                : drift(drift), data(data) {}
+        drift_node() = default;
+        // the data is constructed in place from the remaining arguments
+        template< class... Args >
+        constexpr drift_node(drift_t drift, Args&&... args)
+                noexcept(std::is_nothrow_constructible<data_t, Args&&...>::value)
+                : drift(drift), data(std::forward<Args>(args)...) {}
 
-        bool is_leaf() const noexcept { return drift != 0; }
-        bool has_children() const noexcept { return drift == 0; }
+        constexpr bool is_leaf() const noexcept { return drift != 0; }
+        constexpr bool has_children() const noexcept { return drift == 0; }
 
         drift_t drift;
         data_t data;
 };
 
+/*!
+ * Customization point for the memory layout of nodes
+ *
+ * All algorithms access drifts through these traits.
+ * A node type has a member data and is constructed with node_t(drift, args...),
+ * where args construct the data. See node_layout.h for packed layouts.
+ * drift_t is the type the layout stores, it may differ from the drift type the tree was declared with.
+ */
+template<typename node_t>
+struct node_traits
+{
+        using drift_t = typename node_t::drift_t;
+
+        static constexpr uintmax_t max_drift() noexcept { return std::numeric_limits<drift_t>::max(); }
+
+        static constexpr drift_t drift(const node_t& node) noexcept { return node.drift; }
+        static constexpr void set_drift(node_t& node, drift_t drift) noexcept { node.drift = drift; }
+};
+
+template<typename node_t>
+constexpr auto drift_of(const node_t& node) noexcept { return node_traits<node_t>::drift(node); }
+
+template<typename node_t, typename value_t>
+constexpr void set_drift(node_t& node, value_t drift) noexcept {
+        node_traits<node_t>::set_drift(node, static_cast<typename node_traits<node_t>::drift_t>(drift));
+}
+
+// selects the node type for a payload, specialize it to change the layout
+template<typename data_t, typename drift_t>
+struct node_layout
+{
+        using type = drift_node<data_t, drift_t>;
+};
+
+template<typename data_t, typename drift_t>
+using node_layout_t = typename node_layout<data_t, drift_t>::type;
+
+template<typename _data_t, typename _drift_t>
+struct is_trivially_relocatable<drift_node<_data_t, _drift_t>> : is_trivially_relocatable<_data_t> {};
+
 /* 1
  *  2    5
  *   3 4  6
@@ -67,14 +135,23 @@ struct drift_node
  * - sum of drifts == node count
  * - last node is always a leaf node
  * - all sub sequences from begin() are valid trees (missing the final drift)
+ * - every attached side column has one value per node
+ *
+ * The instrumentation policy observes every edit, see counting_instrumentation.
+ * The default policy compiles to nothing.
  */
-template< typename _data_t, typename _drift_t = size_t, typename _alloc_t = std::allocator<drift_node<_data_t, _drift_t>>>
-struct drift_tree
+template< typename _data_t, typename _drift_t = size_t, typename _alloc_t = std::allocator<node_layout_t<_data_t, _drift_t>>,
+          typename _vector_t = std::vector<node_layout_t<_data_t, _drift_t>, _alloc_t>,
+          typename _instrument_t = no_instrumentation>
+struct drift_tree : private _instrument_t
 {
         using data_t = _data_t;
-        using drift_t = _drift_t;
-        using node_t = drift_node<_data_t, _drift_t>;
-        using vector_t = std::vector<node_t, _alloc_t>;
+        using node_t = node_layout_t<_data_t, _drift_t>;
+        using traits_t = node_traits<node_t>;
+        using drift_t = typename traits_t::drift_t;
+        // storage with the std::vector interface, see relocatable_vector
+        using vector_t = _vector_t;
+        using instrument_t = _instrument_t;
 
         using level_t = size_t;
         enum {
@@ -97,7 +174,8 @@ struct drift_tree
         using const_reverse_iterator = typename vector_t::const_reverse_iterator;
 
         drift_tree(drift_tree other, const allocator_type& alloc)
-                : vector_m(other.vector_m, alloc) {}
+                : instrument_t(std::move(other.instrumentation())), vector_m(other.vector_m, alloc),
+                  columns_m(std::move(other.columns_m)) {}
 
         explicit drift_tree(const allocator_type& alloc = allocator_type())
                 : vector_m(alloc) {}
@@ -109,8 +187,21 @@ struct drift_tree
         drift_tree& operator =(drift_tree&&) = default;
 
         // delegate methods to vector
+        // HINT: the column values of all nodes are reset
         template< class InputIt >
-        void assign(InputIt first, InputIt last) { vector_m.assign(first, last); }
+        void assign(InputIt first, InputIt last) {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                columns_m.resize(0);
+                vector_m.assign(first, last);
+                try {
+                        columns_m.reserve(size());
+                }
+                catch (...) {
+                        vector_m.clear();
+                        throw;
+                }
+                columns_m.resize(size());
+        }
 
         auto get_allocator() const noexcept { return vector_m.get_allocator(); }
 
@@ -147,62 +238,198 @@ struct drift_tree
         auto size() const noexcept { return vector_m.size(); }
         auto max_size() const noexcept { return vector_m.max_size(); }
         auto capacity() const noexcept { return vector_m.capacity(); }
+        // the node storage, ex. for storage_capacity() that counts the headroom of a double_ended_vector
+        const vector_t& storage() const noexcept { return vector_m; }
 
-        void reserve(size_type new_cap) { return vector_m.reserve(new_cap); }
-        void shrink_to_fit() { vector_m.shrink_to_fit(); }
-        void clear() noexcept { vector_m.clear(); }
+        void reserve(size_type new_cap) {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                columns_m.reserve(new_cap);
+                vector_m.reserve(new_cap);
+        }
+        // HINT: only for storages with headroom, see double_ended_vector
+        void reserve_front(size_type new_cap) {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                vector_m.reserve_front(new_cap);
+        }
+        // HINT: new nodes are default constructed, fix the drifts before using the tree
+        void resize(size_type count) {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                columns_m.reserve(count);
+                vector_m.resize(count);
+                columns_m.resize(count);
+        }
+        // appends count nodes that fill(first) constructs in the uninitialized storage, see parallel_builder
+        // HINT: only for storages with has_uninitialized_append, fix the drifts before using the tree
+        template<typename Fill>
+        void append_uninitialized(size_type count, Fill&& fill) {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                columns_m.reserve(size() + count);
+                vector_m.append_uninitialized(count, std::forward<Fill>(fill));
+                columns_m.resize(size());
+        }
+        void shrink_to_fit() {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                vector_m.shrink_to_fit();
+                columns_m.shrink_to_fit();
+        }
+        void clear() noexcept {
+                vector_m.clear();
+                columns_m.resize(0);
+        }
+
+        // attach a side column with one value initialized entry per node
+        // the storage of a detached column can be passed in for reuse
+        // O(n) for the attach, every later edit updates the column in the same pass
+        template<typename T>
+        column_handle<T> attach_column(std::vector<T> storage = {}) {
+                return columns_m.attach(size(), std::move(storage));
+        }
+
+        // the values are indexed by node position
+        template<typename T>
+        side_column<T>& column(column_handle<T> handle) noexcept { return columns_m.get(handle); }
+        template<typename T>
+        const side_column<T>& column(column_handle<T> handle) const noexcept { return columns_m.get(handle); }
+
+        // returns the values, edits no longer touch them
+        template<typename T>
+        std::vector<T> detach_column(column_handle<T> handle) noexcept { return columns_m.detach(handle); }
+
+        // all attached columns, for algorithms that rebuild the nodes
+        column_registry& columns() noexcept { return columns_m; }
+        const column_registry& columns() const noexcept { return columns_m; }
+
+        // take over the nodes and columns of other, the policy object keeps its state
+        // counted as one rebuild of the storage, ex. for edit_transaction::commit()
+        void adopt(drift_tree&& other) {
+                probe_t edit_probe(instrumentation(), tree_op::storage, vector_m);
+                edit_probe.rebuild(other.size());
+                vector_m = std::move(other.vector_m);
+                columns_m = std::move(other.columns_m);
+        }
+
+        // the policy object, ex. for snapshot() of counting_instrumentation
+        instrument_t& instrumentation() noexcept { return *this; }
+        const instrument_t& instrumentation() const noexcept { return *this; }
 
         // make the value the new root
         // HINT: Use this method for the first node!
         // O(n)  n = number of nodes already in the tree
-        void push_root(data_t value) {
-                auto drift = 0;
-                vector_m.emplace(begin(), drift, value);
-                back().drift += 1;
+        //       amortized O(1) with double_ended_vector storage and no attached columns
+        void push_root(const data_t& value) { emplace_root(value); }
+        void push_root(data_t&& value) { emplace_root(std::move(value)); }
+
+        template< class... Args >
+        void emplace_root(Args&&... args) {
+                auto back_drift = empty() ? drift_t(1) : checked(level_t(1) + drift_of(back()));
+                auto drift = drift_t(0);
+                probe_t edit_probe(instrumentation(), tree_op::push_root, vector_m);
+                edit_probe.shift(0, size());
+                columns_m.reserve(size() + 1);
+                vector_m.emplace(begin(), drift, std::forward<Args>(args)...);
+                set_drift(back(), back_drift);
+                columns_m.insert(0, 1);
         }
 
         // append a node to the end with a drifted level
         // O(1) + potential reallocation of the vector
-        void push_back_drifted(data_t data, drift_t back_drift) {
+        void push_back_drifted(const data_t& data, drift_t back_drift) {
+                emplace_back_drifted(back_drift, data);
+        }
+        void push_back_drifted(data_t&& data, drift_t back_drift) {
+                emplace_back_drifted(back_drift, std::move(data));
+        }
+
+        template< class... Args >
+        void emplace_back_drifted(drift_t back_drift, Args&&... args) {
                 assert(0 < size());
-                assert(1 + back().drift > back_drift);
-                auto drift = 1 + back().drift - back_drift;
-                back().drift = back_drift;
-                vector_m.emplace_back(drift, data);
+                assert(1 + drift_of(back()) > back_drift);
+                auto drift = checked(level_t(1) + drift_of(back()) - back_drift);
+                probe_t edit_probe(instrumentation(), tree_op::push_back, vector_m);
+                columns_m.reserve(size() + 1);
+                vector_m.emplace_back(drift, std::forward<Args>(args)...);
+                set_drift(*(end() - 2), back_drift);
+                columns_m.insert(size() - 1, 1);
         }
 
-        void push_back_child(data_t data) {
-                push_back_drifted(data, DRIFT_CHILD);
+        void push_back_child(const data_t& data) { emplace_back_drifted(DRIFT_CHILD, data); }
+        void push_back_child(data_t&& data) { emplace_back_drifted(DRIFT_CHILD, std::move(data)); }
+
+        template< class... Args >
+        void emplace_back_child(Args&&... args) {
+                emplace_back_drifted(DRIFT_CHILD, std::forward<Args>(args)...);
         }
 
-        void push_back_sibling(data_t data) {
-                push_back_drifted(data, DRIFT_SIBLING);
+        void push_back_sibling(const data_t& data) { emplace_back_drifted(DRIFT_SIBLING, data); }
+        void push_back_sibling(data_t&& data) { emplace_back_drifted(DRIFT_SIBLING, std::move(data)); }
+
+        template< class... Args >
+        void emplace_back_sibling(Args&&... args) {
+                emplace_back_drifted(DRIFT_SIBLING, std::forward<Args>(args)...);
         }
 
         // append a node at a specific level
         // O(1) + potential reallocation of the vector
-        void push_back_level(data_t data, level_t level) {
+        void push_back_level(const data_t& data, level_t level) { emplace_back_level(level, data); }
+        void push_back_level(data_t&& data, level_t level) { emplace_back_level(level, std::move(data)); }
+
+        template< class... Args >
+        void emplace_back_level(level_t level, Args&&... args) {
                 assert(0 < size());
-                assert(back().drift > level);
-                back().drift -= level;
-                vector_m.emplace_back(1 + level, data);
+                assert(drift_of(back()) > level);
+                auto drift = checked(level_t(1) + level);
+                probe_t edit_probe(instrumentation(), tree_op::push_back, vector_m);
+                columns_m.reserve(size() + 1);
+                vector_m.emplace_back(drift, std::forward<Args>(args)...);
+                set_drift(*(end() - 2), drift_of(*(end() - 2)) - level);
+                columns_m.insert(size() - 1, 1);
+        }
+
+        // append a node in pre-order, level is at most one below the last node
+        // the first node becomes the root, one level below the last node makes it the first child
+        // O(1) + potential reallocation of the vector
+        void push_at_level(const data_t& data, level_t level) { emplace_at_level(level, data); }
+        void push_at_level(data_t&& data, level_t level) { emplace_at_level(level, std::move(data)); }
+
+        template< class... Args >
+        void emplace_at_level(level_t level, Args&&... args) {
+                if (empty()) {
+                        assert(0 == level);
+                        emplace_root(std::forward<Args>(args)...);
+                }
+                // the last node is at level drift - 1
+                else if (level == level_t(drift_of(back()))) emplace_back_child(std::forward<Args>(args)...);
+                else emplace_back_level(level, std::forward<Args>(args)...);
         }
 
         // remove the last node
-        void pop_back() noexcept {
+        // HINT: the previous node takes over the drift, this may overflow narrow drift types
+        void pop_back() noexcept(traits_t::max_drift() >= std::numeric_limits<level_t>::max()) {
                 assert(1 < size());
-                auto drift = back().drift - 1;
+                auto drift = checked(level_t(drift_of(*(end() - 2))) + drift_of(back()) - 1);
+                probe_t edit_probe(instrumentation(), tree_op::pop_back, vector_m);
                 vector_m.pop_back();
-                back().drift += drift;
+                set_drift(back(), drift);
+                columns_m.erase(size(), 1);
         }
 
         // add a node as the first child of i position
         // O(n)  n = nodes behind the iterator
-        iterator insert_first_child(iterator i, data_t data) {
+        iterator insert_first_child(iterator i, const data_t& data) { return emplace_first_child(i, data); }
+        iterator insert_first_child(iterator i, data_t&& data) { return emplace_first_child(i, std::move(data)); }
+
+        template< class... Args >
+        iterator emplace_first_child(iterator i, Args&&... args) {
                 assert(end() != i);
-                auto drift = 1 + i->drift;
-                i->drift = 0;
-                return vector_m.emplace(i+1, drift, data);
+                auto drift = checked(level_t(1) + drift_of(*i));
+                auto pos = i - begin();
+                probe_t edit_probe(instrumentation(), tree_op::insert_first_child, vector_m);
+                edit_probe.shift(size_type(pos + 1), size() - size_type(pos + 1));
+                columns_m.reserve(size() + 1);
+                auto result = vector_m.emplace(i+1, drift, std::forward<Args>(args)...);
+                set_drift(*(begin() + pos), 0);
+                columns_m.insert(pos + 1, 1);
+                return result;
         }
 
         // add a subtree as the first child of i position
@@ -212,33 +439,137 @@ struct drift_tree
         iterator insert_child_tree(iterator i, InputIt first, InputIt last) {
                 assert(end() != i);
                 auto old_count = size();
+                auto pos = size_type(i - begin()) + 1;
+                probe_t edit_probe(instrumentation(), tree_op::insert_child_tree, vector_m);
                 auto next = vector_m.insert(i+1, first, last);
                 auto inserted = size() - old_count;
                 if (0 < inserted) {
+                        edit_probe.shift(pos, old_count - pos);
+                        edit_probe.scan(inserted);
                         i = next - 1;
-                        auto drift = 1 + i->drift;
-                        i->drift = 0;
-                        while(--inserted) drift += 1 - (next++)->drift;
-                        next->drift = drift;
+                        auto drift = level_t(1) + drift_of(*i);
+                        auto inserted_last = next + inserted - 1;
+                        for (auto it = next; it != inserted_last; ++it) drift += 1 - drift_of(*it);
+                        if (drift > traits_t::max_drift()) {
+                                vector_m.erase(next, inserted_last + 1);
+                                checked(drift);
+                        }
+                        try {
+                                columns_m.reserve(size());
+                        }
+                        catch (...) {
+                                vector_m.erase(next, inserted_last + 1);
+                                throw;
+                        }
+                        set_drift(*i, 0);
+                        set_drift(*inserted_last, drift);
+                        columns_m.insert(size_type(next - begin()), inserted);
                 }
                 return next;
         }
 
+        // add many subtrees as first children with a single rebuild of the vector
+        // entries are pairs of a parent position and a node range (ex. another drift_tree)
+        // entries have to be sorted by position, positions refer to the tree before the call
+        // subtrees for the same parent keep the order of the entries
+        // strong guarantee: the tree is unchanged if a position is invalid or a node copy throws
+        // O(n+m)  n = nodes in the tree
+        //         m = nodes inserted
+        template< class ForwardIt >
+        void insert_child_trees(ForwardIt first, ForwardIt last) {
+                size_type inserted = 0;
+                level_t back_drift = 0;
+                size_type previous = 0;
+                for (auto it = first; it != last; ++it) {
+                        if (it->first >= size()) throw std::out_of_range("drift_tree::insert_child_trees position");
+                        if (it->first < previous)
+                                throw std::invalid_argument("drift_tree::insert_child_trees positions have to be sorted");
+                        previous = it->first;
+                        auto count = std::distance(std::begin(it->second), std::end(it->second));
+                        inserted += count;
+                        if (0 < count) back_drift = drift_of(*std::next(std::begin(it->second), count - 1));
+                        // the last node inserted for a parent takes over the parent drift
+                        auto next = std::next(it);
+                        if (next == last || next->first != it->first) {
+                                checked(back_drift + drift_of((*this)[it->first]));
+                                back_drift = 0;
+                        }
+                }
+                if (0 == inserted) return;
+                probe_t edit_probe(instrumentation(), tree_op::insert_child_trees, vector_m);
+                edit_probe.rebuild(size());
+
+                // the columns insert all runs in one pass after the rebuild
+                std::vector<std::pair<size_t, size_t>> runs;
+                if (columns_m.attached()) {
+                        columns_m.reserve(size() + inserted);
+                        runs.reserve(size_type(std::distance(first, last)));
+                        for (auto it = first; it != last; ++it)
+                                runs.emplace_back(it->first, size_t(std::distance(std::begin(it->second), std::end(it->second))));
+                }
+
+                // once the first node of the tree is moved nothing may throw,
+                // so subtree nodes with a throwing copy are copied aside first
+                vector_t copies(get_allocator());
+                if (nothrow_move && !std::is_nothrow_copy_constructible<value_type>::value) {
+                        copies.reserve(inserted);
+                        for (auto it = first; it != last; ++it)
+                                copies.insert(copies.end(), std::begin(it->second), std::end(it->second));
+                }
+                vector_t result(get_allocator());
+                result.reserve(size() + inserted);
+                auto copy = copies.begin();
+                size_type copied = 0;
+                while (first != last) {
+                        auto parent = first->first;
+                        result.insert(result.end(), move_if_noexcept(begin() + copied), move_if_noexcept(begin() + parent + 1));
+                        copied = parent + 1;
+                        auto drift = drift_of(result.back());
+                        set_drift(result.back(), 0);
+                        for (; first != last && first->first == parent; ++first) {
+                                if (copies.empty()) {
+                                        result.insert(result.end(), std::begin(first->second), std::end(first->second));
+                                        continue;
+                                }
+                                auto count = std::distance(std::begin(first->second), std::end(first->second));
+                                result.insert(result.end(), std::make_move_iterator(copy), std::make_move_iterator(copy + count));
+                                copy += count;
+                        }
+                        set_drift(result.back(), drift_of(result.back()) + drift);
+                }
+                result.insert(result.end(), move_if_noexcept(begin() + copied), move_if_noexcept(end()));
+                vector_m = std::move(result);
+                columns_m.spread(runs.data(), runs.size(), inserted);
+        }
+
         // add left sibling before the node at i position
         // O(n)  n = nodes behind iterator
-        iterator insert_sibling(const_iterator i, data_t data) {
+        iterator insert_sibling(const_iterator i, const data_t& data) { return emplace_sibling(i, data); }
+        iterator insert_sibling(const_iterator i, data_t&& data) { return emplace_sibling(i, std::move(data)); }
+
+        template< class... Args >
+        iterator emplace_sibling(const_iterator i, Args&&... args) {
                 assert(i != end());
                 auto drift = 1;
-                return vector_m.emplace(i, drift, data);
+                auto pos = size_type(i - cbegin());
+                probe_t edit_probe(instrumentation(), tree_op::insert_sibling, vector_m);
+                edit_probe.shift(pos, size() - pos);
+                columns_m.reserve(size() + 1);
+                auto result = vector_m.emplace(i, drift, std::forward<Args>(args)...);
+                columns_m.insert(pos, 1);
+                return result;
         }
 
         // removes a leaf node of the vector
         // O(n)  n = nodes behind iterator
         iterator erase_leaf(iterator i) {
                 assert(i != end());
-                assert(i->is_leaf());
-                auto drift = i->drift - 1;
-                (i-1)->drift += drift;
+                assert(0 != drift_of(*i));
+                auto pos = size_type(i - begin());
+                probe_t edit_probe(instrumentation(), tree_op::erase_leaf, vector_m);
+                edit_probe.shift(pos, size() - pos - 1);
+                set_drift(*(i-1), checked(level_t(drift_of(*(i-1))) + drift_of(*i) - 1));
+                columns_m.erase(pos, 1);
                 return vector_m.erase(i);
         }
 
@@ -246,20 +577,129 @@ struct drift_tree
         iterator erase_subtree(subtree<drift_tree> st);
 
 private:
+        using probe_t = typename instrument_t::template probe<vector_t>;
+
+        static constexpr drift_t checked(level_t drift) { return checked_drift<drift_t>(drift, traits_t::max_drift()); }
+
+        static constexpr bool nothrow_move = std::is_nothrow_move_constructible<value_type>::value;
+
+        // moves nodes that cannot throw on a move, copies the others
+        template< class It >
+        static auto move_if_noexcept(It it) {
+                return std::conditional_t<nothrow_move, std::move_iterator<It>, It>(it);
+        }
+
         vector_t vector_m;
+        // stays empty and costs a branch per edit while no column is attached
+        column_registry columns_m;
+};
+
+// position behind the last descendant of the node at it
+// O(m)  m = nodes in the subtree
+template<typename iterator_t>
+constexpr iterator_t find_subtree_end(iterator_t it) noexcept {
+        using difference_t = std::ptrdiff_t;
+        difference_t level = 1 - difference_t(drift_of(*it));
+        for (++it; level > 0; ++it) level += 1 - difference_t(drift_of(*it));
+        return it;
+}
+
+template<typename _tree_t>
+struct subtree_range;
+
+// a pair of iterators usable in range based for loops
+template<typename _iterator_t>
+struct leveled_range {
+        using iterator = _iterator_t;
+
+        constexpr leveled_range(iterator first, iterator last) noexcept
+                : begin_m(first), end_m(last) {}
+
+        constexpr iterator begin() const noexcept { return begin_m; }
+        constexpr iterator end() const noexcept { return end_m; }
+
+private:
+        iterator begin_m;
+        iterator end_m;
+};
+
+/*!
+ * Only the direct children of a leveled subtree iteration
+ *
+ * Works with forward and reverse subtree iterators, the nodes below
+ * the children are skipped while their levels are tracked.
+ * O(m) for all children  m = nodes in the subtree
+ */
+template<typename _base_t>
+struct child_iterator
+{
+        using base_t = _base_t;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename std::iterator_traits<base_t>::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = decltype(std::declval<const base_t&>().operator->());
+        using reference = decltype(*std::declval<const base_t&>());
+
+        child_iterator() = default;
+        constexpr explicit child_iterator(base_t base) noexcept
+                : base_m(base) {
+                skip();
+        }
+
+        constexpr bool is_end() const noexcept { return base_m.is_end(); }
+
+        constexpr bool operator == (const child_iterator &ot) const noexcept { return base_m == ot.base_m; }
+        constexpr bool operator != (const child_iterator &ot) const noexcept { return base_m != ot.base_m; }
+
+        constexpr reference operator*() const noexcept { return *base_m; }
+        constexpr pointer operator->() const noexcept { return base_m.operator->(); }
+
+        constexpr child_iterator& operator++() noexcept {
+                ++base_m;
+                skip();
+                return *this;
+        }
+        constexpr child_iterator operator++(int) noexcept {
+                auto __tmp = *this;
+                ++(*this);
+                return __tmp;
+        }
+
+        constexpr auto unwrap() const noexcept { return base_m.unwrap(); }
+        constexpr base_t base() const noexcept { return base_m; }
+
+private:
+        constexpr void skip() noexcept {
+                while (!base_m.is_end() && base_m.level() != 1) ++base_m;
+        }
+
+        base_t base_m = {};
 };
 
+// HINT: use subtree<const tree_t> to iterate const trees
 template<typename _tree_t>
 struct subtree {
         using tree_t = _tree_t;
         using level_t = typename tree_t::level_t;
-        using node_t = typename tree_t::value_type;
-        using iterator_t = typename tree_t::iterator;
-
-        struct iterator : public std::iterator< std::forward_iterator_tag, typename _tree_t::value_type>
+        using node_t = std::conditional_t<std::is_const<tree_t>::value,
+                const typename tree_t::value_type, typename tree_t::value_type>;
+        using iterator_t = std::conditional_t<std::is_const<tree_t>::value,
+                typename tree_t::const_iterator, typename tree_t::iterator>;
+
+        using difference_t = std::ptrdiff_t;
+
+        // levels are relative to the root and tracked in both directions
+        // forward:  level(i+1) = level(i) + 1 - drift(i)
+        // backward: level(i-1) = level(i) - 1 + drift(i-1)
+        // the iterator is at the end while the level is not positive
+        struct iterator : public std::iterator< std::bidirectional_iterator_tag, typename _tree_t::value_type>
         {
-                explicit iterator(iterator_t it) noexcept
-                        : it_m(it + 1), level_m(it->drift == 0 ? 1 : 0) {
+                constexpr explicit iterator(iterator_t it) noexcept
+                        : it_m(it + 1), level_m(1 - difference_t(drift_of(*it))) {
+                }
+                // node at it with the signed level relative to the root
+                constexpr iterator(iterator_t it, difference_t level) noexcept
+                        : it_m(it), level_m(level) {
                 }
 
                 iterator() = default;
@@ -269,81 +709,213 @@ struct subtree {
                 iterator& operator =(const iterator&) = default;
                 iterator& operator =(iterator&&) = default;
 
-                static iterator end() noexcept { return iterator(); }
+                static constexpr iterator end() noexcept { return iterator(); }
 
-                bool is_end() const noexcept {
-                        return level_m == 0;
+                constexpr bool is_end() const noexcept {
+                        return level_m <= 0;
                 }
 
-                bool operator == (const iterator &ot) const noexcept {
+                constexpr bool operator == (const iterator &ot) const noexcept {
                         if (this->is_end() || ot.is_end())
-                                return level_m == ot.level_m;
+                                return this->is_end() == ot.is_end();
                         return it_m == ot.it_m;
                 }
-                bool operator != (const iterator &ot) const noexcept {
+                constexpr bool operator != (const iterator &ot) const noexcept {
                         return ! (*this == ot);
                 }
 
-                auto operator*() const noexcept {
-                        return static_cast<const node_t&>(*it_m);
-                }
-                auto operator*() noexcept {
-                        return static_cast<node_t&>(*it_m);
-                }
+                constexpr node_t& operator*() const noexcept { return *it_m; }
+                constexpr node_t* operator->() const noexcept { return &*it_m; }
 
-                auto operator++() noexcept {
-                        level_m += 1;
-                        if (level_m < it_m->drift)
-                                level_m = 0;
-                        else
-                                level_m -= it_m->drift;
+                constexpr auto operator++() noexcept {
+                        level_m += 1 - difference_t(drift_of(*it_m));
                         it_m++;
                         return static_cast<iterator&>(*this);
                 }
 
-                auto operator++(int) noexcept {
+                constexpr auto operator++(int) noexcept {
                         auto __tmp = *this;
                         ++(*this);
                         return __tmp;
                 }
 
-                auto unwrap() const noexcept { return it_m; }
-                auto level() const noexcept { return level_m; }
+                // HINT: the end() sentinel has no position, use subtree_range::leveled_end()
+                constexpr auto operator--() noexcept {
+                        it_m--;
+                        level_m += difference_t(drift_of(*it_m)) - 1;
+                        return static_cast<iterator&>(*this);
+                }
+
+                constexpr auto operator--(int) noexcept {
+                        auto __tmp = *this;
+                        --(*this);
+                        return __tmp;
+                }
+
+                constexpr auto unwrap() const noexcept { return it_m; }
+                constexpr level_t level() const noexcept { return level_t(level_m); }
 
         private:
                 iterator_t it_m = {};
-                level_t level_m = {};
+                difference_t level_m = {};
         };
 
-        explicit subtree(iterator_t it) noexcept
+        // walks the descendants from the last to the first one with level tracking
+        // the root itself is reached at level 0 and ends the iteration
+        struct reverse_iterator : public std::iterator< std::bidirectional_iterator_tag, typename _tree_t::value_type>
+        {
+                reverse_iterator() = default;
+                // starts at the node before the leveled position
+                constexpr explicit reverse_iterator(iterator base) noexcept
+                        : current_m(--base) {}
+
+                static constexpr reverse_iterator end() noexcept { return reverse_iterator(); }
+
+                constexpr bool is_end() const noexcept { return current_m.is_end(); }
+
+                constexpr bool operator == (const reverse_iterator &ot) const noexcept {
+                        return current_m == ot.current_m;
+                }
+                constexpr bool operator != (const reverse_iterator &ot) const noexcept {
+                        return ! (*this == ot);
+                }
+
+                constexpr node_t& operator*() const noexcept { return *current_m; }
+                constexpr node_t* operator->() const noexcept { return &*current_m; }
+
+                constexpr auto operator++() noexcept {
+                        --current_m;
+                        return static_cast<reverse_iterator&>(*this);
+                }
+                constexpr auto operator++(int) noexcept {
+                        auto __tmp = *this;
+                        ++(*this);
+                        return __tmp;
+                }
+                constexpr auto operator--() noexcept {
+                        ++current_m;
+                        return static_cast<reverse_iterator&>(*this);
+                }
+                constexpr auto operator--(int) noexcept {
+                        auto __tmp = *this;
+                        --(*this);
+                        return __tmp;
+                }
+
+                constexpr iterator base() const noexcept {
+                        auto it = current_m;
+                        return ++it;
+                }
+                constexpr auto unwrap() const noexcept { return current_m.unwrap(); }
+                constexpr level_t level() const noexcept { return current_m.level(); }
+
+        private:
+                iterator current_m = {};
+        };
+
+        constexpr explicit subtree(iterator_t it) noexcept
                 : it_m(it) {}
 
-        auto begin() const noexcept { return iterator(it_m); }
-        auto end() const noexcept { return iterator::end(); }
+        constexpr auto begin() const noexcept { return iterator(it_m); }
+        constexpr auto end() const noexcept { return iterator::end(); }
+
+        constexpr auto unwrap() const noexcept { return it_m; }
 
-        auto unwrap() const noexcept { return it_m; }
+        // direct children from the first to the last one
+        constexpr leveled_range<child_iterator<iterator>> children() const noexcept {
+                return {child_iterator<iterator>(begin()), child_iterator<iterator>(end())};
+        }
+
+        // contiguous random access view of all descendants
+        // O(m)  m = nodes in the subtree
+        constexpr subtree_range<tree_t> range() const noexcept { return subtree_range<tree_t>(it_m); }
 
 private:
         iterator_t it_m = {};
 };
 
-template< typename _data_t, typename _drift_t, typename _alloc_t>
-typename drift_tree<_data_t, _drift_t, _alloc_t>::iterator
-drift_tree<_data_t, _drift_t, _alloc_t>::erase_subtree(subtree<drift_tree<_data_t, _drift_t, _alloc_t>> st)
+/*!
+ * All descendants of a node as a contiguous range of the tree vector
+ *
+ * The end is resolved once on construction, afterwards the range behaves
+ * like a random access container of node references.
+ * Structural changes of the tree invalidate the range.
+ */
+template<typename _tree_t>
+struct subtree_range {
+        using tree_t = _tree_t;
+        using level_t = typename tree_t::level_t;
+        using iterator = typename subtree<tree_t>::iterator_t;
+        using reference = typename std::iterator_traits<iterator>::reference;
+        using size_type = typename tree_t::size_type;
+        using difference_type = typename tree_t::difference_type;
+        using leveled_iterator = typename subtree<tree_t>::iterator;
+        using reverse_leveled_iterator = typename subtree<tree_t>::reverse_iterator;
+
+        // O(m)  m = nodes in the subtree
+        constexpr explicit subtree_range(iterator root) noexcept
+                : root_m(root), end_m(root + 1), end_level_m(1 - difference_type(drift_of(*root))) {
+                for (; end_level_m > 0; ++end_m) end_level_m += 1 - difference_type(drift_of(*end_m));
+        }
+
+        constexpr iterator begin() const noexcept { return root_m + 1; }
+        constexpr iterator end() const noexcept { return end_m; }
+
+        constexpr bool empty() const noexcept { return end_m == root_m + 1; }
+        constexpr size_type size() const noexcept { return end_m - root_m - 1; }
+
+        constexpr reference operator[](size_type pos) const noexcept { return root_m[1 + pos]; }
+        constexpr reference front() const noexcept { return root_m[1]; }
+        constexpr reference back() const noexcept { return end_m[-1]; }
+
+        constexpr iterator root() const noexcept { return root_m; }
+
+        // level of the node at it relative to the root
+        // O(k)  k = distance from the root
+        constexpr level_t level_of(iterator it) const noexcept {
+                level_t level = 0;
+                for (auto i = root_m; i != it; ++i) level = level + 1 - drift_of(*i);
+                return level;
+        }
+
+        // forward iteration with level tracking
+        constexpr subtree<tree_t> leveled() const noexcept { return subtree<tree_t>(root_m); }
+
+        // leveled position behind the last descendant, can be decremented
+        constexpr leveled_iterator leveled_end() const noexcept { return leveled_iterator(end_m, end_level_m); }
+
+        // backward iteration with level tracking, from the last descendant to the first one
+        constexpr leveled_range<reverse_leveled_iterator> reversed() const noexcept {
+                return {reverse_leveled_iterator(leveled_end()), reverse_leveled_iterator::end()};
+        }
+
+        // direct children from the last to the first one
+        constexpr leveled_range<child_iterator<reverse_leveled_iterator>> reverse_children() const noexcept {
+                using child_t = child_iterator<reverse_leveled_iterator>;
+                return {child_t(reverse_leveled_iterator(leveled_end())), child_t(reverse_leveled_iterator::end())};
+        }
+
+private:
+        iterator root_m;
+        iterator end_m;
+        difference_type end_level_m;  // signed level at end_m relative to the root
+};
+
+template< typename _data_t, typename _drift_t, typename _alloc_t, typename _vector_t, typename _instrument_t>
+typename drift_tree<_data_t, _drift_t, _alloc_t, _vector_t, _instrument_t>::iterator
+drift_tree<_data_t, _drift_t, _alloc_t, _vector_t, _instrument_t>::erase_subtree(subtree<drift_tree> st)
 {
-        using std::begin;
-        using std::end;
-        auto st_it = begin(st);
-        auto vec_begin = st_it.unwrap();
-        level_t level = st_it.level();
-        while(st_it != end(st)) {
-                level = st_it.level();
-                ++st_it;
-        }
-        auto vec_end = st_it.unwrap();
-        auto drift = (vec_end - 1)->drift - level;
-        st.unwrap()->drift = drift;
-        return vector_m.erase(vec_begin, vec_end);
+        // the root takes over the level change behind its subtree
+        auto root = st.unwrap();
+        difference_type level = 1 - difference_type(drift_of(*root));
+        auto vec_end = root + 1;
+        for (; level > 0; ++vec_end) level += 1 - difference_type(drift_of(*vec_end));
+        probe_t edit_probe(instrumentation(), tree_op::erase_subtree, vector_m);
+        edit_probe.scan(size_type(vec_end - root));
+        if (vec_end != root + 1) edit_probe.shift(size_type(root + 1 - begin()), size_type(end() - vec_end));
+        set_drift(*root, 1 - level);
+        columns_m.erase(size_type(root + 1 - begin()), size_type(vec_end - root - 1));
+        return vector_m.erase(root + 1, vec_end);
 }
 
 } // namespace vt
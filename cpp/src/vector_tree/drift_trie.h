@@ -0,0 +1,354 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vt {
+
+// one node of a drift_trie, the edge label leads from the parent to this node
+template<typename _value_t>
+struct trie_entry
+{
+        using value_t = _value_t;
+
+        uint32_t label = 0;             // offset into the label bytes of the trie
+        uint32_t label_size = 0;
+        uint32_t children = 0;          // offset into the child tables of the trie
+        uint32_t child_count = 0;
+        bool has_value = false;
+        value_t value = {};
+};
+
+/* keys: "in" "inn" "tea" "ted" "ten"
+ *
+ * ""
+ *  "in"=1    "te"
+ *   "n"=2     "a"=3 "d"=4 "n"=5
+ *
+ * <0,""> <0,"in"> <2,"n"> <0,"te"> <1,"a"> <1,"d"> <3,"n">
+ */
+
+/*!
+ * Compressed (Patricia) trie of string keys stored in a drift_tree
+ *
+ * Every node holds the bytes of its edge, so chains without branches are a single node.
+ * The children of a node are sorted by their first byte, the trie keeps a table of
+ * first bytes and positions per node. Lookups search it with one SSE2 compare
+ * for up to 16 children and with a binary search otherwise.
+ *
+ * All keys with a common prefix are the subtree of one node, so prefix enumeration
+ * is a linear scan of a contiguous range of the tree.
+ *
+ * std::vector<std::pair<std::string, int>> routes = {{"10.0", 1}, {"10.0.1", 2}, {"192.168", 3}};
+ * vt::drift_trie<int> trie(routes.begin(), routes.end());
+ * auto match = trie.longest_prefix("10.0.1.7"); // match.length == 6, *match.value == 2
+ *
+ * The trie is immutable, build a new one to change the keys.
+ * The drift type limits the number of nodes on a path, which is at most the key length + 1.
+ */
+template<typename _value_t, typename _drift_t = uint32_t>
+struct drift_trie
+{
+        using value_t = _value_t;
+        using entry_t = trie_entry<value_t>;
+        using tree_t = drift_tree<entry_t, _drift_t>;
+        using size_type = size_t;
+
+        // a key prefix with the value stored for it
+        struct match
+        {
+                size_t length = 0;
+                const value_t* value = nullptr;
+
+                explicit operator bool() const noexcept { return value != nullptr; }
+        };
+
+        drift_trie() = default;
+
+        /*!
+         * Builds the trie from pairs of key and value sorted by key
+         *
+         * O(k)  k = bytes of all keys
+         * throws std::invalid_argument if the keys are not sorted or not unique
+         */
+        template<typename RandomIt>
+        drift_trie(RandomIt first, RandomIt last) {
+                for (auto it = first; it != last && it + 1 != last; ++it)
+                        if (!(it->first < (it + 1)->first))
+                                throw std::invalid_argument("drift_trie keys have to be sorted and unique");
+                keys_m = size_type(last - first);
+                if (first == last) return;
+                build(first);
+                child_bytes_m.resize(child_bytes_m.size() + simd_width);
+        }
+
+        bool empty() const noexcept { return 0 == keys_m; }
+        // number of keys
+        size_type size() const noexcept { return keys_m; }
+        const tree_t& tree() const noexcept { return tree_m; }
+
+        // the value of the key or nullptr
+        // O(l)  l = length of the key
+        const value_t* find(const char* key, size_t length) const noexcept {
+                size_t depth = 0;
+                auto pos = descend(key, length, depth, [](size_t, const entry_t&) {});
+                if (npos == pos || depth != length) return nullptr;
+                const auto& entry = tree_m[pos].data;
+                return entry.has_value ? &entry.value : nullptr;
+        }
+        const value_t* find(const std::string& key) const noexcept { return find(key.data(), key.size()); }
+
+        bool contains(const std::string& key) const noexcept { return find(key) != nullptr; }
+
+        // the longest key that is a prefix of key, ex. routing tables
+        // O(l)  l = length of the key
+        match longest_prefix(const char* key, size_t length) const noexcept {
+                match result;
+                size_t depth = 0;
+                descend(key, length, depth, [&](size_t matched, const entry_t& entry) {
+                        if (!entry.has_value) return;
+                        result.value = &entry.value;
+                        result.length = matched;
+                });
+                return result;
+        }
+        match longest_prefix(const std::string& key) const noexcept { return longest_prefix(key.data(), key.size()); }
+
+        /*!
+         * The nodes [first, last) of the tree holding all keys starting with prefix
+         *
+         * first == last if no key starts with prefix
+         * O(l + m)  l = length of the prefix, m = nodes in the range
+         */
+        std::pair<size_type, size_type> prefix_range(const std::string& prefix) const noexcept {
+                size_t depth = 0;
+                auto pos = locate(prefix, depth);
+                if (npos == pos) return {0, 0};
+                return {pos, size_type(find_subtree_end(tree_m.begin() + pos) - tree_m.begin())};
+        }
+
+        // number of keys starting with prefix
+        // O(l + m)  l = length of the prefix, m = nodes of the prefix range
+        size_type count_prefixed(const std::string& prefix) const noexcept {
+                auto range = prefix_range(prefix);
+                size_type count = 0;
+                for (auto pos = range.first; pos < range.second; ++pos) count += tree_m[pos].data.has_value;
+                return count;
+        }
+
+        /*!
+         * Calls fn(key, value) for all keys starting with prefix in sorted order
+         *
+         * The keys are rebuilt from the edge labels while the range is scanned, the key
+         * passed to fn is reused for the next call.
+         * O(l + m + k)  l = length of the prefix, m = nodes of the range, k = bytes of the keys
+         */
+        template<typename Fn>
+        void for_each_prefixed(const std::string& prefix, Fn fn) const {
+                size_t depth = 0;
+                auto pos = locate(prefix, depth);
+                if (npos == pos) return;
+                std::string key(prefix, 0, depth);
+                // key length in front of each level of the scanned subtree
+                std::vector<size_t> lengths(1, depth);
+                std::ptrdiff_t level = 0;
+                do {
+                        const auto& node = tree_m[pos++];
+                        const auto& entry = node.data;
+                        key.resize(lengths[size_t(level)]);
+                        key.append(labels_m, entry.label, entry.label_size);
+                        if (entry.has_value) fn(static_cast<const std::string&>(key), entry.value);
+                        lengths.resize(size_t(level) + 1);
+                        lengths.push_back(key.size());
+                        level += 1 - std::ptrdiff_t(drift_of(node));
+                } while (level > 0);
+        }
+
+        // calls fn(key, value) for all keys in sorted order
+        template<typename Fn>
+        void for_each(Fn fn) const { for_each_prefixed(std::string(), fn); }
+
+        // heap bytes of the labels and child tables, the nodes are counted by memory_report(tree())
+        size_t memory_bytes() const noexcept {
+                return labels_m.capacity() + child_bytes_m.capacity()
+                        + child_positions_m.capacity() * sizeof(uint32_t);
+        }
+
+private:
+        static constexpr size_type npos = std::numeric_limits<size_type>::max();
+        // the byte table is padded for unaligned 16 byte loads behind the last table
+        static constexpr size_t simd_width = 16;
+
+        /*!
+         * Follows the key from the root while the edge labels match
+         *
+         * Calls visit(depth, entry) for every node whose label matched completely,
+         * depth is the length of the key up to and including the label.
+         * Returns the last matched node or npos, depth is the matched key length.
+         */
+        template<typename Visit>
+        size_type descend(const char* key, size_t length, size_t& depth, Visit visit) const noexcept {
+                if (tree_m.empty()) return npos;
+                size_type pos = 0;
+                depth = 0;
+                while (true) {
+                        const auto& entry = tree_m[pos].data;
+                        if (entry.label_size > length - depth
+                            || 0 != std::memcmp(labels_m.data() + entry.label, key + depth, entry.label_size))
+                                return npos;
+                        depth += entry.label_size;
+                        visit(depth, entry);
+                        if (depth == length) return pos;
+                        auto child = find_child(entry, uint8_t(key[depth]));
+                        if (npos == child) return pos;
+                        pos = child;
+                }
+        }
+
+        // the node whose subtree holds all keys starting with prefix, depth is the key length in front of it
+        size_type locate(const std::string& prefix, size_t& depth) const noexcept {
+                if (tree_m.empty()) return npos;
+                size_type pos = 0;
+                depth = 0;
+                while (true) {
+                        const auto& entry = tree_m[pos].data;
+                        auto compared = std::min<size_t>(entry.label_size, prefix.size() - depth);
+                        if (0 != std::memcmp(labels_m.data() + entry.label, prefix.data() + depth, compared))
+                                return npos;
+                        // the prefix ends inside or at the end of this label
+                        if (depth + entry.label_size >= prefix.size()) return pos;
+                        auto child = find_child(entry, uint8_t(prefix[depth + entry.label_size]));
+                        if (npos == child) return npos;
+                        depth += entry.label_size;
+                        pos = child;
+                }
+        }
+
+        // position of the child whose label starts with byte or npos
+        size_type find_child(const entry_t& entry, uint8_t byte) const noexcept {
+                if (0 == entry.child_count) return npos;
+                auto bytes = child_bytes_m.data() + entry.children;
+#if defined(__SSE2__)
+                if (entry.child_count <= simd_width) {
+                        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+                        auto mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(char(byte)))));
+                        mask &= (1u << entry.child_count) - 1;
+                        return mask ? child_positions_m[entry.children + unsigned(__builtin_ctz(mask))] : npos;
+                }
+#endif
+                auto last = bytes + entry.child_count;
+                auto it = std::lower_bound(bytes, last, byte);
+                return it != last && *it == byte ? child_positions_m[entry.children + size_t(it - bytes)] : npos;
+        }
+
+        static uint32_t checked_offset(size_t offset) {
+                return offset > std::numeric_limits<uint32_t>::max()
+                        ? throw std::length_error("drift_trie exceeds 32 bit offsets")
+                        : uint32_t(offset);
+        }
+
+        // the keys [first, last) share the first depth bytes, slot is their entry in the child table of the parent
+        struct build_task
+        {
+                size_t first;
+                size_t last;
+                size_t depth;
+                size_t level;
+                size_t slot;
+        };
+
+        /*!
+         * Appends the nodes in pre-order, a stack of pending subtrees replaces the recursion
+         *
+         * The label of a node is the common prefix behind depth, sorted keys share the common prefix
+         * of the first and the last key. The children are the runs of keys with the same byte behind the label.
+         */
+        template<typename RandomIt>
+        void build(RandomIt pairs) {
+                std::vector<build_task> tasks = {{0, keys_m, 0, 0, npos}};
+                while (!tasks.empty()) {
+                        auto task = tasks.back();
+                        tasks.pop_back();
+                        const std::string& low = pairs[task.first].first;
+                        const std::string& high = pairs[task.last - 1].first;
+                        auto end = task.depth;
+                        while (end < low.size() && end < high.size() && low[end] == high[end]) ++end;
+
+                        entry_t entry;
+                        entry.label = checked_offset(labels_m.size());
+                        entry.label_size = checked_offset(end - task.depth);
+                        labels_m.append(low, task.depth, end - task.depth);
+                        if (low.size() == end) {
+                                entry.has_value = true;
+                                entry.value = pairs[task.first].second;
+                                ++task.first;
+                        }
+
+                        auto byte_at = [&](size_t i) { return uint8_t(pairs[i].first[end]); };
+                        auto run_end = [&](size_t i) {
+                                auto byte = byte_at(i);
+                                auto it = std::partition_point(pairs + std::ptrdiff_t(i), pairs + std::ptrdiff_t(task.last),
+                                                               [&](const auto& pair) { return uint8_t(pair.first[end]) == byte; });
+                                return size_t(it - pairs);
+                        };
+                        auto table = child_bytes_m.size();
+                        auto pending = tasks.size();
+                        for (auto i = task.first; i < task.last;) {
+                                auto next = run_end(i);
+                                child_bytes_m.push_back(byte_at(i));
+                                tasks.push_back({i, next, end, task.level + 1, child_bytes_m.size() - 1});
+                                i = next;
+                        }
+                        // the first child is built first
+                        std::reverse(tasks.begin() + std::ptrdiff_t(pending), tasks.end());
+                        entry.children = checked_offset(table);
+                        entry.child_count = checked_offset(child_bytes_m.size() - table);
+                        child_positions_m.resize(child_bytes_m.size());
+
+                        if (npos != task.slot) child_positions_m[task.slot] = checked_offset(tree_m.size());
+                        tree_m.push_at_level(std::move(entry), task.level);
+                }
+        }
+
+        tree_t tree_m;
+        size_type keys_m = 0;
+        // edge labels of all nodes in tree order
+        std::string labels_m;
+        // first bytes and positions of the children of each node, sorted by byte
+        std::vector<uint8_t> child_bytes_m;
+        std::vector<uint32_t> child_positions_m;
+};
+
+} // namespace vt
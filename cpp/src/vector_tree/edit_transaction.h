@@ -0,0 +1,292 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include <utility>
+
+namespace vt {
+
+/*!
+ * Records edits of a drift_tree and applies them with a single rebuild
+ *
+ * All positions refer to the tree as it was when the transaction started.
+ * The tree is not touched before commit(), so a rollback is only a truncation
+ * of the recorded edits. Savepoints allow nested rollbacks.
+ *
+ * The result matches the eager calls in recording order:
+ * - siblings inserted before the same node keep their order
+ * - the last child inserted as first child of a node ends up first
+ * - erase_children() also drops children inserted before it
+ *
+ * Attached side columns keep the values of the original nodes,
+ * inserted nodes get value initialized entries.
+ * The instrumentation of the tree counts a commit as one storage rebuild.
+ *
+ * HINT: erase_children() drops the edits recorded before it below the node,
+ *       edits recorded after it must not refer to the erased nodes
+ * HINT: erase_leaf() needs a leaf without inserted children
+ * Both preconditions are asserted when commit() walks the edits.
+ */
+template<typename _tree_t>
+struct edit_transaction
+{
+        using tree_t = _tree_t;
+        using node_t = typename tree_t::node_t;
+        using data_t = typename tree_t::data_t;
+        using drift_t = typename tree_t::drift_t;
+        using level_t = typename tree_t::level_t;
+        using size_type = typename tree_t::size_type;
+
+        // marks the recorded state for a later rollback
+        struct savepoint {
+                size_type edits;
+                size_type nodes;
+        };
+
+        explicit edit_transaction(tree_t& tree) noexcept
+                : tree_m(tree) {}
+
+        edit_transaction(const edit_transaction&) = delete;
+        edit_transaction& operator =(const edit_transaction&) = delete;
+
+        bool empty() const noexcept { return edits_m.empty(); }
+        // number of recorded edits
+        size_type size() const noexcept { return edits_m.size(); }
+
+        // add a node as the first child of the original node at pos
+        template< class... Args >
+        void emplace_first_child(size_type pos, Args&&... args) {
+                assert(pos < tree_m.size());
+                record(pos, edit_kind::first_child, [&] { nodes_m.emplace_back(drift_t(1), std::forward<Args>(args)...); });
+        }
+        void insert_first_child(size_type pos, const data_t& data) { emplace_first_child(pos, data); }
+        void insert_first_child(size_type pos, data_t&& data) { emplace_first_child(pos, std::move(data)); }
+
+        // add a subtree as the first child of the original node at pos
+        // the nodes form a complete tree, ex. the nodes of another drift_tree
+        template< class InputIt >
+        void insert_child_tree(size_type pos, InputIt first, InputIt last) {
+                assert(pos < tree_m.size());
+                record(pos, edit_kind::first_child, [&] { nodes_m.insert(nodes_m.end(), first, last); });
+        }
+
+        // add a left sibling before the original node at pos
+        template< class... Args >
+        void emplace_sibling(size_type pos, Args&&... args) {
+                assert(pos < tree_m.size());
+                record(pos, edit_kind::sibling, [&] { nodes_m.emplace_back(drift_t(1), std::forward<Args>(args)...); });
+        }
+        void insert_sibling(size_type pos, const data_t& data) { emplace_sibling(pos, data); }
+        void insert_sibling(size_type pos, data_t&& data) { emplace_sibling(pos, std::move(data)); }
+
+        // add a subtree as left sibling before the original node at pos
+        template< class InputIt >
+        void insert_sibling_tree(size_type pos, InputIt first, InputIt last) {
+                assert(pos < tree_m.size());
+                record(pos, edit_kind::sibling, [&] { nodes_m.insert(nodes_m.end(), first, last); });
+        }
+
+        // remove all descendants of the original node at pos
+        void erase_children(size_type pos) {
+                assert(pos < tree_m.size());
+                record(pos, edit_kind::erase_children, [] {});
+        }
+
+        // remove the original leaf node at pos
+        void erase_leaf(size_type pos) {
+                assert(pos < tree_m.size());
+                assert(0 != drift_of(tree_m[pos]));
+                record(pos, edit_kind::erase_leaf, [] {});
+        }
+
+        savepoint save() const noexcept { return {edits_m.size(), nodes_m.size()}; }
+
+        // forget all edits recorded after the savepoint
+        void rollback(savepoint sp) noexcept {
+                assert(sp.edits <= edits_m.size() && sp.nodes <= nodes_m.size());
+                edits_m.erase(edits_m.begin() + sp.edits, edits_m.end());
+                nodes_m.erase(nodes_m.begin() + sp.nodes, nodes_m.end());
+        }
+
+        // forget all edits
+        void rollback() noexcept {
+                edits_m.clear();
+                nodes_m.clear();
+        }
+
+        // apply all edits with one pass over the tree
+        // moved(original, position) is called for every original node that is kept
+        // HINT: a throwing move of the data leaves moved-from nodes in the tree
+        // O(n + m + k log k)  n = nodes in the tree
+        //                     m = nodes inserted
+        //                     k = edits
+        template< class Fn >
+        void commit(Fn moved) {
+                if (edits_m.empty()) return;
+                // the recorded order stays intact for savepoints until the commit succeeds
+                auto edits = edits_m;
+                std::stable_sort(edits.begin(), edits.end(),
+                                 [](const auto& l, const auto& r) { return l.anchor < r.anchor; });
+                // narrow drift types may overflow, check before any data is moved
+                if (sizeof(drift_t) < sizeof(level_t)) {
+                        level_t back_level = 0;
+                        bool first = true;
+                        walk(edits, [&](node_t*, level_t level, bool) {
+                                if (!first) checked(back_drift(back_level, level));
+                                first = false;
+                                back_level = level;
+                        });
+                        checked(1 + back_level);
+                }
+
+                tree_t result(tree_m.get_allocator());
+                result.reserve(tree_m.size() + nodes_m.size());
+                // attached columns follow the original positions of the nodes
+                auto& columns = tree_m.columns();
+                std::vector<size_t> sources;
+                if (columns.attached()) {
+                        sources.reserve(tree_m.size() + nodes_m.size());
+                        columns.prepare_gather(tree_m.size() + nodes_m.size());
+                }
+                level_t back_level = 0;
+                walk(edits, [&](node_t* node, level_t level, bool original) {
+                        if (original) moved(size_type(node - &tree_m[0]), result.size());
+                        if (columns.attached())
+                                sources.push_back(original ? size_t(node - &tree_m[0]) : column_registry::npos);
+                        if (result.empty())
+                                result.emplace_root(std::move(node->data));
+                        else
+                                result.emplace_back_drifted(drift_t(back_drift(back_level, level)), std::move(node->data));
+                        back_level = level;
+                });
+                columns.gather(sources.data(), sources.size());
+                result.columns() = std::move(columns);
+                tree_m.adopt(std::move(result));
+                rollback();
+        }
+
+        void commit() {
+                commit([](size_type, size_type) {});
+        }
+
+private:
+        enum class edit_kind : uint8_t { sibling, first_child, erase_children, erase_leaf };
+
+        struct edit {
+                size_type anchor;
+                edit_kind kind;
+                size_type first;  // inserted nodes in nodes_m
+                size_type last;
+                size_type order;  // position in the recorded order
+        };
+
+        static drift_t checked(level_t drift) {
+                return checked_drift<drift_t>(drift, tree_t::traits_t::max_drift());
+        }
+
+        // drift of the previous node when the next one is at level
+        // HINT: a level more than one below the previous node means a broken edit, ex. a child of an erased leaf
+        static level_t back_drift(level_t back_level, level_t level) noexcept {
+                assert(level <= back_level + 1);
+                return 1 + back_level - level;
+        }
+
+        template< class Fn >
+        void record(size_type pos, edit_kind kind, Fn add_nodes) {
+                auto first = nodes_m.size();
+                add_nodes();
+                try {
+                        edits_m.push_back({pos, kind, first, nodes_m.size(), edits_m.size()});
+                }
+                catch (...) {
+                        nodes_m.erase(nodes_m.begin() + first, nodes_m.end());
+                        throw;
+                }
+        }
+
+        // calls emit(node, level, original) for every node of the result in order
+        template< class Fn >
+        void emit_nodes(const edit& e, level_t base, Fn& emit) {
+                std::ptrdiff_t level = 0;
+                for (auto i = e.first; i != e.last; ++i) {
+                        emit(&nodes_m[i], level_t(base + level), false);
+                        level += 1 - std::ptrdiff_t(drift_of(nodes_m[i]));
+                }
+        }
+
+        // edits sorted by anchor
+        template< class Fn >
+        void walk(const std::vector<edit>& edits, Fn emit) {
+                auto e = edits.begin();
+                level_t level = 0;
+                bool skipping = false;
+                level_t skip_level = 0;
+                size_type skip_order = 0;
+                for (size_type pos = 0; pos < tree_m.size(); ++pos) {
+                        auto node = &tree_m[pos];
+                        auto node_level = level;
+                        level = level + 1 - drift_of(*node);
+                        auto edits_begin = e;
+                        while (e != edits.end() && e->anchor == pos) ++e;
+                        if (skipping && node_level > skip_level) {
+                                // edits recorded after erase_children() would refer to an erased node
+                                assert(std::all_of(edits_begin, e, [=](const edit& dropped) { return dropped.order < skip_order; }));
+                                (void)skip_order;
+                                continue;
+                        }
+                        skipping = false;
+
+                        auto erase_leaf = false;
+                        auto children_from = edits_begin;
+                        for (auto it = edits_begin; it != e; ++it) {
+                                if (it->kind == edit_kind::sibling) emit_nodes(*it, node_level, emit);
+                                else if (it->kind == edit_kind::erase_leaf) erase_leaf = true;
+                                else if (it->kind == edit_kind::erase_children) children_from = it + 1;
+                        }
+                        // the inserted children would lose their parent
+                        assert(!erase_leaf || std::none_of(children_from, e, [](const edit& child) {
+                                return child.kind == edit_kind::first_child;
+                        }));
+                        if (!erase_leaf) emit(node, node_level, true);
+                        for (auto it = e; it != children_from; --it) {
+                                auto& child = *(it - 1);
+                                if (child.kind == edit_kind::first_child) emit_nodes(child, node_level + 1, emit);
+                        }
+                        // erase_children() drops the original descendants behind the inserted children
+                        if (children_from != edits_begin) {
+                                skipping = true;
+                                skip_level = node_level;
+                                skip_order = (children_from - 1)->order;
+                        }
+                }
+        }
+
+        tree_t& tree_m;
+        std::vector<edit> edits_m;
+        std::vector<node_t> nodes_m;
+};
+
+} // namespace vt
@@ -0,0 +1,224 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include <cassert>
+
+namespace vt {
+
+/* (1 + 2) * x
+ *
+ * *
+ *  +     x
+ *   1 2
+ *
+ * <0,*> <0,+> <1,1> <2,2> <2,x>
+ * reverse: x opens the frame of *, 2 opens the frame of +
+ *          + takes 2 values, * takes 2 values
+ */
+
+namespace detail {
+
+/*!
+ * One reverse pass over the complete subtrees in [first, last)
+ *
+ * The values grow downwards from top, so the children of a node are in order
+ * at args[0] .. args[arity - 1] when the node is applied.
+ * A leaf with drift d is the last node of d - 1 enclosing subtrees, it opens one frame
+ * per enclosing node. Frames count the finished children until their node is reached.
+ * The first frame is a sentinel for the roots. Only the last node can open frames
+ * of nodes in front of first, they stay open.
+ *
+ * apply(data, args, arity, result) computes the value of one node
+ * Returns the new top, the value of the first root.
+ */
+template<typename iterator_t, typename stack_value_t, typename Apply>
+stack_value_t* reverse_pass(iterator_t first, iterator_t last, stack_value_t* top, std::vector<size_t>& frames,
+                            Apply& apply) {
+        frames.resize(std::max(frames.size(), size_t(last - first) + size_t(drift_of(*(last - 1))) + 1));
+        auto frame = frames.data();
+        *frame = 0;
+        while (last != first) {
+                const auto& node = *--last;
+                auto drift = size_t(drift_of(node));
+                size_t arity = 0;
+                if (0 == drift) arity = *frame--;
+                else for (; drift > 1; --drift) *++frame = 0;
+                assert(frame >= frames.data());
+                stack_value_t result;
+                apply(node.data, static_cast<const stack_value_t*>(top), arity, result);
+                top += arity;
+                *--top = std::move(result);
+                *frame += 1;
+        }
+        return top;
+}
+
+// value type from the second parameter of op(data, const value_t* args, size_t arity)
+template<typename Fn>
+struct op_signature : op_signature<decltype(&Fn::operator())> {};
+template<typename C, typename R, typename D, typename V, typename N>
+struct op_signature<R (C::*)(D, const V*, N) const> { using value_t = V; };
+template<typename C, typename R, typename D, typename V, typename N>
+struct op_signature<R (C::*)(D, const V*, N)> { using value_t = V; };
+template<typename R, typename D, typename V, typename N>
+struct op_signature<R (*)(D, const V*, N)> { using value_t = V; };
+
+template<typename value_t, typename OpFn>
+struct op_value { using type = value_t; };
+template<typename OpFn>
+struct op_value<void, OpFn> { using type = typename op_signature<std::decay_t<OpFn>>::value_t; };
+
+} // namespace detail
+
+/*!
+ * Evaluates operator trees with a value stack in one reverse pass, like a stack machine
+ *
+ * The nodes are visited from the back, so all children are evaluated before their parent.
+ * op(data, args, arity) returns the value of one node, args are the values of its children
+ * in tree order. The arity comes from the drifts, leaves get arity 0.
+ *
+ * vt::reverse_evaluator<double> eval;
+ * auto value = eval(tree, [&](const expr& e, const double* args, size_t arity) { ... });
+ *
+ * The evaluator keeps its stacks, repeated evaluations do not allocate.
+ * O(n)  n = nodes in the tree, the value stack has room for n values
+ */
+template<typename _value_t>
+struct reverse_evaluator
+{
+        using value_t = _value_t;
+
+        template<typename tree_t, typename OpFn>
+        value_t operator()(const tree_t& tree, OpFn op) {
+                return evaluate(tree.begin(), tree.end(), op);
+        }
+
+        // the subtree including its root
+        // O(m)  m = nodes in the subtree, the end of the subtree is resolved first
+        template<typename tree_t, typename OpFn>
+        value_t operator()(subtree<tree_t> st, OpFn op) {
+                return evaluate(st.unwrap(), find_subtree_end(st.unwrap()), op);
+        }
+
+        // the value of the first root in [first, last), the range holds complete subtrees
+        template<typename iterator_t, typename OpFn>
+        value_t evaluate(iterator_t first, iterator_t last, OpFn& op) {
+                assert(first != last);
+                stack_m.resize(std::max(stack_m.size(), size_t(last - first)));
+                auto apply = [&](const auto& data, const value_t* args, size_t arity, value_t& result) {
+                        result = op(data, args, arity);
+                };
+                return *detail::reverse_pass(first, last, stack_m.data() + stack_m.size(), frames_m, apply);
+        }
+
+private:
+        std::vector<value_t> stack_m;
+        std::vector<size_t> frames_m;
+};
+
+/*!
+ * Evaluates an operator tree once, see reverse_evaluator
+ *
+ * The value type is deduced from op(data, const value_t* args, size_t arity)
+ * or given explicitly for generic lambdas: eval_reverse<double>(tree, op)
+ */
+template<typename value_t = void, typename tree_t, typename OpFn>
+auto eval_reverse(const tree_t& tree, OpFn op) {
+        return reverse_evaluator<typename detail::op_value<value_t, OpFn>::type>()(tree, op);
+}
+
+// the values of width rows in the lanes of one stack entry
+template<typename _value_t, size_t _width>
+struct value_lanes
+{
+        using value_t = _value_t;
+        static constexpr size_t width = _width;
+
+        value_t& operator[](size_t k) noexcept { return lane[k]; }
+        const value_t& operator[](size_t k) const noexcept { return lane[k]; }
+
+        value_t lane[width];
+};
+
+// the rows evaluated in the lanes, count < width for the last batch
+struct lane_rows
+{
+        size_t first;
+        size_t count;
+};
+
+/*!
+ * Evaluates one operator tree for many rows, width rows at once
+ *
+ * The tree is walked once per batch of width rows. op works on whole lanes:
+ * op(data, args, arity, result, rows) with args and result of value_lanes<value_t, width>.
+ * Loops over the lanes with a constant trip count are vectorized by the compiler,
+ * leaves load their inputs from rows.first + k.
+ * Lanes from rows.count to width are computed but not stored, their inputs are up to op.
+ *
+ * vt::batch_evaluator<float, 8> eval;
+ * eval(tree, rows, results, [&](const expr& e, const lanes_t* args, size_t arity, lanes_t& out, vt::lane_rows r) {
+ *         if (e.op == ADD) for (size_t k = 0; k < 8; ++k) out[k] = args[0][k] + args[1][k];
+ *         ...
+ * });
+ *
+ * O(n * r / width)  n = nodes in the tree, r = rows
+ */
+template<typename _value_t, size_t _width = 8>
+struct batch_evaluator
+{
+        using value_t = _value_t;
+        static constexpr size_t width = _width;
+        using lanes_t = value_lanes<value_t, width>;
+
+        // results[row] for row in [0, rows)
+        template<typename tree_t, typename OpFn>
+        void operator()(const tree_t& tree, size_t rows, value_t* results, OpFn op) {
+                if (tree.empty()) return;
+                stack_m.resize(std::max(stack_m.size(), tree.size()));
+                for (size_t first = 0; first < rows; first += width) {
+                        lane_rows batch{first, rows - first < width ? rows - first : width};
+                        auto apply = [&](const auto& data, const lanes_t* args, size_t arity, lanes_t& result) {
+                                op(data, args, arity, result, batch);
+                        };
+                        const auto& top = *detail::reverse_pass(tree.begin(), tree.end(), stack_m.data() + stack_m.size(),
+                                                                frames_m, apply);
+                        std::copy(top.lane, top.lane + batch.count, results + first);
+                }
+        }
+
+private:
+        std::vector<lanes_t> stack_m;
+        std::vector<size_t> frames_m;
+};
+
+// evaluates the tree for rows with a temporary batch_evaluator
+template<typename value_t, size_t width = 8, typename tree_t, typename OpFn>
+void eval_reverse_batch(const tree_t& tree, size_t rows, value_t* results, OpFn op) {
+        batch_evaluator<value_t, width>()(tree, rows, results, op);
+}
+
+} // namespace vt
@@ -0,0 +1,223 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vt {
+
+// the edits of drift_tree an instrumentation policy observes
+// storage covers assign, reserve, resize and shrink_to_fit
+enum class tree_op : unsigned {
+        push_root,
+        push_back,
+        pop_back,
+        insert_first_child,
+        insert_child_tree,
+        insert_child_trees,
+        insert_sibling,
+        erase_leaf,
+        erase_subtree,
+        storage,
+        count
+};
+
+constexpr size_t tree_op_count = size_t(tree_op::count);
+
+inline const char* tree_op_name(tree_op op) noexcept {
+        static const char* names[tree_op_count] = {"push_root", "push_back", "pop_back", "insert_first_child",
+                                                   "insert_child_tree", "insert_child_trees", "insert_sibling",
+                                                   "erase_leaf", "erase_subtree", "storage"};
+        return names[size_t(op)];
+}
+
+// element slots of the storage, a change means the nodes moved to a new buffer
+// overloaded for storages with free space in front, see double_ended_vector
+template<typename vector_t>
+size_t storage_capacity(const vector_t& vector) noexcept { return vector.capacity(); }
+
+// nodes the storage moves to open or close a gap with before nodes in front and behind nodes after it
+template<typename vector_t>
+size_t shifted_nodes(const vector_t&, size_t before, size_t behind) noexcept {
+        (void)before;
+        return behind;
+}
+
+/*!
+ * The default policy of drift_tree, every hook is empty
+ *
+ * drift_tree derives from the policy, so it adds no bytes to the tree
+ * and the optimizer removes the hooks together with their arguments.
+ *
+ * A policy provides a probe class template. drift_tree creates one probe at the start
+ * of every edit and reports to it, the destructor of the probe ends the edit.
+ */
+struct no_instrumentation
+{
+        template<typename vector_t>
+        struct probe
+        {
+                constexpr probe(no_instrumentation&, tree_op, const vector_t&) noexcept {}
+
+                // nodes behind and in front of the gap of an insert or erase
+                constexpr void shift(size_t, size_t) noexcept {}
+                // nodes read to find a subtree end or a drift
+                constexpr void scan(size_t) noexcept {}
+                // all nodes were moved into a new storage
+                constexpr void rebuild(size_t) noexcept {}
+        };
+};
+
+// counts of one kind of edit
+struct operation_stats
+{
+        uint64_t calls = 0;
+        uint64_t moved_nodes = 0;   // shifted within the storage or moved to a new buffer
+        uint64_t moved_bytes = 0;
+        uint64_t reallocations = 0;
+        uint64_t scanned_nodes = 0;
+
+        operation_stats& operator +=(const operation_stats& other) noexcept {
+                calls += other.calls;
+                moved_nodes += other.moved_nodes;
+                moved_bytes += other.moved_bytes;
+                reallocations += other.reallocations;
+                scanned_nodes += other.scanned_nodes;
+                return *this;
+        }
+};
+
+// calls by latency, bucket k counts latencies in [2^(k-1), 2^k) nanoseconds
+using latency_histogram = std::array<uint64_t, 40>;
+
+/*!
+ * A copy of the counters of one tree
+ *
+ * for_each(fn) calls fn(name, stats) for every kind of edit, ex. for a metrics exporter.
+ */
+template<bool _with_latency>
+struct instrumentation_snapshot
+{
+        static constexpr bool with_latency = _with_latency;
+
+        std::array<operation_stats, tree_op_count> ops = {};
+        std::array<latency_histogram, with_latency ? tree_op_count : 0> latency = {};
+
+        const operation_stats& operator[](tree_op op) const noexcept { return ops[size_t(op)]; }
+
+        operation_stats total() const noexcept {
+                operation_stats sum;
+                for (const auto& stats : ops) sum += stats;
+                return sum;
+        }
+
+        template<typename Fn>
+        void for_each(Fn fn) const {
+                for (size_t i = 0; i < tree_op_count; ++i) fn(tree_op_name(tree_op(i)), ops[i]);
+        }
+};
+
+/*!
+ * Counts calls, moved nodes and bytes, reallocations and scanned nodes per kind of edit
+ *
+ * With _latency every edit is timed with steady_clock into a histogram,
+ * the two clock reads add tens of nanoseconds to each edit.
+ * Copies of the tree copy the counters.
+ *
+ * vt::drift_tree<data_t, drift_t, alloc_t, vector_t, vt::counting_instrumentation<>> tree;
+ * auto stats = tree.instrumentation().snapshot();
+ *
+ * HINT: the counters are not atomic, the tree has to be synchronized anyway
+ */
+template<bool _latency = false>
+struct counting_instrumentation
+{
+        using snapshot_t = instrumentation_snapshot<_latency>;
+
+        snapshot_t snapshot() const noexcept { return stats_m; }
+        void reset() noexcept { stats_m = snapshot_t(); }
+
+        template<typename vector_t>
+        struct probe
+        {
+                using clock = std::chrono::steady_clock;
+                static constexpr size_t node_size = sizeof(typename vector_t::value_type);
+
+                probe(counting_instrumentation& owner, tree_op op, const vector_t& vector) noexcept
+                        : owner_m(owner), stats_m(owner.stats_m.ops[size_t(op)]), vector_m(vector), op_m(op),
+                          size_m(vector.size()), capacity_m(storage_capacity(vector)) {
+                        stats_m.calls += 1;
+                        if (_latency) start_m = clock::now();
+                }
+                probe(const probe&) = delete;
+                probe& operator =(const probe&) = delete;
+
+                // a reallocation moves all nodes instead of shifting some of them
+                ~probe() {
+                        if (!rebuilt_m && storage_capacity(vector_m) != capacity_m) {
+                                stats_m.reallocations += 1;
+                                moved(size_m);
+                        }
+                        else moved(shifted_m);
+                        if (_latency) record(clock::now() - start_m);
+                }
+
+                void shift(size_t before, size_t behind) noexcept { shifted_m += shifted_nodes(vector_m, before, behind); }
+                void scan(size_t count) noexcept { stats_m.scanned_nodes += count; }
+                void rebuild(size_t count) noexcept {
+                        rebuilt_m = true;
+                        stats_m.reallocations += 1;
+                        moved(count);
+                }
+
+        private:
+                void moved(size_t count) noexcept {
+                        stats_m.moved_nodes += count;
+                        stats_m.moved_bytes += count * node_size;
+                }
+
+                void record(clock::duration elapsed) noexcept {
+                        auto ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                        size_t bucket = 0;
+                        while (ns && bucket + 1 < latency_histogram().size()) {
+                                ns >>= 1;
+                                bucket += 1;
+                        }
+                        owner_m.stats_m.latency[size_t(op_m)][bucket] += 1;
+                }
+
+                counting_instrumentation& owner_m;
+                operation_stats& stats_m;
+                const vector_t& vector_m;
+                tree_op op_m;
+                size_t size_m;
+                size_t capacity_m;
+                size_t shifted_m = 0;
+                bool rebuilt_m = false;
+                clock::time_point start_m;
+        };
+
+private:
+        snapshot_t stats_m;
+};
+
+} // namespace vt
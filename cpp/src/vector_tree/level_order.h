@@ -0,0 +1,311 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/subtree_index.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vt {
+
+/* 1
+ *  2    5
+ *   3 4  6
+ *
+ * <0,1> <0,2> <1,3> <2,4> <0,5> <3,6>
+ * level 0: 1          span [0, 1)
+ * level 1: 2 5        span [1, 5)
+ * level 2: 3 4 6      span [2, 6)
+ */
+
+/*!
+ * All nodes at one level as a forward range in pre order
+ *
+ * The range spans from the first to the last node of the level,
+ * the iterator skips all nodes at other levels between them.
+ * Levels are relative to the roots of the traversed range.
+ *
+ * Without an index the iterator scans the span node by node.
+ * With a subtree_index it keeps the subtree ends of the ancestors of its node,
+ * jumps over each finished subtree and only walks the nodes above the level.
+ */
+template<typename _tree_t>
+struct level_range
+{
+        using tree_t = _tree_t;
+        using level_t = typename tree_t::level_t;
+        using node_t = typename subtree<tree_t>::node_t;
+        using iterator_t = typename subtree<tree_t>::iterator_t;
+        using difference_t = std::ptrdiff_t;
+        using index_t = subtree_index<std::remove_const_t<tree_t>>;
+        using size_type = typename index_t::size_type;
+
+        struct iterator
+        {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = typename tree_t::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = node_t*;
+                using reference = node_t&;
+
+                iterator() = default;
+                iterator(iterator_t it, iterator_t last, level_t level) noexcept
+                        : it_m(it), last_m(last), level_m(level) {}
+                // the first node at level behind base, base is the first node of the indexed tree
+                iterator(iterator_t base, iterator_t last, level_t level, const index_t* index)
+                        : it_m(base), last_m(last), level_m(level), base_m(base), index_m(index) {
+                        ends_m.reserve(level);
+                        descend(0, 0);
+                }
+
+                bool operator == (const iterator &ot) const noexcept { return it_m == ot.it_m; }
+                bool operator != (const iterator &ot) const noexcept { return it_m != ot.it_m; }
+
+                reference operator*() const noexcept { return *it_m; }
+                pointer operator->() const noexcept { return &*it_m; }
+
+                iterator& operator++() {
+                        if (index_m) {
+                                descend(index_m->end(size_type(it_m - base_m)), level_m);
+                                return *this;
+                        }
+                        difference_t level = level_m;
+                        do {
+                                level += 1 - difference_t(drift_of(*it_m));
+                                ++it_m;
+                        } while (it_m != last_m && level != difference_t(level_m));
+                        return *this;
+                }
+
+                iterator operator++(int) {
+                        auto __tmp = *this;
+                        ++(*this);
+                        return __tmp;
+                }
+
+                iterator_t unwrap() const noexcept { return it_m; }
+                level_t level() const noexcept { return level_m; }
+
+        private:
+                // walks from pos at level down to the next node at level_m
+                // ends_m holds the subtree ends of the ancestors at the levels above
+                void descend(size_type pos, level_t level) {
+                        auto last = size_type(last_m - base_m);
+                        for (; pos < last; ++pos) {
+                                while (level > 0 && pos == ends_m[level - 1]) {
+                                        ends_m.pop_back();
+                                        --level;
+                                }
+                                if (level == level_m) break;
+                                if (0 == drift_of(base_m[difference_t(pos)])) {
+                                        ends_m.push_back(index_m->end(pos));
+                                        ++level;
+                                }
+                        }
+                        it_m = base_m + difference_t(std::min(pos, last));
+                }
+
+                iterator_t it_m = {};
+                iterator_t last_m = {};
+                level_t level_m = {};
+                iterator_t base_m = {};
+                const index_t* index_m = nullptr;
+                std::vector<size_type> ends_m;
+        };
+
+        level_range() = default;
+        // first and one behind the last node at level
+        level_range(iterator_t first, iterator_t last, level_t level) noexcept
+                : first_m(first), last_m(last), level_m(level) {}
+        // jumps over subtrees with the index of the tree that starts at base
+        level_range(iterator_t first, iterator_t last, level_t level, iterator_t base, const index_t& index) noexcept
+                : first_m(first), last_m(last), level_m(level), base_m(base), index_m(&index) {}
+
+        iterator begin() const {
+                return index_m && first_m != last_m ? iterator(base_m, last_m, level_m, index_m)
+                                                    : iterator(first_m, last_m, level_m);
+        }
+        iterator end() const noexcept { return iterator(last_m, last_m, level_m); }
+
+        bool empty() const noexcept { return first_m == last_m; }
+        level_t level() const noexcept { return level_m; }
+
+        // the part of the tree vector scanned by the level
+        iterator_t span_begin() const noexcept { return first_m; }
+        iterator_t span_end() const noexcept { return last_m; }
+
+private:
+        iterator_t first_m = {};
+        iterator_t last_m = {};
+        level_t level_m = {};
+        iterator_t base_m = {};
+        const index_t* index_m = nullptr;
+};
+
+/*!
+ * Breadth first traversal as one level_range per level
+ *
+ * for (auto level : vt::level_order(tree))
+ *         for (auto& node : level) visit(node, level.level());
+ *
+ * A single scan records where every level starts and ends,
+ * so the memory is proportional to the height of the tree.
+ * Each level is then walked by its own cursor, no queue of nodes is built.
+ * Without an index the cursor scans the span of its level.
+ * O(n + s)  n = nodes, s = sum of all level spans
+ * HINT: s is close to n for wide trees, deep subtrees below early nodes make it grow
+ *
+ * With a subtree_index the cursor jumps over every finished subtree below its level
+ * and keeps the subtree ends of its ancestors, one entry per level above.
+ * O(n + a)  a = sum of the nodes above each level that lie on the way to its nodes
+ * HINT: a is O(n) for bushy trees, long chains still cost O(n*h)
+ */
+template<typename _tree_t>
+struct level_order_range
+{
+        using tree_t = _tree_t;
+        using level_t = typename tree_t::level_t;
+        using size_type = typename tree_t::size_type;
+        using iterator_t = typename subtree<tree_t>::iterator_t;
+        using value_type = level_range<tree_t>;
+        using difference_t = std::ptrdiff_t;
+
+        struct iterator
+        {
+                using iterator_category = std::input_iterator_tag;
+                using value_type = level_range<tree_t>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = value_type;
+
+                iterator() = default;
+                iterator(const level_order_range* range, level_t level) noexcept
+                        : range_m(range), level_m(level) {}
+
+                bool operator == (const iterator &ot) const noexcept { return level_m == ot.level_m; }
+                bool operator != (const iterator &ot) const noexcept { return level_m != ot.level_m; }
+
+                value_type operator*() const noexcept { return (*range_m)[level_m]; }
+
+                iterator& operator++() noexcept { ++level_m; return *this; }
+                iterator operator++(int) noexcept {
+                        auto __tmp = *this;
+                        ++(*this);
+                        return __tmp;
+                }
+
+        private:
+                const level_order_range* range_m = {};
+                level_t level_m = {};
+        };
+
+        // all subtrees in [first, last), roots at relative level 0
+        // O(n)  n = nodes in [first, last)
+        level_order_range(iterator_t first, iterator_t last) {
+                difference_t level = 0;
+                for (auto it = first; it != last; ++it) {
+                        if (size_type(level) == spans_m.size())
+                                spans_m.emplace_back(it, it + 1);
+                        else
+                                spans_m[level].second = it + 1;
+                        level += 1 - difference_t(drift_of(*it));
+                }
+        }
+
+        // the levels jump over subtrees with the index of the tree that starts at first
+        level_order_range(iterator_t first, iterator_t last, const typename level_range<tree_t>::index_t& index)
+                : level_order_range(first, last) {
+                first_m = first;
+                index_m = &index;
+        }
+
+        iterator begin() const noexcept { return iterator(this, 0); }
+        iterator end() const noexcept { return iterator(this, spans_m.size()); }
+
+        // number of levels, the height of the tree plus one
+        size_type size() const noexcept { return spans_m.size(); }
+        bool empty() const noexcept { return spans_m.empty(); }
+
+        value_type operator[](level_t level) const noexcept {
+                if (index_m) return value_type(spans_m[level].first, spans_m[level].second, level, first_m, *index_m);
+                return value_type(spans_m[level].first, spans_m[level].second, level);
+        }
+
+private:
+        std::vector<std::pair<iterator_t, iterator_t>> spans_m;
+        iterator_t first_m = {};
+        const typename level_range<tree_t>::index_t* index_m = nullptr;
+};
+
+// levels of the whole tree
+template<typename tree_t>
+level_order_range<tree_t> level_order(tree_t& tree) {
+        return {tree.begin(), tree.end()};
+}
+
+// levels of the whole tree, finished subtrees are jumped with the index of the tree
+template<typename tree_t>
+level_order_range<tree_t> level_order(tree_t& tree, const subtree_index<std::remove_const_t<tree_t>>& index) {
+        return {tree.begin(), tree.end(), index};
+}
+
+// levels of the subtree, its root is at level 0
+// O(m)  m = nodes in the subtree
+template<typename tree_t>
+level_order_range<tree_t> level_order(subtree<tree_t> st) {
+        return {st.unwrap(), find_subtree_end(st.unwrap())};
+}
+
+// all nodes in [first, last) at a relative level, the roots are at level 0
+// O(n)  n = nodes in [first, last)
+template<typename tree_t, typename iterator_t>
+level_range<tree_t> level_nodes(iterator_t first, iterator_t last, typename tree_t::level_t level) noexcept {
+        using difference_t = std::ptrdiff_t;
+        difference_t current = 0;
+        auto level_first = last;
+        auto level_last = last;
+        for (auto it = first; it != last; ++it) {
+                if (current == difference_t(level)) {
+                        if (level_first == last) level_first = it;
+                        level_last = it + 1;
+                }
+                current += 1 - difference_t(drift_of(*it));
+        }
+        return {level_first, level_last, level};
+}
+
+// all nodes of the tree at depth level
+template<typename tree_t>
+level_range<tree_t> level_nodes(tree_t& tree, typename tree_t::level_t level) noexcept {
+        return level_nodes<tree_t>(tree.begin(), tree.end(), level);
+}
+
+// all nodes of the subtree at depth level below its root
+template<typename tree_t>
+level_range<tree_t> level_nodes(subtree<tree_t> st, typename tree_t::level_t level) noexcept {
+        return level_nodes<tree_t>(st.unwrap(), find_subtree_end(st.unwrap()), level);
+}
+
+} // namespace vt
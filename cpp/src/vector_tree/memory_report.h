@@ -0,0 +1,269 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/instrumentation.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace vt {
+
+// heap usage of everything allocated through tracking allocators sharing these stats
+struct allocation_stats
+{
+        size_t bytes = 0;
+        size_t peak_bytes = 0;
+        size_t allocations = 0;
+        size_t deallocations = 0;
+};
+
+/*!
+ * Allocator that counts the bytes it hands out
+ *
+ * All copies and rebinds count into the same stats, so the nodes of a tree
+ * and the heap of its payload (ex. strings with tracking_allocator<char>) add up.
+ *
+ * allocation_stats stats;
+ * drift_tree<std::string, uint8_t, tracking_allocator<node_layout_t<std::string, uint8_t>>> tree{
+ *         tracking_allocator<node_layout_t<std::string, uint8_t>>(stats)};
+ *
+ * HINT: the stats have to outlive all allocators and all memory allocated through them
+ */
+template<typename T>
+struct tracking_allocator
+{
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        explicit tracking_allocator(allocation_stats& stats) noexcept
+                : stats_m(&stats) {}
+        template<typename U>
+        tracking_allocator(const tracking_allocator<U>& other) noexcept
+                : stats_m(other.stats()) {}
+
+        T* allocate(size_t count) {
+                auto result = std::allocator<T>().allocate(count);
+                stats_m->bytes += count * sizeof(T);
+                stats_m->peak_bytes = std::max(stats_m->peak_bytes, stats_m->bytes);
+                stats_m->allocations += 1;
+                return result;
+        }
+
+        void deallocate(T* pointer, size_t count) noexcept {
+                std::allocator<T>().deallocate(pointer, count);
+                stats_m->bytes -= count * sizeof(T);
+                stats_m->deallocations += 1;
+        }
+
+        allocation_stats* stats() const noexcept { return stats_m; }
+
+        template<typename U>
+        bool operator ==(const tracking_allocator<U>& other) const noexcept { return stats_m == other.stats(); }
+        template<typename U>
+        bool operator !=(const tracking_allocator<U>& other) const noexcept { return stats_m != other.stats(); }
+
+private:
+        allocation_stats* stats_m;
+};
+
+/*!
+ * Bytes used by a drift_tree, split by component
+ *
+ * Per node sizes describe one element of the storage:
+ * node = data + drift + padding, the drift is 0 if the layout keeps it inside the data.
+ * Padding inside the data type itself is counted as data.
+ */
+struct memory_usage
+{
+        size_t nodes = 0;
+        size_t capacity = 0;            // node slots of the storage, see storage_capacity()
+        size_t node_bytes = 0;
+        size_t data_bytes = 0;
+        size_t data_align = 1;
+        bool data_trivially_copyable = false;
+        size_t drift_bytes = 0;
+        size_t padding_bytes = 0;
+
+        size_t used_bytes = 0;          // nodes * node_bytes
+        size_t slack_bytes = 0;         // free capacity of the storage
+        size_t payload_heap_bytes = 0;  // reported by the payload callback
+        size_t column_bytes = 0;        // attached side columns
+        size_t sidecar_bytes = 0;       // added by the caller, ex. subtree_index::memory_bytes()
+        size_t tracked_heap_bytes = 0;  // live bytes of a tracking_allocator, 0 otherwise
+
+        size_t max_level = 0;
+
+        size_t storage_bytes() const noexcept { return used_bytes + slack_bytes; }
+        size_t total_bytes() const noexcept {
+                return storage_bytes() + payload_heap_bytes + column_bytes + sidecar_bytes;
+        }
+        double bytes_per_node() const noexcept { return nodes ? double(total_bytes()) / double(nodes) : 0.0; }
+
+        void add_sidecar(size_t bytes) noexcept { sidecar_bytes += bytes; }
+};
+
+namespace detail {
+
+template<typename alloc_t>
+auto tracked_bytes(const alloc_t& alloc, int) noexcept -> decltype(alloc.stats()->bytes) { return alloc.stats()->bytes; }
+template<typename alloc_t>
+size_t tracked_bytes(const alloc_t&, long) noexcept { return 0; }
+
+// payloads without heap are not touched, packed nodes do not bind references to their data
+struct no_payload_heap {};
+
+template<typename node_t>
+size_t payload_heap(no_payload_heap, const node_t&) noexcept { return 0; }
+template<typename HeapOf, typename node_t>
+size_t payload_heap(HeapOf& heap_of, const node_t& node) { return heap_of(node.data); }
+
+} // namespace detail
+
+/*!
+ * Memory usage of a tree, heap_of(data) returns the heap bytes owned by one payload
+ *
+ * O(n)  n = nodes in the tree
+ */
+template<typename tree_t, typename HeapOf>
+memory_usage memory_report(const tree_t& tree, HeapOf heap_of) {
+        using node_t = typename tree_t::node_t;
+        using data_t = typename tree_t::data_t;
+        using drift_t = typename tree_t::drift_t;
+        memory_usage usage;
+        usage.nodes = tree.size();
+        usage.capacity = storage_capacity(tree.storage());
+        usage.node_bytes = sizeof(node_t);
+        usage.data_bytes = sizeof(data_t);
+        usage.data_align = alignof(data_t);
+        usage.data_trivially_copyable = std::is_trivially_copyable<data_t>::value;
+        auto overhead = sizeof(node_t) > sizeof(data_t) ? sizeof(node_t) - sizeof(data_t) : 0;
+        usage.drift_bytes = std::min(overhead, sizeof(drift_t));
+        usage.padding_bytes = overhead - usage.drift_bytes;
+        usage.used_bytes = usage.nodes * usage.node_bytes;
+        usage.slack_bytes = (usage.capacity - usage.nodes) * usage.node_bytes;
+        usage.column_bytes = tree.columns().memory_bytes();
+        usage.tracked_heap_bytes = detail::tracked_bytes(tree.get_allocator(), 0);
+
+        size_t level = 0;
+        for (const auto& node : tree) {
+                usage.max_level = std::max(usage.max_level, level);
+                usage.payload_heap_bytes += detail::payload_heap(heap_of, node);
+                level = level + 1 - drift_of(node);
+        }
+        return usage;
+}
+
+// memory usage without payload heap, ex. for trivially copyable payloads
+template<typename tree_t>
+memory_usage memory_report(const tree_t& tree) {
+        return memory_report(tree, detail::no_payload_heap());
+}
+
+/*!
+ * Layout recommendations from the measured usage
+ *
+ * - drift_bytes: the smallest drift type for twice the measured depth, see drift_for_level_t
+ *   node_bytes is the aligned drift_node with that drift type
+ * - pack: packed_drift_node needs fewer bytes than the aligned node
+ * - split_payload: structural scans read at least four times more payload than drift bytes,
+ *   small nodes with the payload in a side column (structure of arrays) scan faster
+ * - shrink_to_fit: more than a quarter of the storage is free
+ *
+ * With the counters of counting_instrumentation:
+ * - double_ended: push_root moves most of the nodes, see double_ended_vector
+ * - batch_edits: single inserts and erases move a large part of the tree, see edit_transaction
+ *
+ * Layouts that keep the drift inside the payload (field_drift_node, bits_drift_node)
+ * only get the storage recommendations.
+ */
+struct layout_advice
+{
+        size_t drift_bytes = 0;
+        size_t node_bytes = 0;
+        size_t packed_node_bytes = 0;
+        bool pack = false;
+        bool split_payload = false;
+        bool shrink_to_fit = false;
+        bool double_ended = false;
+        bool batch_edits = false;
+
+        // bytes per node saved by the drift type and packing
+        size_t saved_bytes_per_node(const memory_usage& usage) const noexcept {
+                auto bytes = pack ? packed_node_bytes : node_bytes;
+                return usage.node_bytes > bytes ? usage.node_bytes - bytes : 0;
+        }
+
+        // one line per recommendation
+        std::string describe() const {
+                std::string text;
+                auto line = [&](const std::string& s) { text += s + "\n"; };
+                if (drift_bytes) line("use a " + std::to_string(drift_bytes * 8) + " bit drift type, "
+                                      + std::to_string(node_bytes) + " bytes per node");
+                if (pack) line("use packed_drift_node, " + std::to_string(packed_node_bytes) + " bytes per node");
+                if (split_payload) line("keep the payload in a side column and the nodes small");
+                if (shrink_to_fit) line("call shrink_to_fit, more than a quarter of the storage is unused");
+                if (double_ended) line("use double_ended_vector storage for push_root");
+                if (batch_edits) line("batch the inserts and erases with edit_transaction");
+                return text;
+        }
+};
+
+inline layout_advice advise_layout(const memory_usage& usage) {
+        layout_advice advice;
+        advice.shrink_to_fit = usage.slack_bytes * 4 > usage.storage_bytes() && usage.slack_bytes >= 4096;
+        advice.split_payload = usage.data_bytes >= 16;
+        // the drift lives inside the payload
+        if (0 == usage.drift_bytes) return advice;
+        auto levels = 2 * usage.max_level + 2;
+        advice.drift_bytes = levels < UINT8_MAX ? 1 : levels < UINT16_MAX ? 2 : levels < UINT32_MAX ? 4 : 8;
+        auto align = std::max(usage.data_align, advice.drift_bytes);
+        advice.node_bytes = (usage.data_bytes + advice.drift_bytes + align - 1) / align * align;
+        advice.packed_node_bytes = usage.data_bytes + advice.drift_bytes;
+        advice.pack = usage.data_trivially_copyable && advice.packed_node_bytes < advice.node_bytes;
+        advice.split_payload = usage.data_bytes >= 4 * std::max<size_t>(advice.drift_bytes, 4);
+        return advice;
+}
+
+template<bool with_latency>
+layout_advice advise_layout(const memory_usage& usage, const instrumentation_snapshot<with_latency>& stats) {
+        auto advice = advise_layout(usage);
+        auto total = stats.total();
+        const auto& front = stats[tree_op::push_root];
+        // the moves of a call are compared with the tree size
+        auto heavy = [&](const operation_stats& op) {
+                return op.calls >= 64 && op.moved_nodes >= op.calls * std::max<size_t>(usage.nodes, 64) / 4;
+        };
+        advice.double_ended = front.calls * 10 >= total.calls && heavy(front);
+        operation_stats single;
+        for (auto op : {tree_op::insert_first_child, tree_op::insert_child_tree, tree_op::insert_sibling,
+                        tree_op::erase_leaf, tree_op::erase_subtree})
+                single += stats[op];
+        advice.batch_edits = heavy(single);
+        return advice;
+}
+
+} // namespace vt
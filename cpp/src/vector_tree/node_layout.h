@@ -0,0 +1,186 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/relocation.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace vt {
+
+/* Node layouts for payload {uint32_t id; uint64_t key;} with uint32_t drifts
+ *
+ * drift_node          <drift:4|pad:4><id:4|pad:4><key:8>   24 bytes
+ * packed_drift_node   <id:4|pad:4><key:8><drift:4>         20 bytes
+ * field_drift_node    <id:4|drift:4><key:8>                16 bytes (drift in a spare member)
+ * bits_drift_node     <id:4|pad:4><key:8>                  16 bytes (drift in the upper bits of key)
+ *
+ * Select a layout for a payload by specializing node_layout:
+ *
+ * template<typename drift_t> struct vt::node_layout<my_data, drift_t> {
+ *         using type = vt::field_drift_node<my_data, uint32_t, &my_data::spare>;
+ * };
+ */
+
+#pragma pack(push, 1)
+/*!
+ * Data followed by the drift without any padding
+ *
+ * HINT: nodes are byte aligned, the members are accessed unaligned
+ * HINT: only for trivially copyable data, references to data are misaligned
+ *       use load() and store() where the data is passed on
+ */
+template<typename _data_t, typename _drift_t = size_t>
+struct packed_drift_node
+{
+        static_assert(std::is_trivially_copyable<_data_t>::value, "packed nodes require trivially copyable data");
+
+        using data_t = _data_t;
+        using drift_t = _drift_t;
+
+        packed_drift_node() = default;
+        template< class... Args >
+        constexpr packed_drift_node(drift_t drift, Args&&... args)
+                noexcept(std::is_nothrow_constructible<data_t, Args&&...>::value)
+                : data(std::forward<Args>(args)...), drift(drift) {}
+
+        data_t load() const noexcept {
+                data_t value;
+                std::memcpy(static_cast<void*>(&value), static_cast<const void*>(&data), sizeof(data_t));
+                return value;
+        }
+        void store(const data_t& value) noexcept {
+                std::memcpy(static_cast<void*>(&data), static_cast<const void*>(&value), sizeof(data_t));
+        }
+
+        data_t data;
+        drift_t drift;
+};
+#pragma pack(pop)
+
+/*!
+ * The drift is stored in a member of the payload
+ *
+ * The member has to be unused by the payload otherwise, like a padding slot.
+ * The constructor overwrites it after the data was constructed.
+ *
+ * HINT: the tree owns the member, never modify it through data
+ */
+template<typename _data_t, typename _field_t, _field_t _data_t::*_field>
+struct field_drift_node
+{
+        static_assert(std::is_unsigned<_field_t>::value, "the drift field has to be unsigned");
+
+        using data_t = _data_t;
+        using drift_t = _field_t;
+
+        field_drift_node() = default;
+        template< class... Args >
+        constexpr field_drift_node(drift_t drift, Args&&... args)
+                noexcept(std::is_nothrow_constructible<data_t, Args&&...>::value)
+                : data(std::forward<Args>(args)...) {
+                data.*_field = drift;
+        }
+
+        data_t data;
+};
+
+template<typename data_t, typename field_t, field_t data_t::*field>
+struct node_traits<field_drift_node<data_t, field_t, field>>
+{
+        using node_t = field_drift_node<data_t, field_t, field>;
+        using drift_t = field_t;
+
+        static constexpr uintmax_t max_drift() noexcept { return std::numeric_limits<drift_t>::max(); }
+
+        static constexpr drift_t drift(const node_t& node) noexcept { return node.data.*field; }
+        static constexpr void set_drift(node_t& node, drift_t drift) noexcept { node.data.*field = drift; }
+};
+
+/*!
+ * The drift is stored in the bits [shift, shift + width) of a payload member
+ *
+ * Use it for spare tag bits, like the upper bits of an index or the low bits
+ * of an aligned pointer value. The other bits of the member belong to the payload.
+ * The depth of the tree is limited to 2^width - 2, deeper trees throw std::overflow_error.
+ *
+ * HINT: the payload must not change the drift bits of the member
+ */
+template<typename _data_t, typename _word_t, _word_t _data_t::*_word, unsigned _shift, unsigned _width>
+struct bits_drift_node
+{
+        static_assert(std::is_unsigned<_word_t>::value, "the drift bits need an unsigned member");
+        static_assert(0 < _width && _shift + _width <= std::numeric_limits<_word_t>::digits,
+                      "the drift bits have to fit into the member");
+
+        using data_t = _data_t;
+        using drift_t = _word_t;
+
+        static constexpr unsigned shift = _shift;
+        static constexpr unsigned width = _width;
+        static constexpr drift_t max_drift = drift_t(~drift_t(0)) >> (std::numeric_limits<drift_t>::digits - width);
+        static constexpr drift_t mask = drift_t(max_drift << shift);
+
+        bits_drift_node() = default;
+        template< class... Args >
+        constexpr bits_drift_node(drift_t drift, Args&&... args)
+                noexcept(std::is_nothrow_constructible<data_t, Args&&...>::value)
+                : data(std::forward<Args>(args)...) {
+                set(drift);
+        }
+
+        constexpr drift_t get() const noexcept { return (data.*_word & mask) >> shift; }
+        constexpr void set(drift_t drift) noexcept {
+                data.*_word = drift_t((data.*_word & ~mask) | ((drift << shift) & mask));
+        }
+
+        // the payload value of the member without the drift bits
+        constexpr drift_t payload_bits() const noexcept { return data.*_word & ~mask; }
+
+        data_t data;
+};
+
+template<typename data_t, typename word_t, word_t data_t::*word, unsigned shift, unsigned width>
+struct node_traits<bits_drift_node<data_t, word_t, word, shift, width>>
+{
+        using node_t = bits_drift_node<data_t, word_t, word, shift, width>;
+        using drift_t = word_t;
+
+        static constexpr uintmax_t max_drift() noexcept { return node_t::max_drift; }
+
+        static constexpr drift_t drift(const node_t& node) noexcept { return node.get(); }
+        static constexpr void set_drift(node_t& node, drift_t drift) noexcept { node.set(drift); }
+};
+
+// packed nodes only hold trivially copyable data
+template<typename _data_t, typename _drift_t>
+struct is_trivially_relocatable<packed_drift_node<_data_t, _drift_t>> : std::true_type {};
+
+template<typename _data_t, typename _field_t, _field_t _data_t::*_field>
+struct is_trivially_relocatable<field_drift_node<_data_t, _field_t, _field>> : is_trivially_relocatable<_data_t> {};
+
+template<typename _data_t, typename _word_t, _word_t _data_t::*_word, unsigned _shift, unsigned _width>
+struct is_trivially_relocatable<bits_drift_node<_data_t, _word_t, _word, _shift, _width>> : is_trivially_relocatable<_data_t> {};
+
+} // namespace vt
@@ -0,0 +1,220 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/relocation.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <cassert>
+
+namespace vt {
+
+/*!
+ * Builds one drift_tree from fragments that are filled independently
+ *
+ * Each fragment is a regular tree (or forest) with relative drifts.
+ * Only the last drift of each fragment depends on its neighbours,
+ * so concat() copies the fragments in parallel and patches one drift per fragment.
+ *
+ * <1,r>            fragment 0 at level 0
+ * <0,a> <2,b>      fragment 1 at level 1
+ * <1,c>            fragment 2 at level 1
+ * => <0,r> <0,a> <2,b> <2,c>
+ *
+ * Side columns attached through the builder are concatenated the same way.
+ */
+template<typename _tree_t>
+struct parallel_builder
+{
+        using tree_t = _tree_t;
+        using level_t = typename tree_t::level_t;
+        using size_type = typename tree_t::size_type;
+        using allocator_type = typename tree_t::allocator_type;
+
+        explicit parallel_builder(size_t fragment_count, const allocator_type& alloc = allocator_type())
+                : fragments_m(fragment_count, tree_t(alloc)), levels_m(fragment_count), alloc_m(alloc) {}
+
+        size_t fragment_count() const noexcept { return fragments_m.size(); }
+
+        // the fragment owned by one thread
+        // HINT: every fragment starts with push_root like a regular tree
+        tree_t& fragment(size_t index) noexcept { return fragments_m[index]; }
+        const tree_t& fragment(size_t index) const noexcept { return fragments_m[index]; }
+
+        // level of the fragment roots in the final tree
+        // a fragment may start at most one level below the last node of the previous fragment
+        void set_level(size_t index, level_t level) noexcept { levels_m[index] = level; }
+        level_t level(size_t index) const noexcept { return levels_m[index]; }
+
+        // attach a side column to every fragment, the columns are joined by concat()
+        template<typename T>
+        column_handle<T> attach_column() {
+                assert(!fragments_m.empty());
+                auto handle = fragments_m.front().template attach_column<T>();
+                for (size_t k = 1; k < fragments_m.size(); ++k) {
+                        // all fragments share the same column layout
+                        auto other = fragments_m[k].template attach_column<T>();
+                        assert(other.slot == handle.slot);
+                        (void)other;
+                }
+                return handle;
+        }
+
+        // joins all fragments into a single tree, fragments are moved and left empty
+        // storages with has_uninitialized_append get the nodes move constructed in place by the threads,
+        // other storages are value initialized on the calling thread before the threads move the nodes
+        // an exception of a node move is rethrown here, the moved from fragments are left unspecified
+        // O(n/t + k), O(n + k) with value initialization
+        //                 n = nodes in all fragments
+        //                 t = threads used
+        //                 k = fragment count
+        tree_t concat(size_t thread_count = std::thread::hardware_concurrency()) {
+                auto count = fragments_m.size();
+                std::vector<size_type> offsets(count + 1);
+                for (size_t k = 0; k < count; ++k)
+                        offsets[k + 1] = offsets[k] + fragments_m[k].size();
+
+                thread_count = std::max<size_t>(1, std::min(thread_count, count));
+                // split by node count, so that large fragments do not serialize the copy
+                std::vector<size_t> splits(thread_count + 1, count);
+                splits[0] = 0;
+                for (size_t t = 1, k = 0; t < thread_count; ++t) {
+                        auto target = offsets[count] / thread_count * t;
+                        while (k < count && offsets[k] < target) ++k;
+                        splits[t] = k;
+                }
+
+                tree_t result(alloc_m);
+                move_nodes(result, offsets, splits, has_uninitialized_append<typename tree_t::vector_t>{});
+
+                // the columns of all fragments are appended to the ones of the first fragment
+                if (0 < count && fragments_m[0].columns().attached()) {
+                        auto& columns = fragments_m[0].columns();
+                        auto layout = columns.layout();
+                        columns.reserve(offsets[count]);
+                        for (size_t k = 1; k < count; ++k) columns.append(fragments_m[k].columns());
+                        result.columns() = std::move(columns);
+                        columns = std::move(layout);
+                }
+
+                // patch the last drift of each fragment to the level of the following one
+                level_t next_level = 0;
+                for (auto k = count; k-- > 0;) {
+                        if (offsets[k] == offsets[k + 1]) continue;
+                        auto& last = result[offsets[k + 1] - 1];
+                        assert(drift_of(last) + levels_m[k] >= next_level);
+                        set_drift(last, checked_drift<typename tree_t::drift_t>(drift_of(last) + levels_m[k] - next_level,
+                                                                                tree_t::traits_t::max_drift()));
+                        next_level = levels_m[k];
+                }
+                for (auto& fragment : fragments_m) fragment.clear();
+                return result;
+        }
+
+private:
+        using node_alloc_traits = std::allocator_traits<allocator_type>;
+
+        // runs move_range(first, last) for the fragment ranges of splits, one thread per range
+        // returns the first exception of a thread after all threads joined, completed marks the ranges without one
+        template<typename Move>
+        static std::exception_ptr run_threads(const std::vector<size_t>& splits, Move move_range, std::vector<char>& completed) {
+                auto thread_count = splits.size() - 1;
+                std::vector<std::exception_ptr> errors(thread_count);
+                auto guarded = [&](size_t t) {
+                        try {
+                                move_range(splits[t], splits[t + 1]);
+                        }
+                        catch (...) {
+                                errors[t] = std::current_exception();
+                        }
+                };
+                std::vector<std::thread> threads;
+                try {
+                        for (size_t t = 1; t < thread_count; ++t) threads.emplace_back(guarded, t);
+                }
+                catch (...) {
+                        // no thread left, the remaining ranges run here
+                        for (auto t = threads.size() + 1; t < thread_count; ++t) guarded(t);
+                }
+                guarded(0);
+                for (auto& thread : threads) thread.join();
+                completed.assign(thread_count, true);
+                std::exception_ptr first_error;
+                for (size_t t = 0; t < thread_count; ++t) {
+                        if (!errors[t]) continue;
+                        completed[t] = false;
+                        if (!first_error) first_error = errors[t];
+                }
+                return first_error;
+        }
+
+        // every thread move constructs its fragments into the uninitialized storage of result
+        void move_nodes(tree_t& result, const std::vector<size_type>& offsets, const std::vector<size_t>& splits, std::true_type) {
+                auto alloc = result.get_allocator();
+                result.append_uninitialized(offsets.back(), [&](typename tree_t::pointer first) {
+                        std::vector<char> completed;
+                        auto error = run_threads(splits, [&](size_t first_k, size_t last_k) {
+                                auto dest = first + offsets[first_k];
+                                auto it = dest;
+                                try {
+                                        for (auto k = first_k; k < last_k; ++k)
+                                                for (auto& node : fragments_m[k]) {
+                                                        node_alloc_traits::construct(alloc, it, std::move(node));
+                                                        ++it;
+                                                }
+                                }
+                                catch (...) {
+                                        for (; dest != it; ++dest) node_alloc_traits::destroy(alloc, dest);
+                                        throw;
+                                }
+                        }, completed);
+                        if (!error) return;
+                        // the storage stays unchanged, so the completed ranges are destroyed here
+                        for (size_t t = 0; t + 1 < splits.size(); ++t) {
+                                if (!completed[t]) continue;
+                                for (auto pos = offsets[splits[t]]; pos < offsets[splits[t + 1]]; ++pos)
+                                        node_alloc_traits::destroy(alloc, &first[pos]);
+                        }
+                        std::rethrow_exception(error);
+                });
+        }
+
+        // storages without uninitialized appends, ex. std::vector, are value initialized serially
+        void move_nodes(tree_t& result, const std::vector<size_type>& offsets, const std::vector<size_t>& splits, std::false_type) {
+                result.resize(offsets.back());
+                std::vector<char> completed;
+                auto error = run_threads(splits, [&](size_t first_k, size_t last_k) {
+                        for (auto k = first_k; k < last_k; ++k)
+                                std::move(fragments_m[k].begin(), fragments_m[k].end(), result.begin() + offsets[k]);
+                }, completed);
+                if (error) std::rethrow_exception(error);
+        }
+
+        std::vector<tree_t> fragments_m;
+        std::vector<level_t> levels_m;
+        allocator_type alloc_m;
+};
+
+} // namespace vt
@@ -0,0 +1,253 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/subtree_index.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <cassert>
+
+namespace vt {
+
+enum class traversal_order {
+        pre_order,  // parents before their descendants
+        post_order  // descendants before their parents
+};
+
+/*!
+ * Runs fn(node, level) for every node of a tree on a pool of threads
+ *
+ * Work is split at subtree boundaries found with a subtree_index.
+ * Sibling ranges smaller than the grain size are processed serially.
+ * Each worker owns a deque of tasks, idle workers steal the oldest tasks of others.
+ *
+ * HINT: fn must not throw and is called concurrently for independent subtrees
+ */
+template<typename _tree_t>
+struct parallel_traversal
+{
+        using tree_t = _tree_t;
+        using size_type = typename tree_t::size_type;
+        using level_t = typename tree_t::level_t;
+        using index_t = subtree_index<tree_t>;
+
+        parallel_traversal(tree_t& tree, const index_t& index, size_type grain)
+                : tree_m(tree), index_m(index), grain_m(grain < 1 ? 1 : grain) {}
+
+        template<typename Fn>
+        void run(Fn fn, traversal_order order, size_t thread_count) {
+                if (tree_m.empty()) return;
+                thread_count = thread_count < 1 ? 1 : thread_count;
+
+                std::vector<worker> workers(thread_count);
+                join root{{1}, npos, 0, nullptr};
+                done_m = false;
+                workers[0].tasks.push_back({0, tree_m.size(), 0, &root, false});
+
+                auto work = [&](size_t self) {
+                        task t;
+                        while (!done_m.load(std::memory_order_acquire)) {
+                                if (pop(workers, self, t))
+                                        execute(workers[self], t, fn, order, &root);
+                                else
+                                        std::this_thread::yield();
+                        }
+                };
+                std::vector<std::thread> threads;
+                for (size_t w = 1; w < thread_count; ++w)
+                        threads.emplace_back(work, w);
+                work(0);
+                for (auto& thread : threads) thread.join();
+        }
+
+private:
+        static constexpr size_type npos = ~size_type();
+
+        struct join {
+                std::atomic<size_type> pending;
+                size_type node;
+                level_t level;
+                join* parent;
+        };
+
+        // a range of siblings at level or a single node with its subtree
+        struct task {
+                size_type first, last;
+                level_t level;
+                join* parent;
+                bool is_node;
+        };
+
+        struct worker {
+                std::mutex mutex;
+                std::deque<task> tasks;
+        };
+
+        bool pop(std::vector<worker>& workers, size_t self, task& t) {
+                {
+                        std::lock_guard<std::mutex> lock(workers[self].mutex);
+                        if (!workers[self].tasks.empty()) {
+                                t = workers[self].tasks.back();
+                                workers[self].tasks.pop_back();
+                                return true;
+                        }
+                }
+                for (size_t i = 1; i < workers.size(); ++i) {
+                        auto& victim = workers[(self + i) % workers.size()];
+                        std::lock_guard<std::mutex> lock(victim.mutex);
+                        if (!victim.tasks.empty()) {
+                                t = victim.tasks.front();
+                                victim.tasks.pop_front();
+                                return true;
+                        }
+                }
+                return false;
+        }
+
+        template<typename Fn>
+        void execute(worker& self, const task& t, Fn& fn, traversal_order order, join* root) {
+                if (t.is_node) {
+                        auto& node = tree_m[t.first];
+                        if (traversal_order::pre_order == order) {
+                                fn(node, t.level);
+                                split(self, t.first + 1, t.last, t.level + 1, t.parent, fn, order, root);
+                        }
+                        else {
+                                auto j = new join{{1}, t.first, t.level, t.parent};
+                                split(self, t.first + 1, t.last, t.level + 1, j, fn, order, root);
+                        }
+                        return;
+                }
+                split(self, t.first, t.last, t.level, t.parent, fn, order, root);
+        }
+
+        // processes a sibling range, hands out chunks of whole subtrees to other workers
+        template<typename Fn>
+        void split(worker& self, size_type first, size_type last, level_t level, join* parent,
+                   Fn& fn, traversal_order order, join* root) {
+                if (last - first <= grain_m) {
+                        if (traversal_order::pre_order == order)
+                                serial_pre_order(first, last, level, fn);
+                        else
+                                serial_post_order(first, last, level, fn);
+                        complete(parent, fn, root);
+                        return;
+                }
+                std::vector<task> tasks;
+                auto chunk = first;
+                for (auto s = first; s < last; s = index_m.end(s)) {
+                        auto s_end = index_m.end(s);
+                        if (s_end - s > grain_m) {
+                                if (chunk < s) tasks.push_back({chunk, s, level, parent, false});
+                                tasks.push_back({s, s_end, level, parent, true});
+                                chunk = s_end;
+                        }
+                        else if (chunk < s && s_end - chunk > grain_m) {
+                                tasks.push_back({chunk, s, level, parent, false});
+                                chunk = s;
+                        }
+                }
+                if (chunk < last) tasks.push_back({chunk, last, level, parent, false});
+                if (tasks.empty()) {
+                        complete(parent, fn, root);
+                        return;
+                }
+                // this task accounts for one pending count already
+                parent->pending.fetch_add(tasks.size() - 1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(self.mutex);
+                self.tasks.insert(self.tasks.end(), tasks.rbegin(), tasks.rend());
+        }
+
+        template<typename Fn>
+        void complete(join* j, Fn& fn, join* root) {
+                while (j && 1 == j->pending.fetch_sub(1, std::memory_order_acq_rel)) {
+                        if (j == root) {
+                                done_m.store(true, std::memory_order_release);
+                                return;
+                        }
+                        if (npos != j->node)
+                                fn(tree_m[j->node], j->level);
+                        auto parent = j->parent;
+                        delete j;
+                        j = parent;
+                }
+        }
+
+        template<typename Fn>
+        void serial_pre_order(size_type first, size_type last, level_t level, Fn& fn) {
+                for (auto pos = first; pos < last; ++pos) {
+                        auto& node = tree_m[pos];
+                        fn(node, level);
+                        level = level + 1 - drift_of(node);
+                }
+        }
+
+        template<typename Fn>
+        void serial_post_order(size_type first, size_type last, level_t level, Fn& fn) {
+                std::vector<std::pair<size_type, level_t>> open;
+                for (auto pos = first; pos < last; ++pos) {
+                        auto& node = tree_m[pos];
+                        if (0 == drift_of(node)) {
+                                open.emplace_back(pos, level);
+                                level += 1;
+                                continue;
+                        }
+                        fn(node, level);
+                        level = level + 1 - drift_of(node);
+                        for (auto drift = drift_of(node); drift > 1 && !open.empty(); --drift) {
+                                fn(tree_m[open.back().first], open.back().second);
+                                open.pop_back();
+                        }
+                }
+        }
+
+        tree_t& tree_m;
+        const index_t& index_m;
+        size_type grain_m;
+        std::atomic<bool> done_m = {false};
+};
+
+// parallel traversal with an existing subtree index
+template<typename tree_t, typename Fn>
+void parallel_for_each(tree_t& tree, const subtree_index<tree_t>& index, Fn fn,
+                       traversal_order order = traversal_order::pre_order,
+                       typename tree_t::size_type grain = 1024,
+                       size_t thread_count = std::thread::hardware_concurrency()) {
+        assert(index.size() == tree.size());
+        parallel_traversal<tree_t>(tree, index, grain).run(fn, order, thread_count);
+}
+
+// parallel traversal, builds the subtree index first
+// O(n/t + n)  n = nodes in the tree
+//             t = threads used
+template<typename tree_t, typename Fn>
+void parallel_for_each(tree_t& tree, Fn fn,
+                       traversal_order order = traversal_order::pre_order,
+                       typename tree_t::size_type grain = 1024,
+                       size_t thread_count = std::thread::hardware_concurrency()) {
+        subtree_index<tree_t> index(tree);
+        parallel_for_each(tree, index, fn, order, grain, thread_count);
+}
+
+} // namespace vt
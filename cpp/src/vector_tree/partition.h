@@ -0,0 +1,112 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/subtree_index.h"
+
+#include <vector>
+#include <cassert>
+
+namespace vt {
+
+/*!
+ * A contiguous part of a tree
+ *
+ * Either a sequence of whole sibling subtrees with roots at level
+ * or a single node at level followed by a prefix of its child subtrees.
+ */
+template<typename _tree_t>
+struct partition_range
+{
+        using size_type = typename _tree_t::size_type;
+        using level_t = typename _tree_t::level_t;
+
+        size_type first;
+        size_type last;
+        level_t level;  // level of the node at first
+
+        size_type size() const noexcept { return last - first; }
+};
+
+/* target_size = 3
+ *
+ * 1                   [1]        node without children, 1 2 3 4 is too large
+ *  2    5             [2 3 4]    whole sibling subtree
+ *   3 4  6 7 8        [5 6 7]    node with a prefix of its children
+ *                     [8]        remaining sibling subtree
+ */
+
+// splits the tree into ranges of at most target_size nodes without cutting through subtrees
+// only subtrees larger than target_size are split into the node and chunks of its children
+// O(k + s)  k = ranges returned
+//           s = sibling subtrees below the split nodes, O(n) for a wide root
+// HINT: the siblings are found by jumping from one subtree end to the next,
+//       a binary search of the chunk boundaries would need the levels or sibling links the index does not store
+template<typename tree_t>
+std::vector<partition_range<tree_t>> partition(const tree_t& tree, const subtree_index<tree_t>& index,
+                                               typename tree_t::size_type target_size) {
+        using size_type = typename tree_t::size_type;
+        using level_t = typename tree_t::level_t;
+        struct frame {
+                size_type next;
+                size_type last;
+                level_t level;
+        };
+
+        assert(index.size() == tree.size());
+        target_size = target_size < 1 ? 1 : target_size;
+        std::vector<partition_range<tree_t>> result;
+        if (tree.empty()) return result;
+
+        // the open range is [chunk, next sibling)
+        size_type chunk = 0;
+        level_t chunk_level = 0;
+        std::vector<frame> stack{{0, tree.size(), 0}};
+        while (!stack.empty()) {
+                auto& top = stack.back();
+                if (top.next >= top.last) {
+                        if (chunk < top.last) result.push_back({chunk, top.last, chunk_level});
+                        chunk = top.last;
+                        stack.pop_back();
+                        if (!stack.empty()) chunk_level = stack.back().level;
+                        continue;
+                }
+                auto s = top.next;
+                auto s_end = index.end(s);
+                auto level = top.level;
+                top.next = s_end;
+                if (s_end - chunk <= target_size) continue;
+                if (chunk < s) result.push_back({chunk, s, chunk_level});
+                chunk = s;
+                chunk_level = level;
+                if (s_end - s <= target_size) continue;
+                // keep the node in the open range and continue with its children
+                stack.push_back({s + 1, s_end, level + 1});
+        }
+        return result;
+}
+
+// splits the tree into ranges of at most target_size nodes without cutting through subtrees
+// O(n)  n = nodes in the tree, the subtree index is built first
+template<typename tree_t>
+std::vector<partition_range<tree_t>> partition(const tree_t& tree, typename tree_t::size_type target_size) {
+        return partition(tree, subtree_index<tree_t>(tree), target_size);
+}
+
+} // namespace vt
@@ -0,0 +1,237 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace vt {
+
+/* 1
+ *  2    5
+ *   3 4  6
+ *
+ * <0,1> <0,2> <1,3> <2,4> <0,5> <3,6>
+ * post order:          3 4 2 6 5 1
+ * reverse pre order:   6 5 4 3 2 1
+ */
+
+/*!
+ * Visits whole subtrees in post order, each node after all of its descendants
+ *
+ * Nodes with children are kept on a stack of open positions.
+ * The drift of a leaf tells how many of them are closed behind it.
+ * Levels are relative to the roots of the range.
+ */
+template<typename _tree_t>
+struct post_order_range
+{
+        using tree_t = _tree_t;
+        using level_t = typename tree_t::level_t;
+        using node_t = typename subtree<tree_t>::node_t;
+        using iterator_t = typename subtree<tree_t>::iterator_t;
+
+        struct iterator
+        {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = typename tree_t::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = node_t*;
+                using reference = node_t&;
+
+                iterator() = default;
+                iterator(iterator_t first, iterator_t last)
+                        : next_m(first), last_m(last), at_end_m(false) {
+                        ++(*this);
+                }
+
+                bool is_end() const noexcept { return at_end_m; }
+
+                bool operator == (const iterator &ot) const noexcept {
+                        if (this->is_end() || ot.is_end())
+                                return at_end_m == ot.at_end_m;
+                        return current_m == ot.current_m;
+                }
+                bool operator != (const iterator &ot) const noexcept {
+                        return ! (*this == ot);
+                }
+
+                reference operator*() const noexcept { return *current_m; }
+                pointer operator->() const noexcept { return &*current_m; }
+
+                iterator& operator++() {
+                        if (0 < closing_m && !open_m.empty()) {
+                                closing_m -= 1;
+                                current_m = open_m.back();
+                                open_m.pop_back();
+                                level_m = open_m.size();
+                                return *this;
+                        }
+                        while (next_m != last_m) {
+                                auto node = next_m++;
+                                if (0 == drift_of(*node)) {
+                                        open_m.push_back(node);
+                                        continue;
+                                }
+                                current_m = node;
+                                level_m = open_m.size();
+                                closing_m = drift_of(*node) - 1;
+                                return *this;
+                        }
+                        at_end_m = true;
+                        return *this;
+                }
+
+                iterator operator++(int) {
+                        auto __tmp = *this;
+                        ++(*this);
+                        return __tmp;
+                }
+
+                iterator_t unwrap() const noexcept { return current_m; }
+                level_t level() const noexcept { return level_m; }
+
+        private:
+                std::vector<iterator_t> open_m;
+                iterator_t current_m = {};
+                iterator_t next_m = {};
+                iterator_t last_m = {};
+                level_t level_m = {};
+                level_t closing_m = {};
+                bool at_end_m = true;
+        };
+
+        // all subtrees in [first, last), roots at relative level 0
+        post_order_range(iterator_t first, iterator_t last) noexcept
+                : first_m(first), last_m(last) {}
+
+        iterator begin() const { return iterator(first_m, last_m); }
+        iterator end() const noexcept { return iterator(); }
+
+private:
+        iterator_t first_m;
+        iterator_t last_m;
+};
+
+/*!
+ * Visits whole subtrees backwards, each node after all of its descendants
+ *
+ * Children are visited from the last to the first one.
+ * No stack is needed, the level is restored from the drift of the crossed node:
+ *   level(i) = level(i+1) - 1 + drift(i)
+ * This order suits aggregations that combine child results into the parent.
+ */
+template<typename _tree_t>
+struct reverse_pre_order_range
+{
+        using tree_t = _tree_t;
+        using level_t = typename tree_t::level_t;
+        using node_t = typename subtree<tree_t>::node_t;
+        using iterator_t = typename subtree<tree_t>::iterator_t;
+        using difference_t = std::ptrdiff_t;
+
+        struct iterator
+        {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = typename tree_t::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = node_t*;
+                using reference = node_t&;
+
+                iterator() = default;
+                // base is behind the current node, base_level is the level of the node at base
+                iterator(iterator_t base, difference_t base_level) noexcept
+                        : base_m(base), base_level_m(base_level) {}
+
+                bool operator == (const iterator &ot) const noexcept { return base_m == ot.base_m; }
+                bool operator != (const iterator &ot) const noexcept { return base_m != ot.base_m; }
+
+                reference operator*() const noexcept { return base_m[-1]; }
+                pointer operator->() const noexcept { return &base_m[-1]; }
+
+                iterator& operator++() noexcept {
+                        base_level_m += difference_t(drift_of(base_m[-1])) - 1;
+                        --base_m;
+                        return *this;
+                }
+
+                iterator operator++(int) noexcept {
+                        auto __tmp = *this;
+                        ++(*this);
+                        return __tmp;
+                }
+
+                iterator_t unwrap() const noexcept { return base_m - 1; }
+                level_t level() const noexcept {
+                        return level_t(base_level_m + difference_t(drift_of(base_m[-1])) - 1);
+                }
+
+        private:
+                iterator_t base_m = {};
+                difference_t base_level_m = {};
+        };
+
+        // all subtrees in [first, last), the node at last has last_level relative to first
+        reverse_pre_order_range(iterator_t first, iterator_t last, difference_t last_level) noexcept
+                : first_m(first), last_m(last), last_level_m(last_level) {}
+
+        iterator begin() const noexcept { return iterator(last_m, last_level_m); }
+        iterator end() const noexcept { return iterator(first_m, 0); }
+
+private:
+        iterator_t first_m;
+        iterator_t last_m;
+        difference_t last_level_m;
+};
+
+// post order of all nodes in the tree
+template<typename tree_t>
+post_order_range<tree_t> post_order(tree_t& tree) noexcept {
+        return {tree.begin(), tree.end()};
+}
+
+// post order of the subtree including its root
+// O(m)  m = nodes in the subtree, the end of the subtree is resolved first
+template<typename tree_t>
+post_order_range<tree_t> post_order(subtree<tree_t> st) noexcept {
+        return {st.unwrap(), find_subtree_end(st.unwrap())};
+}
+
+// all nodes of the tree backwards, the virtual node behind the tree has level 0
+template<typename tree_t>
+reverse_pre_order_range<tree_t> reverse_pre_order(tree_t& tree) noexcept {
+        return {tree.begin(), tree.end(), 0};
+}
+
+// the subtree including its root backwards
+// O(m)  m = nodes in the subtree, the end of the subtree is resolved first
+template<typename tree_t>
+reverse_pre_order_range<tree_t> reverse_pre_order(subtree<tree_t> st) noexcept {
+        using difference_t = std::ptrdiff_t;
+        auto root = st.unwrap();
+        difference_t level = 1 - difference_t(drift_of(*root));
+        auto last = root + 1;
+        for (; level > 0; ++last) level += 1 - difference_t(drift_of(*last));
+        return {root, last, level};
+}
+
+} // namespace vt
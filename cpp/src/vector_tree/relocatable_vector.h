@@ -0,0 +1,169 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/relocation.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vt {
+
+/*!
+ * A vector for trivially relocatable types
+ *
+ * Growth, the shifts of inserts and the compaction of erases move the
+ * elements with memcpy/memmove instead of move constructing and destroying
+ * each of them. The interface follows std::vector as far as drift_tree uses it.
+ *
+ * HINT: iterators are plain pointers and invalidated like std::vector iterators
+ * HINT: inserted ranges must not point into the vector itself
+ */
+template<typename _value_t, typename _alloc_t = std::allocator<_value_t>>
+struct relocatable_vector : relocation_buffer<relocatable_vector<_value_t, _alloc_t>, _value_t, _alloc_t>
+{
+        static_assert(is_trivially_relocatable<_value_t>::value,
+                      "relocatable_vector requires a trivially relocatable type, specialize vt::is_trivially_relocatable");
+
+        using base_t = relocation_buffer<relocatable_vector<_value_t, _alloc_t>, _value_t, _alloc_t>;
+        using typename base_t::value_type;
+        using typename base_t::allocator_type;
+        using typename base_t::alloc_traits;
+        using typename base_t::size_type;
+        using typename base_t::pointer;
+        using typename base_t::iterator;
+        using typename base_t::const_iterator;
+
+        explicit relocatable_vector(const allocator_type& alloc = allocator_type()) noexcept
+                : base_t(alloc) {}
+
+        relocatable_vector(const relocatable_vector& other)
+                : relocatable_vector(other, alloc_traits::select_on_container_copy_construction(other.alloc_m)) {}
+
+        relocatable_vector(const relocatable_vector& other, const allocator_type& alloc)
+                : base_t(other, alloc) {}
+
+        relocatable_vector(relocatable_vector&& other) noexcept
+                : base_t(std::move(other)) {}
+
+        relocatable_vector& operator =(const relocatable_vector& other) {
+                if (this != &other) {
+                        relocatable_vector copy(other);
+                        swap(copy);
+                }
+                return *this;
+        }
+        // HINT: the allocator moves along with the buffer
+        relocatable_vector& operator =(relocatable_vector&& other) noexcept {
+                relocatable_vector moved(std::move(other));
+                swap(moved);
+                return *this;
+        }
+
+        void swap(relocatable_vector& other) noexcept { this->swap_buffer(other); }
+
+        template< class ForwardIt >
+        void assign(ForwardIt first, ForwardIt last) {
+                clear();
+                insert(this->end(), first, last);
+        }
+
+        void clear() noexcept {
+                this->destroy(this->begin_m, this->end_m);
+                this->end_m = this->begin_m;
+        }
+
+        template< class... Args >
+        iterator emplace(const_iterator pos, Args&&... args) {
+                auto index = size_type(pos - this->begin_m);
+                if (this->end_m == this->capacity_m) return this->emplace_grow(index, std::forward<Args>(args)...);
+                if (index == this->size()) return &this->emplace_back(std::forward<Args>(args)...);
+                // the arguments may refer to shifted elements, construct them aside first
+                typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type buffer;
+                auto value = reinterpret_cast<pointer>(&buffer);
+                alloc_traits::construct(this->alloc_m, value, std::forward<Args>(args)...);
+                auto at = this->begin_m + index;
+                relocate(at, this->size() - index, at + 1);
+                relocate(value, 1, at);
+                this->end_m += 1;
+                return at;
+        }
+
+        template< class ForwardIt >
+        iterator insert(const_iterator pos, ForwardIt first, ForwardIt last) {
+                auto index = size_type(pos - this->begin_m);
+                auto count = size_type(std::distance(first, last));
+                if (0 == count) return this->begin_m + index;
+                if (count > this->tailroom()) return this->insert_grow(index, count, first, last);
+                auto at = this->begin_m + index;
+                auto tail = this->size() - index;
+                relocate(at, tail, at + count);
+                try {
+                        this->construct(at, first, last);
+                }
+                catch (...) {
+                        relocate(at + count, tail, at);
+                        throw;
+                }
+                this->end_m += count;
+                return at;
+        }
+
+        iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+        iterator erase(const_iterator first, const_iterator last) {
+                auto at = this->begin_m + (first - this->begin_m);
+                auto count = size_type(last - first);
+                this->destroy(at, at + count);
+                relocate(at + count, size_type(this->end_m - at) - count, at);
+                this->end_m -= count;
+                return at;
+        }
+
+private:
+        friend base_t;
+
+        // doubles the capacity, the elements start at the front
+        typename base_t::grown_buffer allocate_grown(size_type, size_type count) {
+                auto needed = this->size() + count;
+                if (needed > this->max_size() || needed < count) throw std::length_error("relocatable_vector too large");
+                auto capacity = this->capacity();
+                auto doubled = capacity < this->max_size() / 2 ? 2 * capacity : this->max_size();
+                auto new_cap = std::max(needed, doubled);
+                auto first = alloc_traits::allocate(this->alloc_m, new_cap);
+                return {first, first, new_cap};
+        }
+};
+
+// relocatable_vector for trivially relocatable nodes, std::vector otherwise
+template<typename node_t, typename alloc_t = std::allocator<node_t>>
+using relocating_storage_t = std::conditional_t<is_trivially_relocatable<node_t>::value,
+        relocatable_vector<node_t, alloc_t>, std::vector<node_t, alloc_t>>;
+
+// drift_tree that relocates its nodes with memmove whenever the payload allows it
+template<typename data_t, typename drift_t = size_t>
+using relocating_drift_tree = drift_tree<data_t, drift_t, std::allocator<node_layout_t<data_t, drift_t>>,
+        relocating_storage_t<node_layout_t<data_t, drift_t>>>;
+
+} // namespace vt
@@ -0,0 +1,366 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vt {
+
+/*!
+ * Customization point for types that can be moved in memory by copying their bytes
+ *
+ * A relocation is a move construction followed by the destruction of the source.
+ * Types without pointers into themselves can be relocated with memcpy or memmove.
+ * Specialize this trait for own payload types:
+ *
+ * template<> struct vt::is_trivially_relocatable<my_handle> : std::true_type {};
+ *
+ * The node types of the trees forward it to their payload, so a specialized payload
+ * makes its nodes relocatable as well.
+ */
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+template<typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template<typename A, typename B>
+struct is_trivially_relocatable<std::pair<A, B>>
+        : std::integral_constant<bool, is_trivially_relocatable<A>::value && is_trivially_relocatable<B>::value> {};
+
+// vectors only point to their heap buffer, except for checked iterators in debug builds
+#if (defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)) || defined(_LIBCPP_VERSION)
+template<typename T>
+struct is_trivially_relocatable<std::vector<T>> : std::true_type {};
+#endif
+
+// HINT: libstdc++ strings point into their own small string buffer
+#if defined(_LIBCPP_VERSION)
+template<typename C, typename Traits>
+struct is_trivially_relocatable<std::basic_string<C, Traits>> : std::true_type {};
+#endif
+
+namespace detail {
+
+template<typename T>
+void relocate(T* source, size_t count, T* dest, std::true_type) noexcept {
+        if (0 < count && source != dest)
+                std::memmove(static_cast<void*>(dest), static_cast<const void*>(source), count * sizeof(T));
+}
+
+// one object after the other, in the order that never overwrites a live source
+template<typename T>
+void relocate(T* source, size_t count, T* dest, std::false_type) noexcept {
+        if (dest < source) {
+                for (size_t i = 0; i < count; ++i) {
+                        ::new (static_cast<void*>(dest + i)) T(std::move(source[i]));
+                        source[i].~T();
+                }
+        }
+        else if (source < dest) {
+                for (size_t i = count; 0 < i; --i) {
+                        ::new (static_cast<void*>(dest + i - 1)) T(std::move(source[i - 1]));
+                        source[i - 1].~T();
+                }
+        }
+}
+
+} // namespace detail
+
+// moves count objects from source to the uninitialized dest, the ranges may overlap
+// afterwards source is uninitialized memory
+// uses memmove for trivially relocatable types, nothrow moves otherwise
+template<typename T>
+void relocate(T* source, size_t count, T* dest) noexcept {
+        static_assert(is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value,
+                      "relocate requires a trivially relocatable or nothrow movable type");
+        detail::relocate(source, count, dest, is_trivially_relocatable<T>{});
+}
+
+/*!
+ * Buffer of a vector that relocates its elements, see relocatable_vector and double_ended_vector
+ *
+ * The elements live in [begin_m, end_m) of the allocation [buffer_m, capacity_m).
+ * Provides the std::vector accessors and appending. The derived vector decides where
+ * the elements of a new buffer start with grown_buffer allocate_grown(index, count),
+ * the base calls it when count elements are inserted at index without room left.
+ * New elements are constructed in a grown buffer before the old ones relocate,
+ * so a throwing constructor leaves the vector unchanged.
+ */
+template<typename _derived_t, typename _value_t, typename _alloc_t>
+struct relocation_buffer
+{
+        using value_type = _value_t;
+        using allocator_type = _alloc_t;
+        using alloc_traits = std::allocator_traits<allocator_type>;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using pointer = value_type*;
+        using const_pointer = const value_type*;
+        using iterator = value_type*;
+        using const_iterator = const value_type*;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        allocator_type get_allocator() const noexcept { return alloc_m; }
+
+        reference at(size_type pos) {
+                if (pos >= size()) throw std::out_of_range("relocation_buffer::at");
+                return begin_m[pos];
+        }
+        const_reference at(size_type pos) const {
+                if (pos >= size()) throw std::out_of_range("relocation_buffer::at");
+                return begin_m[pos];
+        }
+
+        reference operator[](size_type pos) noexcept { return begin_m[pos]; }
+        const_reference operator[](size_type pos) const noexcept { return begin_m[pos]; }
+
+        reference front() noexcept { return *begin_m; }
+        const_reference front() const noexcept { return *begin_m; }
+
+        reference back() noexcept { return end_m[-1]; }
+        const_reference back() const noexcept { return end_m[-1]; }
+
+        pointer data() noexcept { return begin_m; }
+        const_pointer data() const noexcept { return begin_m; }
+
+        iterator begin() noexcept { return begin_m; }
+        const_iterator begin() const noexcept { return begin_m; }
+        const_iterator cbegin() const noexcept { return begin_m; }
+
+        iterator end() noexcept { return end_m; }
+        const_iterator end() const noexcept { return end_m; }
+        const_iterator cend() const noexcept { return end_m; }
+
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+        const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+        bool empty() const noexcept { return begin_m == end_m; }
+
+        size_type size() const noexcept { return end_m - begin_m; }
+        size_type max_size() const noexcept { return alloc_traits::max_size(alloc_m); }
+        // elements that fit without reallocation when appending
+        size_type capacity() const noexcept { return capacity_m - begin_m; }
+
+        // keeps the headroom, grows the tailroom
+        void reserve(size_type new_cap) {
+                if (new_cap > capacity()) reallocate(headroom(), new_cap - size());
+        }
+
+        void shrink_to_fit() {
+                if (begin_m != buffer_m || end_m != capacity_m) reallocate(0, 0);
+        }
+
+        // new elements are value initialized
+        void resize(size_type count) {
+                if (count <= size()) {
+                        destroy(begin_m + count, end_m);
+                        end_m = begin_m + count;
+                        return;
+                }
+                reserve(count);
+                auto last = begin_m + count;
+                auto it = end_m;
+                try {
+                        for (; it != last; ++it) alloc_traits::construct(alloc_m, it);
+                }
+                catch (...) {
+                        destroy(end_m, it);
+                        throw;
+                }
+                end_m = last;
+        }
+
+        // appends count elements that fill(first) constructs in the uninitialized tail
+        // HINT: if fill throws it has to destroy the elements it constructed, the vector stays unchanged
+        template< class Fill >
+        void append_uninitialized(size_type count, Fill&& fill) {
+                if (count > max_size() - size()) throw std::length_error("relocation_buffer too large");
+                reserve(size() + count);
+                fill(end_m);
+                end_m += count;
+        }
+
+        template< class... Args >
+        reference emplace_back(Args&&... args) {
+                if (end_m == capacity_m) return *emplace_grow(size(), std::forward<Args>(args)...);
+                alloc_traits::construct(alloc_m, end_m, std::forward<Args>(args)...);
+                return *end_m++;
+        }
+
+        void pop_back() noexcept {
+                end_m -= 1;
+                alloc_traits::destroy(alloc_m, end_m);
+        }
+
+protected:
+        // a new allocation, the elements start at begin
+        struct grown_buffer {
+                pointer first;
+                pointer begin;
+                size_type capacity;
+        };
+
+        explicit relocation_buffer(const allocator_type& alloc) noexcept
+                : alloc_m(alloc) {}
+
+        // the copy has no free capacity
+        relocation_buffer(const relocation_buffer& other, const allocator_type& alloc)
+                : alloc_m(alloc) {
+                auto count = other.size();
+                if (0 == count) return;
+                auto first = alloc_traits::allocate(alloc_m, count);
+                try {
+                        construct(first, other.begin(), other.end());
+                }
+                catch (...) {
+                        alloc_traits::deallocate(alloc_m, first, count);
+                        throw;
+                }
+                adopt({first, first, count}, count);
+        }
+
+        relocation_buffer(relocation_buffer&& other) noexcept
+                : alloc_m(std::move(other.alloc_m)), buffer_m(other.buffer_m), begin_m(other.begin_m),
+                  end_m(other.end_m), capacity_m(other.capacity_m) {
+                other.buffer_m = other.begin_m = other.end_m = other.capacity_m = nullptr;
+        }
+
+        ~relocation_buffer() { release(); }
+
+        void swap_buffer(relocation_buffer& other) noexcept {
+                using std::swap;
+                swap(alloc_m, other.alloc_m);
+                swap(buffer_m, other.buffer_m);
+                swap(begin_m, other.begin_m);
+                swap(end_m, other.end_m);
+                swap(capacity_m, other.capacity_m);
+        }
+
+        size_type headroom() const noexcept { return begin_m - buffer_m; }
+        size_type tailroom() const noexcept { return capacity_m - end_m; }
+
+        // constructs the new element in the grown buffer before the old elements move
+        template< class... Args >
+        iterator emplace_grow(size_type index, Args&&... args) {
+                auto old_size = size();
+                auto buffer = static_cast<_derived_t&>(*this).allocate_grown(index, 1);
+                auto at = buffer.begin + index;
+                try {
+                        alloc_traits::construct(alloc_m, at, std::forward<Args>(args)...);
+                }
+                catch (...) {
+                        alloc_traits::deallocate(alloc_m, buffer.first, buffer.capacity);
+                        throw;
+                }
+                relocate(begin_m, index, buffer.begin);
+                if (index < old_size) relocate(begin_m + index, old_size - index, at + 1);
+                adopt(buffer, old_size + 1);
+                return at;
+        }
+
+        template< class ForwardIt >
+        iterator insert_grow(size_type index, size_type count, ForwardIt first, ForwardIt last) {
+                auto old_size = size();
+                auto buffer = static_cast<_derived_t&>(*this).allocate_grown(index, count);
+                auto at = buffer.begin + index;
+                try {
+                        construct(at, first, last);
+                }
+                catch (...) {
+                        alloc_traits::deallocate(alloc_m, buffer.first, buffer.capacity);
+                        throw;
+                }
+                relocate(begin_m, index, buffer.begin);
+                if (index < old_size) relocate(begin_m + index, old_size - index, at + count);
+                adopt(buffer, old_size + count);
+                return at;
+        }
+
+        void reallocate(size_type front, size_type back) {
+                auto count = size();
+                auto capacity = front + count + back;
+                auto first = 0 < capacity ? alloc_traits::allocate(alloc_m, capacity) : nullptr;
+                relocate(begin_m, count, first + front);
+                adopt({first, first + front, capacity}, count);
+        }
+
+        // the old buffer only contains relocated elements, it is freed without destructors
+        void adopt(grown_buffer buffer, size_type count) noexcept {
+                if (buffer_m) alloc_traits::deallocate(alloc_m, buffer_m, capacity_m - buffer_m);
+                buffer_m = buffer.first;
+                begin_m = buffer.begin;
+                end_m = buffer.begin + count;
+                capacity_m = buffer.first + buffer.capacity;
+        }
+
+        template< class ForwardIt >
+        void construct(pointer dest, ForwardIt first, ForwardIt last) {
+                auto it = dest;
+                try {
+                        for (; first != last; ++first, ++it) alloc_traits::construct(alloc_m, it, *first);
+                }
+                catch (...) {
+                        destroy(dest, it);
+                        throw;
+                }
+        }
+
+        void destroy(pointer first, pointer last) noexcept {
+                for (; first != last; ++first) alloc_traits::destroy(alloc_m, first);
+        }
+
+        void release() noexcept {
+                destroy(begin_m, end_m);
+                if (buffer_m) alloc_traits::deallocate(alloc_m, buffer_m, capacity_m - buffer_m);
+                buffer_m = begin_m = end_m = capacity_m = nullptr;
+        }
+
+        allocator_type alloc_m;
+        pointer buffer_m = nullptr;
+        pointer begin_m = nullptr;
+        pointer end_m = nullptr;
+        pointer capacity_m = nullptr;
+};
+
+// storages that construct appended elements in place, see relocation_buffer::append_uninitialized
+template<typename vector_t>
+struct has_uninitialized_append
+        : std::is_base_of<relocation_buffer<vector_t, typename vector_t::value_type, typename vector_t::allocator_type>, vector_t> {};
+
+} // namespace vt
@@ -0,0 +1,188 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <cassert>
+
+namespace vt {
+
+/*!
+ * A drift tree with fixed capacity that can be built at compile time
+ *
+ * constexpr static_drift_tree<const char*, 3> make_menu() {
+ *         static_drift_tree<const char*, 3> t;
+ *         t.push_root("file");
+ *         t.push_back_child("open");
+ *         t.push_back_sibling("save");
+ *         return t;
+ * }
+ * constexpr auto menu = make_menu();
+ *
+ * Exceeding the capacity throws, which fails the compile time evaluation.
+ * Data has to be a literal type to build the tree in a constant expression.
+ */
+template< typename _data_t, size_t _capacity, typename _drift_t = size_t>
+struct static_drift_tree
+{
+        using data_t = _data_t;
+        using node_t = node_layout_t<_data_t, _drift_t>;
+        using traits_t = node_traits<node_t>;
+        using drift_t = typename traits_t::drift_t;
+
+        using level_t = size_t;
+        enum {
+                DRIFT_CHILD = 0,
+                DRIFT_SIBLING = 1
+        };
+
+        using value_type = node_t;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+        using reference = node_t&;
+        using const_reference = const node_t&;
+        using pointer = node_t*;
+        using const_pointer = const node_t*;
+        using iterator = node_t*;
+        using const_iterator = const node_t*;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        constexpr static_drift_tree() noexcept
+                : nodes_m{}, size_m(0) {}
+
+        constexpr reference at(size_type pos) {
+                return pos < size_m ? nodes_m[pos] : throw std::out_of_range("static_drift_tree::at");
+        }
+        constexpr const_reference at(size_type pos) const {
+                return pos < size_m ? nodes_m[pos] : throw std::out_of_range("static_drift_tree::at");
+        }
+
+        constexpr reference operator[](size_type pos) noexcept { return nodes_m[pos]; }
+        constexpr const_reference operator[](size_type pos) const noexcept { return nodes_m[pos]; }
+
+        constexpr reference front() noexcept { return nodes_m[0]; }
+        constexpr const_reference front() const noexcept { return nodes_m[0]; }
+
+        constexpr reference back() noexcept { return nodes_m[size_m - 1]; }
+        constexpr const_reference back() const noexcept { return nodes_m[size_m - 1]; }
+
+        constexpr iterator begin() noexcept { return nodes_m; }
+        constexpr const_iterator begin() const noexcept { return nodes_m; }
+        constexpr const_iterator cbegin() const noexcept { return nodes_m; }
+
+        constexpr iterator end() noexcept { return nodes_m + size_m; }
+        constexpr const_iterator end() const noexcept { return nodes_m + size_m; }
+        constexpr const_iterator cend() const noexcept { return nodes_m + size_m; }
+
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+        const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+        constexpr bool empty() const noexcept { return 0 == size_m; }
+
+        constexpr size_type size() const noexcept { return size_m; }
+        constexpr size_type max_size() const noexcept { return _capacity; }
+        constexpr size_type capacity() const noexcept { return _capacity; }
+
+        constexpr void clear() noexcept { size_m = 0; }
+
+        // make the value the new root
+        // HINT: Use this method for the first node!
+        // O(n)  n = number of nodes already in the tree
+        constexpr void push_root(data_t value) {
+                auto back_drift = empty() ? drift_t(1) : checked(level_t(1) + drift_of(back()));
+                grow();
+                for (auto i = size_m - 1; i > 0; --i) nodes_m[i] = nodes_m[i - 1];
+                nodes_m[0] = node_t(0, std::move(value));
+                set_drift(back(), back_drift);
+        }
+
+        // append a node to the end with a drifted level
+        // O(1)
+        constexpr void push_back_drifted(data_t data, drift_t back_drift) {
+                assert(0 < size());
+                assert(1 + drift_of(back()) > back_drift);
+                auto drift = checked(level_t(1) + drift_of(back()) - back_drift);
+                grow();
+                set_drift(nodes_m[size_m - 2], back_drift);
+                back() = node_t(drift, std::move(data));
+        }
+
+        constexpr void push_back_child(data_t data) {
+                push_back_drifted(std::move(data), DRIFT_CHILD);
+        }
+
+        constexpr void push_back_sibling(data_t data) {
+                push_back_drifted(std::move(data), DRIFT_SIBLING);
+        }
+
+        // append a node at a specific level
+        // O(1)
+        constexpr void push_back_level(data_t data, level_t level) {
+                assert(0 < size());
+                assert(drift_of(back()) > level);
+                auto drift = checked(level_t(1) + level);
+                grow();
+                set_drift(nodes_m[size_m - 2], drift_of(nodes_m[size_m - 2]) - level);
+                back() = node_t(drift, std::move(data));
+        }
+
+        // remove the last node
+        constexpr void pop_back() {
+                assert(1 < size());
+                auto drift = checked(level_t(drift_of(nodes_m[size_m - 2])) + drift_of(back()) - 1);
+                size_m -= 1;
+                set_drift(back(), drift);
+        }
+
+        // checks all invariants of the drift encoding
+        // O(n)  n = number of nodes
+        constexpr bool is_valid() const noexcept {
+                if (empty()) return true;
+                size_type level = 0;
+                for (size_type i = 0; i < size_m; ++i) {
+                        if (drift_of(nodes_m[i]) > level + 1) return false;
+                        level = level + 1 - drift_of(nodes_m[i]);
+                }
+                return 0 == level;
+        }
+
+private:
+        static constexpr drift_t checked(level_t drift) { return checked_drift<drift_t>(drift, traits_t::max_drift()); }
+
+        constexpr void grow() {
+                if (size_m == _capacity) throw std::length_error("static_drift_tree capacity exceeded");
+                size_m += 1;
+        }
+
+        node_t nodes_m[_capacity];
+        size_type size_m;
+};
+
+} // namespace vt
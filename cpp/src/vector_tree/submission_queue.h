@@ -0,0 +1,146 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <utility>
+
+namespace vt {
+
+/*!
+ * Collects finished subtrees from many producer threads
+ * A single committer attaches all pending subtrees with one rebuild of the tree
+ *
+ * - submit() is lock-free and never waits for the committer
+ * - commit() must not be called concurrently with itself
+ * - parent positions refer to the tree as it is when commit() runs
+ */
+template<typename _tree_t>
+struct submission_queue
+{
+        using tree_t = _tree_t;
+        using size_type = typename tree_t::size_type;
+
+        submission_queue() = default;
+        submission_queue(const submission_queue&) = delete;
+        submission_queue& operator =(const submission_queue&) = delete;
+
+        ~submission_queue() { release(head_m.exchange(nullptr)); }
+
+        // hand over a subtree that becomes a first child of the parent position
+        // lock-free, safe to call from any thread
+        void submit(size_type parent, tree_t subtree) {
+                auto node = new submission{parent, std::move(subtree), nullptr};
+                node->next = head_m.load(std::memory_order_relaxed);
+                while (!head_m.compare_exchange_weak(node->next, node,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed)) {}
+        }
+
+        bool empty() const noexcept {
+                return nullptr == head_m.load(std::memory_order_acquire);
+        }
+
+        // attach all pending subtrees with a single rebuild
+        // subtrees for the same parent keep their submission order
+        // returns the number of attached subtrees
+        // submissions with a parent position behind the tree are dropped and std::out_of_range is thrown,
+        // on this or any other exception the tree is unchanged and the other submissions stay queued
+        // O(n+m)  n = nodes in the tree
+        //         m = nodes submitted
+        size_type commit(tree_t& tree) {
+                auto head = head_m.exchange(nullptr, std::memory_order_acquire);
+                if (!head) return 0;
+
+                size_type dropped = 0;
+                for (auto link = &head; *link;) {
+                        auto invalid = *link;
+                        if (invalid->parent < tree.size()) {
+                                link = &invalid->next;
+                                continue;
+                        }
+                        *link = invalid->next;
+                        delete invalid;
+                        ++dropped;
+                }
+                if (0 < dropped) {
+                        if (head) restore(head);
+                        throw std::out_of_range("submission_queue parent position");
+                }
+
+                // the stack yields the newest submission first
+                using range_t = leveled_range<typename tree_t::const_iterator>;
+                std::vector<std::pair<size_type, range_t>> pending;
+                try {
+                        for (auto it = head; it; it = it->next)
+                                pending.emplace_back(it->parent, range_t(it->subtree.cbegin(), it->subtree.cend()));
+                        std::reverse(pending.begin(), pending.end());
+                        std::stable_sort(pending.begin(), pending.end(),
+                                         [](const auto& l, const auto& r) { return l.first < r.first; });
+                        tree.insert_child_trees(pending.begin(), pending.end());
+                }
+                catch (...) {
+                        restore(head);
+                        throw;
+                }
+                release(head);
+                return pending.size();
+        }
+
+private:
+        struct submission {
+                size_type parent;
+                tree_t subtree;
+                submission* next;
+        };
+
+        static void release(submission* head) noexcept {
+                while (head) {
+                        auto next = head->next;
+                        delete head;
+                        head = next;
+                }
+        }
+
+        // puts taken submissions back behind those submitted since they were taken
+        void restore(submission* taken) noexcept {
+                for (;;) {
+                        auto newer = head_m.exchange(nullptr, std::memory_order_acquire);
+                        if (newer) {
+                                auto last = newer;
+                                while (last->next) last = last->next;
+                                last->next = taken;
+                                taken = newer;
+                        }
+                        submission* expected = nullptr;
+                        if (head_m.compare_exchange_strong(expected, taken,
+                                                           std::memory_order_release,
+                                                           std::memory_order_relaxed)) return;
+                }
+        }
+
+        std::atomic<submission*> head_m = {nullptr};
+};
+
+} // namespace vt
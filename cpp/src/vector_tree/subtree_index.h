@@ -0,0 +1,86 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <cassert>
+
+namespace vt {
+
+/* 1
+ *  2    5
+ *   3 4  6
+ *
+ * <0,1> <0,2> <1,3> <2,4> <0,5> <3,6>
+ * ends:  6     4     3     4     6     6
+ */
+
+/*!
+ * Stores the position behind the last descendant of each node
+ *
+ * A drift counts the subtrees that end with its node,
+ * so a stack of open positions is enough to fill the index in one pass.
+ * Siblings are found by jumping: next_sibling = ends[node]
+ *
+ * The index has to be rebuilt after structural changes of the tree.
+ */
+template<typename _tree_t>
+struct subtree_index
+{
+        using tree_t = _tree_t;
+        using size_type = typename tree_t::size_type;
+        using vector_t = std::vector<size_type>;
+
+        subtree_index() = default;
+
+        // O(n)  n = nodes in the tree
+        explicit subtree_index(const tree_t& tree) {
+                ends_m.resize(tree.size());
+                vector_t open;
+                size_type pos = 0;
+                for (const auto& node : tree) {
+                        open.push_back(pos);
+                        ++pos;
+                        for (auto drift = drift_of(node); drift > 0 && !open.empty(); --drift) {
+                                ends_m[open.back()] = pos;
+                                open.pop_back();
+                        }
+                }
+                assert(open.empty());
+        }
+
+        bool empty() const noexcept { return ends_m.empty(); }
+        size_type size() const noexcept { return ends_m.size(); }
+
+        // position behind the subtree of node at pos
+        size_type end(size_type pos) const noexcept { return ends_m[pos]; }
+
+        // number of nodes in the subtree of pos including pos itself
+        size_type subtree_size(size_type pos) const noexcept { return ends_m[pos] - pos; }
+
+        size_type operator[](size_type pos) const noexcept { return ends_m[pos]; }
+
+        // heap bytes of the index, ex. for memory_report
+        size_t memory_bytes() const noexcept { return ends_m.capacity() * sizeof(size_type); }
+
+private:
+        vector_t ends_m;
+};
+
+} // namespace vt
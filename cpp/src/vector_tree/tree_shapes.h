@@ -0,0 +1,302 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+namespace vt {
+
+/*!
+ * Generators for the level sequences of typical tree shapes
+ *
+ * A shape produces the levels of one tree in pre order, next() returns 0
+ * for the root and levels >= 1 afterwards. Every level is at most one below
+ * the previous one. Shapes with randomness are reproducible by their seed.
+ *
+ * generate_tree() writes the nodes into presized storage in one pass,
+ * generate() passes the (position, level) stream to a callback.
+ */
+
+// small and fast random numbers for the shapes, not for cryptography
+struct shape_random
+{
+        explicit shape_random(uint64_t seed) noexcept
+                : state_m(seed) {}
+
+        // splitmix64
+        uint64_t operator()() noexcept {
+                auto z = (state_m += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+        }
+
+        // [0, bound) by a multiply high where available, bound > 0
+        uint64_t below(uint64_t bound) noexcept {
+#if defined(__SIZEOF_INT128__)
+                return uint64_t((unsigned __int128)(*this)() * bound >> 64);
+#else
+                return (*this)() % bound;
+#endif
+        }
+
+        // true with probability p / 2^32
+        bool chance(uint32_t p) noexcept { return uint32_t((*this)()) < p; }
+
+private:
+        uint64_t state_m;
+};
+
+namespace detail {
+
+// condition ? a : b without a branch
+constexpr size_t select(bool condition, size_t a, size_t b) noexcept {
+        return b ^ ((a ^ b) & (size_t(0) - size_t(condition)));
+}
+
+} // namespace detail
+
+// probability in [0, 1] for shape_random::chance
+constexpr uint32_t shape_probability(double p) noexcept {
+        return p <= 0 ? 0 : p >= 1 ? UINT32_MAX : uint32_t(p * 4294967296.0);
+}
+
+/* length = 3
+ *
+ * r
+ *  1 2 3
+ *  4 5 6
+ */
+// chains of length nodes below a single root, one long chain by default
+struct chain_shape
+{
+        using level_t = size_t;
+
+        explicit chain_shape(size_t length = size_t(-1)) noexcept
+                : length_m(length < 1 ? 1 : length) {}
+
+        level_t next() noexcept {
+                if (first_m) {
+                        first_m = false;
+                        return 0;
+                }
+                level_m = level_m == length_m ? 1 : level_m + 1;
+                return level_m;
+        }
+
+private:
+        size_t length_m;
+        level_t level_m = 0;
+        bool first_m = true;
+};
+
+/* arity = 2, count = 6
+ *
+ * 0
+ *  1    2
+ *   3 4  5
+ */
+// complete k-ary tree of count nodes, filled level by level
+// arity 1 is a chain, arity >= count a single root with count - 1 leaves
+// walks the breadth first numbering in pre order without a stack:
+// children of i are k*i+1 .. k*i+k, the parent of i is (i-1)/k
+struct kary_shape
+{
+        using level_t = size_t;
+
+        kary_shape(size_t arity, size_t count) noexcept
+                : arity_m(arity < 1 ? 1 : arity), count_m(count),
+                  last_parent_m(count < 2 ? 0 : (count - 2) / (arity < 1 ? 1 : arity)) {}
+
+        // the level of the next node, count nodes are produced
+        level_t next() noexcept {
+                if (first_m) {
+                        first_m = false;
+                        return 0;
+                }
+                if (index_m <= last_parent_m) {
+                        // first child
+                        index_m = index_m * arity_m + 1;
+                        sibling_m = 0;
+                        return ++level_m;
+                }
+                // climb while the node is the last child of its parent
+                while (sibling_m + 1 == arity_m || index_m + 1 == count_m) {
+                        assert(1 < level_m);
+                        index_m = (index_m - 1) / arity_m;
+                        sibling_m = (index_m - 1) % arity_m;
+                        level_m -= 1;
+                }
+                index_m += 1;
+                sibling_m += 1;
+                return level_m;
+        }
+
+private:
+        size_t arity_m;
+        size_t count_m;
+        size_t last_parent_m;  // largest index with children
+        size_t index_m = 0;
+        size_t sibling_m = 0;  // position of index among its siblings
+        level_t level_m = 0;
+        bool first_m = true;
+};
+
+// each node goes one level deeper or back to a uniform random level up to the current one
+// the same distribution as the random trees of the benchmarks
+struct random_shape
+{
+        using level_t = size_t;
+
+        random_shape(size_t max_level, uint64_t seed) noexcept
+                : random_m(seed), max_level_m(max_level < 1 ? 1 : max_level) {}
+
+        level_t next() noexcept {
+                if (first_m) {
+                        first_m = false;
+                        return 0;
+                }
+                // the choice is not predictable, masks keep the compiler from branching
+                auto next = 1 + random_m.below(level_m + 1);
+                auto deeper = level_m + (level_m < max_level_m);
+                level_m = detail::select(next > level_m, deeper, next);
+                return level_m;
+        }
+
+private:
+        shape_random random_m;
+        size_t max_level_m;
+        level_t level_m = 0;
+        bool first_m = true;
+};
+
+/*!
+ * Markov walk over the levels
+ *
+ * After each node the walk goes down with probability descend, climbs with
+ * probability ascend and stays on the level otherwise. A climb continues with
+ * probability climb_on per level, so long climbs are geometrically rare.
+ * Use dom_shape() and filesystem_shape() for typical parameters.
+ *
+ * One random number per node drives the choice and the climb length,
+ * which is looked up in a table of 256 quantiles of the geometric distribution.
+ */
+struct branching_shape
+{
+        using level_t = size_t;
+
+        branching_shape(double descend, double ascend, double climb_on, size_t max_level, uint64_t seed) noexcept
+                : random_m(seed), descend_m(shape_probability(descend)),
+                  ascend_m(shape_probability(descend + ascend)), max_level_m(max_level < 1 ? 1 : max_level) {
+                for (unsigned u = 0; u < 256; ++u) {
+                        auto q = climb_on <= 0 ? 0 : std::log(1 - (u + 0.5) / 256) / std::log(climb_on);
+                        climbs_m[u] = uint8_t(1 + (climb_on <= 0 ? 0 : q < 254 ? q : 254));
+                }
+        }
+
+        level_t next() noexcept {
+                if (first_m) {
+                        first_m = false;
+                        return 0;
+                }
+                auto r = random_m();
+                auto choice = uint32_t(r);
+                size_t climb = climbs_m[r >> 56];
+                auto deeper = level_m + (level_m < max_level_m);
+                auto higher = level_m > climb ? level_m - climb : 1;
+                level_m = detail::select(choice < descend_m, deeper, detail::select(choice < ascend_m, higher, level_m));
+                // only the root is on level 0
+                level_m += (0 == level_m);
+                return level_m;
+        }
+
+private:
+        shape_random random_m;
+        uint32_t descend_m;
+        uint32_t ascend_m;
+        size_t max_level_m;
+        level_t level_m = 0;
+        bool first_m = true;
+        uint8_t climbs_m[256];
+};
+
+// markup documents: moderate depth, few children per element, runs of closing tags
+inline branching_shape dom_shape(uint64_t seed) noexcept {
+        return branching_shape(0.40, 0.30, 0.35, 48, seed);
+}
+
+// directory trees: shallow, many files per directory
+inline branching_shape filesystem_shape(uint64_t seed) noexcept {
+        return branching_shape(0.04, 0.03, 0.50, 24, seed);
+}
+
+// calls emit(position, level) for count nodes of the shape
+template<typename shape_t, typename Fn>
+void generate(shape_t& shape, size_t count, Fn emit) {
+        for (size_t i = 0; i < count; ++i) emit(i, shape.next());
+}
+
+// writes count levels to out, returns the iterator behind the last one
+template<typename shape_t, typename OutputIt>
+OutputIt generate_levels(shape_t& shape, size_t count, OutputIt out) {
+        for (size_t i = 0; i < count; ++i, ++out) *out = shape.next();
+        return out;
+}
+
+/*!
+ * Replaces the nodes of the tree with count nodes of the shape
+ *
+ * The storage is resized once and each node is written in place,
+ * make(position, level) returns the data of a node.
+ * Throws std::overflow_error if the drift type is too small for the depth,
+ * the tree is empty afterwards.
+ * O(n)  n = count
+ */
+template<typename tree_t, typename shape_t, typename Make>
+void generate_tree(tree_t& tree, shape_t& shape, size_t count, Make make) {
+        using level_t = typename tree_t::level_t;
+        using drift_t = typename tree_t::drift_t;
+        constexpr auto max_drift = tree_t::traits_t::max_drift();
+        tree.clear();
+        if (0 == count) return;
+        tree.resize(count);
+        auto nodes = &tree[0];
+        level_t back_level = shape.next();
+        assert(0 == back_level);
+        nodes[0].data = make(size_t(0), back_level);
+        for (size_t i = 1; i < count; ++i) {
+                level_t level = shape.next();
+                assert(0 < level && level <= back_level + 1);
+                set_drift(nodes[i - 1], drift_t(1 + back_level - level));
+                nodes[i].data = make(i, level);
+                // all drifts are bounded by 1 + the deepest level
+                if (level >= max_drift) {
+                        tree.clear();
+                        checked_drift<drift_t>(level + 1, max_drift);
+                }
+                back_level = level;
+        }
+        set_drift(nodes[count - 1], drift_t(back_level + 1));
+}
+
+} // namespace vt
@@ -0,0 +1,213 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "vector_tree/drift_tree.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace vt {
+
+/*!
+ * A drift tree that starts with 8 bit drifts and widens them when the tree gets deeper
+ *
+ * Every modification that overflows the active drift type is retried
+ * after all nodes were migrated to the next wider drift type.
+ * Use drift_for_level_t instead if the maximum depth is known at compile time.
+ */
+template<typename _data_t>
+struct widening_drift_tree
+{
+        using data_t = _data_t;
+        using level_t = size_t;
+        using size_type = size_t;
+
+        template<typename drift_t>
+        using tree_for_t = drift_tree<data_t, drift_t>;
+
+        // calls fn with the active drift_tree
+        // HINT: the result type of fn must not depend on the drift type
+        template<typename Fn>
+        decltype(auto) visit(Fn&& fn) {
+                switch (width_m) {
+                case 0: return fn(std::get<0>(trees_m));
+                case 1: return fn(std::get<1>(trees_m));
+                case 2: return fn(std::get<2>(trees_m));
+                default: return fn(std::get<3>(trees_m));
+                }
+        }
+        template<typename Fn>
+        decltype(auto) visit(Fn&& fn) const {
+                switch (width_m) {
+                case 0: return fn(std::get<0>(trees_m));
+                case 1: return fn(std::get<1>(trees_m));
+                case 2: return fn(std::get<2>(trees_m));
+                default: return fn(std::get<3>(trees_m));
+                }
+        }
+
+        // bytes used by the active drift type
+        size_t drift_size() const noexcept { return size_t(1) << width_m; }
+
+        bool empty() const noexcept { return visit([](const auto& t) { return t.empty(); }); }
+        size_type size() const noexcept { return visit([](const auto& t) { return t.size(); }); }
+
+        void reserve(size_type new_cap) { visit([=](auto& t) { t.reserve(new_cap); }); }
+        void shrink_to_fit() { visit([](auto& t) { t.shrink_to_fit(); }); }
+        void clear() noexcept { visit([](auto& t) { t.clear(); }); }
+
+        void push_root(data_t value) {
+                modify([&](auto& t) { t.push_root(std::move(value)); });
+        }
+
+        // a back_drift that does not fit the active drift type widens the tree first
+        void push_back_drifted(data_t data, level_t back_drift) {
+                modify([&](auto& t) {
+                        using tree_t = std::decay_t<decltype(t)>;
+                        t.push_back_drifted(std::move(data),
+                                            checked_drift<typename tree_t::drift_t>(back_drift, tree_t::traits_t::max_drift()));
+                });
+        }
+
+        void push_back_child(data_t data) {
+                modify([&](auto& t) { t.push_back_child(std::move(data)); });
+        }
+
+        void push_back_sibling(data_t data) {
+                modify([&](auto& t) { t.push_back_sibling(std::move(data)); });
+        }
+
+        void push_back_level(data_t data, level_t level) {
+                modify([&](auto& t) { t.push_back_level(std::move(data), level); });
+        }
+
+        void pop_back() {
+                modify([](auto& t) { t.pop_back(); });
+        }
+
+        // add a node as the first child of the node at pos
+        void insert_first_child(size_type pos, data_t data) {
+                modify([&](auto& t) { t.insert_first_child(t.begin() + pos, std::move(data)); });
+        }
+
+        // add a copy of another drift_tree with the same data type as the first child of the node at pos
+        template<typename tree_t>
+        void insert_child_tree(size_type pos, const tree_t& child_tree) {
+                modify([&](auto& t) {
+                        auto nodes = replayed<std::decay_t<decltype(t)>>(child_tree.begin(), child_tree.end(),
+                                                                         [](const data_t& data) -> const data_t& { return data; });
+                        t.insert_child_tree(t.begin() + pos, nodes.begin(), nodes.end());
+                });
+        }
+
+        // removes a leaf node at pos
+        void erase_leaf(size_type pos) {
+                modify([&](auto& t) { t.erase_leaf(t.begin() + pos); });
+        }
+
+        // removes all descendants of the node at pos
+        void erase_subtree(size_type pos) {
+                modify([&](auto& t) { t.erase_subtree(subtree<std::decay_t<decltype(t)>>(t.begin() + pos)); });
+        }
+
+        // side columns move along when the drifts widen, see drift_tree::attach_column
+        template<typename T>
+        column_handle<T> attach_column(std::vector<T> storage = {}) {
+                return visit([&](auto& t) { return t.attach_column(std::move(storage)); });
+        }
+        template<typename T>
+        side_column<T>& column(column_handle<T> handle) noexcept {
+                return visit([=](auto& t) -> side_column<T>& { return t.column(handle); });
+        }
+        template<typename T>
+        const side_column<T>& column(column_handle<T> handle) const noexcept {
+                return visit([=](const auto& t) -> const side_column<T>& { return t.column(handle); });
+        }
+        template<typename T>
+        std::vector<T> detach_column(column_handle<T> handle) noexcept {
+                return visit([=](auto& t) { return t.detach_column(handle); });
+        }
+
+        // moves all nodes to the next wider drift type
+        // returns false if the widest drift type is already used
+        // strong guarantee: data with a throwing move is copied and the tree stays unchanged on errors
+        // O(n)  n = number of nodes
+        bool widen() {
+                switch (width_m) {
+                case 0: migrate<0>(); return true;
+                case 1: migrate<1>(); return true;
+                case 2: migrate<2>(); return true;
+                default: return false;
+                }
+        }
+
+private:
+        // the nodes in [first, last) with the drifts of wide_t
+        // throws std::overflow_error if a drift does not fit, nothing is changed then
+        template<typename wide_t, typename It, typename Data>
+        static wide_t replayed(It first, It last, Data data) {
+                wide_t wide;
+                wide.reserve(size_type(last - first));
+                // replaying the drifts keeps the levels, the last drift follows automatically
+                for (auto it = first; it != last; ++it) {
+                        if (it == first)
+                                wide.push_root(data(it->data));
+                        else
+                                wide.push_back_drifted(data(it->data),
+                                                       checked_drift<typename wide_t::drift_t>(drift_of(*(it - 1)),
+                                                                                               wide_t::traits_t::max_drift()));
+                }
+                return wide;
+        }
+
+        // the narrow tree stays intact until the wide one is complete
+        template<size_t width>
+        void migrate() {
+                auto& narrow = std::get<width>(trees_m);
+                using wide_t = std::decay_t<decltype(std::get<width + 1>(trees_m))>;
+                auto wide = replayed<wide_t>(narrow.begin(), narrow.end(),
+                                             [](data_t& data) -> decltype(auto) { return std::move_if_noexcept(data); });
+                wide.columns() = std::move(narrow.columns());
+                std::get<width + 1>(trees_m) = std::move(wide);
+                narrow = tree_for_t<typename std::decay_t<decltype(narrow)>::drift_t>();
+                width_m = width + 1;
+        }
+
+        // drift_tree checks for overflows before it modifies the nodes or moves the data
+        template<typename Fn>
+        void modify(Fn fn) {
+                while (true) {
+                        try {
+                                visit(fn);
+                                return;
+                        }
+                        catch (const std::overflow_error&) {
+                                if (!widen()) throw;
+                        }
+                }
+        }
+
+        std::tuple<tree_for_t<uint8_t>, tree_for_t<uint16_t>, tree_for_t<uint32_t>, tree_for_t<uint64_t>> trees_m;
+        unsigned width_m = 0;
+};
+
+} // namespace vt
@@ -16,12 +16,31 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "vector_tree/double_ended_vector.h"
+#include "vector_tree/drift_bvh.h"
+#include "vector_tree/drift_trie.h"
 #include "vector_tree/drift_tree.h"
+#include "vector_tree/edit_transaction.h"
+#include "vector_tree/eval_reverse.h"
+#include "vector_tree/instrumentation.h"
+#include "vector_tree/level_order.h"
+#include "vector_tree/memory_report.h"
+#include "vector_tree/node_layout.h"
+#include "vector_tree/post_order.h"
+#include "vector_tree/relocatable_vector.h"
+#include "vector_tree/static_drift_tree.h"
+#include "vector_tree/subtree_index.h"
+#include "vector_tree/tree_shapes.h"
+#include "vector_tree/widening_drift_tree.h"
 
 #include <QString>
 #include <QtTest>
 
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
 
 class BuilderTest : public QObject {
     Q_OBJECT
@@ -40,6 +59,26 @@ private Q_SLOTS:
     void pushBackConstruction();
     void pushRootConstruction();
     void subtree();
+    void insertChildTrees();
+    void staticTree();
+    void driftOverflow();
+    void wideningTree();
+    void subtreeRange();
+    void postOrder();
+    void reverseSubtree();
+    void levelOrder();
+    void emplaceConstruction();
+    void relocatingTree();
+    void doubleEndedTree();
+    void editTransaction();
+    void nodeLayout();
+    void sideColumns();
+    void treeShapes();
+    void instrumentation();
+    void memoryReport();
+    void driftTrie();
+    void driftBvh();
+    void evalReverse();
 };
 
 BuilderTest::BuilderTest() {}
@@ -104,6 +143,15 @@ BuilderTest::pushBackConstruction() {
     t.erase_leaf(t.begin() + 3);
     checkInvariant(t);
     QVERIFY(t.size() == 4);
+
+    // the same tree from pre-order levels
+    int_tree leveled;
+    size_t levels[] = {0, 1, 2, 2, 1, 2};
+    for (int i = 0; i < 6; ++i) leveled.push_at_level(i + 1, levels[i]);
+    checkInvariant(leveled);
+    std::vector<size_t> drifts;
+    for (const auto& node : leveled) drifts.push_back(node.drift);
+    QVERIFY((drifts == std::vector<size_t>{0, 0, 1, 2, 0, 3}));
 }
 
 void
@@ -172,6 +220,1822 @@ BuilderTest::subtree() {
     QVERIFY(t.size() == 1);
 }
 
+void
+BuilderTest::insertChildTrees() {
+    int_tree t;
+    /* 1
+     *  2 3
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_sibling(3);
+
+    int_tree a;
+    a.push_root(4);
+    a.push_back_child(5);
+    int_tree b;
+    b.push_root(6);
+
+    std::vector<std::pair<size_t, int_tree>> entries;
+    entries.emplace_back(1, a);
+    entries.emplace_back(1, b);
+    entries.emplace_back(2, b);
+    t.insert_child_trees(entries.begin(), entries.end());
+    checkInvariant(t);
+
+    /* 1
+     *  2      3
+     *   4  6   6
+     *    5
+     */
+    QCOMPARE(t.size(), size_t(7));
+    int expected[] = {1, 2, 4, 5, 6, 3, 6};
+    for (size_t i = 0; i < t.size(); ++i) QCOMPARE(t[i].data, expected[i]);
+    QCOMPARE(t[1].drift, size_t(0));
+    QCOMPARE(t[3].drift, size_t(2));
+    QCOMPARE(t[4].drift, size_t(2));
+    QCOMPARE(t[6].drift, size_t(3));
+
+    // invalid or unsorted positions leave the tree unchanged
+    entries.clear();
+    entries.emplace_back(7, b);
+    bool thrown = false;
+    try {
+        t.insert_child_trees(entries.begin(), entries.end());
+    }
+    catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    entries.clear();
+    entries.emplace_back(2, b);
+    entries.emplace_back(1, b);
+    thrown = false;
+    try {
+        t.insert_child_trees(entries.begin(), entries.end());
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(t.size(), size_t(7));
+    for (size_t i = 0; i < t.size(); ++i) QCOMPARE(t[i].data, expected[i]);
+}
+
+namespace {
+
+using static_tree = vt::static_drift_tree<int, 8>;
+
+constexpr static_tree
+staticExample() {
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    static_tree t;
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+    return t;
+}
+
+constexpr int
+staticSubtreeSum(const static_tree& t, size_t pos) {
+    auto st = vt::subtree<const static_tree>(t.begin() + pos);
+    auto sum = 0;
+    for (auto it = st.begin(); it != st.end(); ++it) sum += (*it).data;
+    return sum;
+}
+
+constexpr static_tree
+staticRooted() {
+    auto t = staticExample();
+    t.push_root(0);
+    t.pop_back();
+    return t;
+}
+
+constexpr auto static_example = staticExample();
+
+} // namespace
+
+void
+BuilderTest::staticTree() {
+    static_assert(static_example.size() == 6, "built at compile time");
+    static_assert(static_example.is_valid(), "valid drifts");
+    static_assert(static_example[5].drift == 3, "last drift");
+    static_assert(staticSubtreeSum(static_example, 0) == 20, "subtree at compile time");
+    static_assert(staticSubtreeSum(static_example, 1) == 7, "subtree at compile time");
+
+    constexpr auto rooted = staticRooted();
+    static_assert(rooted.is_valid(), "valid drifts");
+    static_assert(rooted[0].data == 0 && rooted[1].data == 1, "new root");
+
+    // the runtime view matches the dynamic tree
+    int_tree t;
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+    QCOMPARE(t.size(), static_example.size());
+    for (size_t i = 0; i < t.size(); ++i) {
+        QCOMPARE(t[i].data, static_example[i].data);
+        QCOMPARE(t[i].drift, static_example[i].drift);
+    }
+
+    auto full = staticExample();
+    full.push_back_sibling(7);
+    full.push_back_sibling(8);
+    bool thrown = false;
+    try {
+        full.push_back_sibling(9);
+    } catch (const std::length_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+void
+BuilderTest::driftOverflow() {
+    static_assert(std::is_same<vt::drift_for_level_t<254>, uint8_t>::value, "8 bit drift");
+    static_assert(std::is_same<vt::drift_for_level_t<255>, uint16_t>::value, "16 bit drift");
+    static_assert(std::is_same<vt::drift_for_level_t<70000>, uint32_t>::value, "32 bit drift");
+
+    // a chain with levels 0..254 fits into 8 bit drifts
+    vt::drift_tree<int, uint8_t> t;
+    t.push_root(0);
+    for (int i = 1; i < 255; ++i) t.push_back_child(i);
+    QCOMPARE(int(t.back().drift), 255);
+
+    bool thrown = false;
+    try {
+        t.push_back_child(255);
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(t.size(), size_t(255));
+    QCOMPARE(int(t.back().drift), 255);
+
+    thrown = false;
+    try {
+        t.push_root(-1);
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(t.front().data, 0);
+
+    thrown = false;
+    try {
+        t.insert_first_child(t.end() - 1, 255);
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(t.size(), size_t(255));
+
+    // shallow nodes stay usable
+    t.push_back_level(1000, 3);
+    QCOMPARE(int(t.back().drift), 4);
+    t.pop_back();
+    QCOMPARE(int(t.back().drift), 255);
+}
+
+namespace {
+
+// copied on every move, throws once copies_left is used up
+struct copy_only {
+    static int copies_left;
+
+    explicit copy_only(int v = 0) : value(v) {}
+    copy_only(const copy_only& other) : value(other.value) {
+        if (copies_left-- <= 0) throw std::runtime_error("copy_only");
+    }
+    copy_only& operator=(const copy_only&) = default;
+
+    int value;
+};
+
+int copy_only::copies_left = 0;
+
+} // namespace
+
+void
+BuilderTest::wideningTree() {
+    vt::widening_drift_tree<int> t;
+    QCOMPARE(t.drift_size(), size_t(1));
+    t.push_root(0);
+    for (int i = 1; i < 1000; ++i) t.push_back_child(i);
+    QCOMPARE(t.drift_size(), size_t(2));
+    QCOMPARE(t.size(), size_t(1000));
+    t.push_back_level(1000, 1);
+    t.pop_back();
+
+    t.visit([](const auto& tree) {
+        auto sum = std::accumulate(tree.begin(), tree.end(), size_t(),
+                                   [](auto s, const auto& n) { return s + n.drift; });
+        QCOMPARE(sum, tree.size());
+        for (size_t i = 0; i < tree.size(); ++i) QCOMPARE(tree[i].data, int(i));
+        QCOMPARE(size_t(tree.back().drift), size_t(1000));
+    });
+
+    for (int i = 1000; i < 70000; ++i) t.push_back_child(i);
+    QCOMPARE(t.drift_size(), size_t(4));
+    QCOMPARE(t.visit([](const auto& tree) { return size_t(tree.back().drift); }), size_t(70000));
+
+    // the largest back drift of an 8 bit tree closes a chain of 254 levels
+    vt::widening_drift_tree<int> d;
+    d.push_root(0);
+    for (int i = 1; i < 255; ++i) d.push_back_child(i);
+    d.push_back_drifted(255, 255);
+    QCOMPARE(d.drift_size(), size_t(1));
+    QCOMPARE(d.visit([](const auto& tree) { return size_t(tree[254].drift); }), size_t(255));
+    QCOMPARE(d.visit([](const auto& tree) { return size_t(tree.back().drift); }), size_t(1));
+
+    // inserting and erasing subtrees widens as well
+    vt::widening_drift_tree<int> w;
+    w.push_root(0);
+    for (int i = 1; i < 200; ++i) w.push_back_child(i);
+    vt::drift_tree<int, uint16_t> chain;
+    chain.push_root(200);
+    for (int i = 201; i < 300; ++i) chain.push_back_child(i);
+    w.insert_child_tree(199, chain);
+    QCOMPARE(w.drift_size(), size_t(2));
+    QCOMPARE(w.size(), size_t(300));
+    QCOMPARE(w.visit([](const auto& tree) { return size_t(tree.back().drift); }), size_t(300));
+    w.erase_subtree(100);
+    QCOMPARE(w.size(), size_t(101));
+    QCOMPARE(w.visit([](const auto& tree) { return size_t(tree.back().drift); }), size_t(101));
+
+    // a throwing copy during the migration leaves the narrow tree intact
+    vt::widening_drift_tree<copy_only> c;
+    copy_only::copies_left = 1000;
+    c.push_root(copy_only(0));
+    for (int i = 1; i < 255; ++i) c.push_back_child(copy_only(i));
+    copy_only::copies_left = 10;
+    bool thrown = false;
+    try {
+        c.push_back_child(copy_only(255));
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(c.drift_size(), size_t(1));
+    QCOMPARE(c.size(), size_t(255));
+    c.visit([](const auto& tree) {
+        for (size_t i = 0; i < tree.size(); ++i) QCOMPARE(tree[i].data.value, int(i));
+    });
+    copy_only::copies_left = 1000;
+    c.push_back_child(copy_only(255));
+    QCOMPARE(c.drift_size(), size_t(2));
+    QCOMPARE(c.size(), size_t(256));
+}
+
+void
+BuilderTest::subtreeRange() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+
+    QVERIFY(vt::find_subtree_end(t.begin()) == t.end());
+    QVERIFY(vt::find_subtree_end(t.begin() + 1) == t.begin() + 4);
+    QVERIFY(vt::find_subtree_end(t.begin() + 2) == t.begin() + 3);
+
+    // writes through the leveled iterator reach the tree
+    auto st1 = vt::subtree<int_tree>(t.begin() + 1);
+    for (auto& node : st1) node.data *= 10;
+    QCOMPARE(t[2].data, 30);
+    QCOMPARE(t[3].data, 40);
+    (*st1.begin()).data = 3;
+    st1.begin()->data = 3;
+    QCOMPARE(t[2].data, 3);
+
+    auto r0 = vt::subtree<int_tree>(t.begin()).range();
+    QCOMPARE(r0.size(), size_t(5));
+    QVERIFY(r0.begin() == t.begin() + 1);
+    QVERIFY(r0.end() == t.end());
+    QCOMPARE(r0[0].data, 2);
+    QCOMPARE(r0.back().data, 6);
+    QCOMPARE(r0.level_of(r0.begin() + 2), size_t(2));
+    QCOMPARE(r0.level_of(r0.begin() + 3), size_t(1));
+
+    // random access algorithms work on the contiguous range
+    auto r1 = st1.range();
+    QCOMPARE(r1.size(), size_t(2));
+    std::sort(r1.begin(), r1.end(), [](const auto& l, const auto& r) { return l.data > r.data; });
+    QCOMPARE(t[2].data, 40);
+    QCOMPARE(t[3].data, 3);
+    std::swap(t[2].drift, t[3].drift);
+    checkInvariant(t);
+
+    auto max = std::max_element(r0.begin(), r0.end(), [](const auto& l, const auto& r) { return l.data < r.data; });
+    QCOMPARE(max->data, 40);
+
+    auto leaf = vt::subtree<int_tree>(t.begin() + 2).range();
+    QVERIFY(leaf.empty());
+
+    const int_tree& ct = t;
+    auto cr = vt::subtree<const int_tree>(ct.begin()).range();
+    QCOMPARE(std::distance(cr.leveled().begin(), cr.leveled().end()), 5);
+}
+
+void
+BuilderTest::postOrder() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+
+    std::vector<int> data;
+    std::vector<size_t> levels;
+    auto po = vt::post_order(t);
+    for (auto it = po.begin(); it != po.end(); ++it) {
+        data.push_back(it->data);
+        levels.push_back(it.level());
+    }
+    QVERIFY((data == std::vector<int>{3, 4, 2, 6, 5, 1}));
+    QVERIFY((levels == std::vector<size_t>{2, 2, 1, 2, 1, 0}));
+
+    data.clear();
+    for (const auto& node : vt::post_order(vt::subtree<int_tree>(t.begin() + 1))) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{3, 4, 2}));
+
+    data.clear();
+    levels.clear();
+    auto rpo = vt::reverse_pre_order(t);
+    for (auto it = rpo.begin(); it != rpo.end(); ++it) {
+        data.push_back(it->data);
+        levels.push_back(it.level());
+    }
+    QVERIFY((data == std::vector<int>{6, 5, 4, 3, 2, 1}));
+    QVERIFY((levels == std::vector<size_t>{2, 1, 2, 2, 1, 0}));
+
+    data.clear();
+    levels.clear();
+    auto rst = vt::reverse_pre_order(vt::subtree<int_tree>(t.begin() + 1));
+    for (auto it = rst.begin(); it != rst.end(); ++it) {
+        data.push_back(it->data);
+        levels.push_back(it.level());
+    }
+    QVERIFY((data == std::vector<int>{4, 3, 2}));
+    QVERIFY((levels == std::vector<size_t>{1, 1, 0}));
+
+    // subtree sizes bottom up without recursion
+    std::vector<size_t> sizes(t.size(), 1);
+    for (auto it = po.begin(); it != po.end(); ++it) {
+        auto pos = size_t(it.unwrap() - t.begin());
+        for (auto c = vt::subtree<int_tree>(it.unwrap()).begin(); !c.is_end(); ++c) {
+            if (c.level() == 1) sizes[pos] += sizes[c.unwrap() - t.begin()];
+        }
+    }
+    QVERIFY((sizes == std::vector<size_t>{6, 3, 1, 1, 2, 1}));
+
+    auto leaf = vt::post_order(vt::subtree<int_tree>(t.begin() + 5));
+    QCOMPARE(std::distance(leaf.begin(), leaf.end()), 1);
+}
+
+void
+BuilderTest::reverseSubtree() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+
+    std::vector<int> data;
+    std::vector<size_t> levels;
+    auto r0 = vt::subtree<int_tree>(t.begin()).range();
+    for (auto it = r0.reversed().begin(); !it.is_end(); ++it) {
+        data.push_back(it->data);
+        levels.push_back(it.level());
+    }
+    QVERIFY((data == std::vector<int>{6, 5, 4, 3, 2}));
+    QVERIFY((levels == std::vector<size_t>{2, 1, 2, 2, 1}));
+
+    // the last descendant of a nested subtree ends more than one level
+    data.clear();
+    levels.clear();
+    auto r1 = vt::subtree<int_tree>(t.begin() + 1).range();
+    for (auto it = r1.reversed().begin(); it != r1.reversed().end(); ++it) {
+        data.push_back(it->data);
+        levels.push_back(it.level());
+    }
+    QVERIFY((data == std::vector<int>{4, 3}));
+    QVERIFY((levels == std::vector<size_t>{1, 1}));
+
+    // forward and backward steps agree on the levels
+    auto it = r0.leveled().begin();
+    ++it;
+    ++it;
+    QCOMPARE(it->data, 4);
+    QCOMPARE(it.level(), size_t(2));
+    --it;
+    QCOMPARE(it->data, 3);
+    QCOMPARE(it.level(), size_t(2));
+    --it;
+    QCOMPARE(it.level(), size_t(1));
+    auto end = r0.leveled_end();
+    QVERIFY(end == r0.leveled().end());
+    --end;
+    QCOMPARE(end->data, 6);
+    QCOMPARE(end.level(), size_t(2));
+    auto reverse = r1.reversed().begin();
+    QVERIFY(reverse.base() == r1.leveled_end());
+
+    data.clear();
+    for (const auto& node : vt::subtree<int_tree>(t.begin()).children()) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{2, 5}));
+
+    data.clear();
+    for (const auto& node : r0.reverse_children()) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{5, 2}));
+
+    data.clear();
+    for (const auto& node : r1.reverse_children()) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{4, 3}));
+
+    auto leaf = vt::subtree<int_tree>(t.begin() + 5).range();
+    QVERIFY(leaf.reversed().begin() == leaf.reversed().end());
+    QVERIFY(leaf.reverse_children().begin() == leaf.reverse_children().end());
+
+    const int_tree& ct = t;
+    auto cr = vt::subtree<const int_tree>(ct.begin()).range();
+    QCOMPARE(std::distance(cr.reversed().begin(), cr.reversed().end()), 5);
+}
+
+void
+BuilderTest::levelOrder() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+
+    std::vector<int> data;
+    std::vector<size_t> levels;
+    auto lo = vt::level_order(t);
+    QCOMPARE(lo.size(), size_t(3));
+    for (auto level : lo) {
+        for (auto& node : level) {
+            data.push_back(node.data);
+            levels.push_back(level.level());
+        }
+    }
+    QVERIFY((data == std::vector<int>{1, 2, 5, 3, 4, 6}));
+    QVERIFY((levels == std::vector<size_t>{0, 1, 1, 2, 2, 2}));
+    QVERIFY(lo[1].span_begin() == t.begin() + 1);
+    QVERIFY(lo[1].span_end() == t.begin() + 5);
+
+    data.clear();
+    for (auto& node : vt::level_nodes(t, 2)) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{3, 4, 6}));
+    QVERIFY(vt::level_nodes(t, 3).empty());
+
+    auto st = vt::subtree<int_tree>(t.begin() + 1);
+    data.clear();
+    for (auto level : vt::level_order(st))
+        for (auto& node : level) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{2, 3, 4}));
+
+    data.clear();
+    for (auto& node : vt::level_nodes(st, 1)) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{3, 4}));
+
+    // nodes of a level may be spread over the whole tree
+    int_tree deep;
+    deep.push_root(0);
+    deep.push_back_child(1);
+    for (int i = 2; i < 100; ++i) deep.push_back_child(i);
+    deep.push_back_level(100, 1);
+    data.clear();
+    for (auto& node : vt::level_nodes(deep, 1)) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{1, 100}));
+    size_t count = 0;
+    QCOMPARE(vt::level_order(deep).size(), size_t(100));
+
+    // deep chains below early nodes, every level jumps over them
+    int_tree comb;
+    comb.push_root(0);
+    for (int k = 0; k < 50; ++k) {
+        if (0 == k) comb.push_back_child(0);
+        else comb.push_back_level(1000 * k, 1);
+        for (int i = 1; i < 50; ++i) comb.push_back_child(1000 * k + i);
+    }
+    vt::subtree_index<int_tree> comb_index(comb);
+    for (auto comb_order : {vt::level_order(comb), vt::level_order(comb, comb_index)}) {
+        QCOMPARE(comb_order.size(), size_t(51));
+        count = 0;
+        for (auto level : comb_order) {
+            std::vector<int> expected;
+            for (auto& node : vt::level_nodes(comb, level.level())) expected.push_back(node.data);
+            data.clear();
+            for (auto& node : level) data.push_back(node.data);
+            QVERIFY(data == expected);
+            QCOMPARE(data.size(), level.level() ? size_t(50) : size_t(1));
+            count += data.size();
+        }
+        QCOMPARE(count, comb.size());
+    }
+
+    // the index jumps give the same levels as the scans
+    int_tree mixed;
+    mixed.push_root(0);
+    size_t mixed_level = 0;
+    for (int i = 1; i < 3000; ++i) {
+        auto r = size_t(i) * 2654435761u % 7;
+        if (r < 3 || 0 == mixed_level) mixed.push_back_child(i), ++mixed_level;
+        else if (r < 5) mixed.push_back_sibling(i);
+        else mixed.push_back_level(i, mixed_level = (mixed_level + 1) / 2);
+    }
+    for (const auto* tree : {&t, &deep, &mixed}) {
+        vt::subtree_index<int_tree> index(*tree);
+        auto scanned = vt::level_order(*tree);
+        auto jumped = vt::level_order(*tree, index);
+        QCOMPARE(jumped.size(), scanned.size());
+        for (size_t l = 0; l < scanned.size(); ++l) {
+            std::vector<const int_tree::node_t*> expected, nodes;
+            for (auto& node : scanned[l]) expected.push_back(&node);
+            for (auto& node : jumped[l]) nodes.push_back(&node);
+            QVERIFY(nodes == expected);
+        }
+    }
+
+    const int_tree& ct = t;
+    count = 0;
+    for (auto level : vt::level_order(ct)) count += std::distance(level.begin(), level.end());
+    QCOMPARE(count, t.size());
+}
+
+namespace {
+
+// deterministic pseudo random numbers
+struct xorshift_random {
+    uint64_t state;
+    uint64_t below(uint64_t bound) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state % bound;
+    }
+};
+
+// counts copies of the payload
+struct copy_counter {
+    copy_counter(int value) : value(value) {}
+    copy_counter(const copy_counter& other) : value(other.value) { copies += 1; }
+    copy_counter(copy_counter&& other) noexcept : value(other.value) {}
+    copy_counter& operator=(const copy_counter&) = default;
+    copy_counter& operator=(copy_counter&&) = default;
+
+    int value;
+    static int copies;
+};
+int copy_counter::copies = 0;
+
+} // namespace
+
+void
+BuilderTest::emplaceConstruction() {
+    using string_node = vt::drift_node<std::string>;
+    static_assert(!std::is_nothrow_constructible<string_node, size_t, const std::string&>::value,
+                  "copying a string may throw");
+    static_assert(std::is_nothrow_constructible<string_node, size_t, std::string&&>::value,
+                  "moving a string does not throw");
+    static_assert(std::is_nothrow_constructible<vt::drift_node<int>, size_t, int>::value, "ints do not throw");
+
+    // move only payloads
+    vt::drift_tree<std::unique_ptr<int>> ptrs;
+    ptrs.push_root(std::make_unique<int>(1));
+    ptrs.emplace_back_child(new int(2));
+    ptrs.push_back_child(std::make_unique<int>(3));
+    ptrs.emplace_back_level(1, new int(4));
+    ptrs.emplace_root(new int(0));
+    ptrs.emplace_first_child(ptrs.begin() + 1, new int(5));
+    ptrs.emplace_sibling(ptrs.begin() + 2, new int(6));
+    std::vector<int> values;
+    for (auto& node : ptrs) values.push_back(*node.data);
+    QVERIFY((values == std::vector<int>{0, 1, 6, 5, 2, 3, 4}));
+    std::vector<size_t> drifts;
+    for (auto& node : ptrs) drifts.push_back(node.drift);
+    QVERIFY((drifts == std::vector<size_t>{0, 0, 1, 1, 0, 2, 3}));
+
+    // payloads are constructed in place
+    vt::drift_tree<std::string> strings;
+    strings.emplace_root(3, 'a');
+    strings.emplace_back_child("bb");
+    strings.emplace_back_sibling(2, 'c');
+    QCOMPARE(strings[0].data, std::string("aaa"));
+    QCOMPARE(strings[2].data, std::string("cc"));
+    QCOMPARE(strings.back().drift, size_t(2));
+
+    // a single copy for lvalues, none for rvalues
+    vt::drift_tree<copy_counter> counted;
+    counted.reserve(8);
+    copy_counter value(1);
+    copy_counter::copies = 0;
+    counted.push_root(value);
+    counted.push_back_child(value);
+    counted.push_back_level(value, 1);
+    QCOMPARE(copy_counter::copies, 3);
+    counted.push_back_child(copy_counter(2));
+    counted.emplace_back_sibling(3);
+    counted.insert_first_child(counted.begin() + 1, std::move(value));
+    QCOMPARE(copy_counter::copies, 3);
+    QCOMPARE(counted.back().data.value, 3);
+    checkInvariant(counted);
+
+    // a throwing payload constructor leaves the tree unchanged
+    auto before = std::vector<size_t>();
+    for (auto& node : strings) before.push_back(node.drift);
+    bool thrown = false;
+    try {
+        strings.emplace_first_child(strings.begin(), std::string(), 1, 1);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    auto after = std::vector<size_t>();
+    for (auto& node : strings) after.push_back(node.drift);
+    QVERIFY(before == after);
+}
+
+namespace {
+
+// relocatable payload that throws on the nth copy
+struct throwing_handle {
+    throwing_handle(int value) : value(value) {}
+    throwing_handle(const throwing_handle& other) : value(other.value) {
+        if (--countdown == 0) throw std::runtime_error("copy failed");
+    }
+    throwing_handle& operator=(const throwing_handle&) = default;
+
+    int value;
+    static int countdown;
+};
+int throwing_handle::countdown = 0;
+
+// points into itself, must not be relocated by memmove
+struct self_pointer {
+    self_pointer() : self(this) {}
+    self_pointer(const self_pointer&) : self(this) {}
+    self_pointer& operator=(const self_pointer&) { return *this; }
+    self_pointer* self;
+};
+
+} // namespace
+
+namespace vt {
+template<>
+struct is_trivially_relocatable<throwing_handle> : std::true_type {};
+} // namespace vt
+
+void
+BuilderTest::relocatingTree() {
+    using ptr_tree = vt::relocating_drift_tree<std::unique_ptr<int>>;
+    static_assert(std::is_same<ptr_tree::vector_t, vt::relocatable_vector<ptr_tree::node_t>>::value,
+                  "unique_ptr nodes are relocated");
+    static_assert(std::is_same<vt::relocating_drift_tree<self_pointer>::vector_t,
+                               std::vector<vt::drift_node<self_pointer>>>::value,
+                  "other nodes fall back to std::vector");
+
+    ptr_tree t;
+    t.emplace_root(new int(1));
+    for (int i = 2; i < 100; ++i) {
+        if (i % 3) t.emplace_back_child(new int(i));
+        else t.emplace_back_sibling(new int(i));
+    }
+    t.emplace_root(new int(0));
+    for (int i = 100; i < 120; ++i) t.emplace_first_child(t.begin() + i % 7, new int(i));
+    while (t.size() > 60) {
+        auto leaf = std::find_if(t.begin() + 1, t.end(), [](const auto& n) { return n.is_leaf(); });
+        t.erase_leaf(leaf);
+    }
+    t.erase_subtree(vt::subtree<ptr_tree>(t.begin() + 3));
+    t.shrink_to_fit();
+
+    // the same edits on a std::vector based tree
+    vt::drift_tree<int> expected;
+    expected.push_root(1);
+    for (int i = 2; i < 100; ++i) {
+        if (i % 3) expected.push_back_child(i);
+        else expected.push_back_sibling(i);
+    }
+    expected.push_root(0);
+    for (int i = 100; i < 120; ++i) expected.insert_first_child(expected.begin() + i % 7, i);
+    while (expected.size() > 60) {
+        auto leaf = std::find_if(expected.begin() + 1, expected.end(), [](const auto& n) { return n.is_leaf(); });
+        expected.erase_leaf(leaf);
+    }
+    expected.erase_subtree(vt::subtree<vt::drift_tree<int>>(expected.begin() + 3));
+
+    QCOMPARE(t.size(), expected.size());
+    QCOMPARE(t.capacity(), t.size());
+    for (size_t i = 0; i < t.size(); ++i) {
+        QCOMPARE(*t[i].data, expected[i].data);
+        QCOMPARE(t[i].drift, expected[i].drift);
+    }
+
+    // failed copies leave the tree unchanged
+    vt::relocating_drift_tree<throwing_handle> h;
+    h.push_root(1);
+    h.push_back_child(2);
+    h.push_back_child(3);
+    h.reserve(8);
+    std::vector<vt::drift_node<throwing_handle>> nodes{{0, 4}, {1, 5}, {1, 6}};
+    throwing_handle::countdown = 3;
+    bool thrown = false;
+    try {
+        h.insert_child_tree(h.begin(), nodes.begin(), nodes.end());
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(h.size(), size_t(3));
+    QCOMPARE(h[1].data.value, 2);
+    QCOMPARE(h[2].data.value, 3);
+    throwing_handle::countdown = 0;
+    h.insert_child_tree(h.begin() + 1, nodes.begin(), nodes.end());
+    QVERIFY((std::vector<int>{h[0].data.value, h[1].data.value, h[2].data.value, h[3].data.value,
+                              h[4].data.value, h[5].data.value} == std::vector<int>{1, 2, 4, 5, 6, 3}));
+
+    auto copy = h;
+    QCOMPARE(copy.size(), h.size());
+    QCOMPARE(copy.back().drift, size_t(3));
+}
+
+void
+BuilderTest::doubleEndedTree() {
+    // bottom up: the parent is known after its children
+    using de_tree = vt::double_ended_drift_tree<int>;
+    de_tree t;
+    int_tree expected;
+    t.push_root(0);
+    expected.push_root(0);
+    for (int i = 1; i < 1000; ++i) {
+        t.push_root(i);
+        expected.push_root(i);
+        if (i % 5 == 0) {
+            t.insert_first_child(t.begin() + 1, -i);
+            expected.insert_first_child(expected.begin() + 1, -i);
+        }
+    }
+    QCOMPARE(t.size(), expected.size());
+    QVERIFY(std::equal(t.begin(), t.end(), expected.begin(), [](const auto& l, const auto& r) {
+        return l.data == r.data && l.drift == r.drift;
+    }));
+
+    // reserved headroom keeps the nodes in place
+    de_tree r;
+    r.push_root(0);
+    r.reserve_front(100);
+    auto last = &r.back();
+    for (int i = 1; i < 100; ++i) r.push_root(i);
+    QVERIFY(last == &r.back());
+    QCOMPARE(r.back().drift, size_t(100));
+    r.reserve(200);
+    QVERIFY(r.capacity() >= 200);
+    QCOMPARE(r.front().data, 99);
+
+    // the same edits as std::vector with a nothrow movable payload
+    vt::double_ended_vector<std::string> v;
+    std::vector<std::string> e;
+    xorshift_random random{42};
+    for (int i = 0; i < 2000; ++i) {
+        auto op = random.below(6);
+        auto pos = e.empty() ? 0 : random.below(e.size() + 1);
+        auto value = std::string(20, char('a' + i % 26)) + std::to_string(i);
+        if (op < 3 || e.empty()) {
+            v.emplace(v.begin() + pos, value);
+            e.emplace(e.begin() + pos, value);
+        }
+        else if (op == 3) {
+            std::vector<std::string> values(random.below(4), value);
+            v.insert(v.begin() + pos, values.begin(), values.end());
+            e.insert(e.begin() + pos, values.begin(), values.end());
+        }
+        else {
+            pos = std::min<size_t>(pos, e.size() - 1);
+            auto count = std::min<size_t>(random.below(3), e.size() - pos);
+            v.erase(v.begin() + pos, v.begin() + pos + count);
+            e.erase(e.begin() + pos, e.begin() + pos + count);
+        }
+        if (i % 500 == 0) v.shrink_to_fit();
+    }
+    QCOMPARE(v.size(), e.size());
+    QVERIFY(std::equal(v.begin(), v.end(), e.begin()));
+    auto copy = v;
+    v.clear();
+    QVERIFY(std::equal(copy.begin(), copy.end(), e.begin()));
+}
+
+void
+BuilderTest::editTransaction() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+    int_tree sub;
+    sub.push_root(7);
+    sub.push_back_child(8);
+
+    // the same edits applied eagerly with shifted positions
+    auto eager = t;
+    eager.insert_first_child(eager.begin() + 1, 20);
+    eager.insert_first_child(eager.begin() + 1, 21);
+    eager.insert_sibling(eager.begin() + 6, 40);
+    eager.erase_leaf(eager.begin() + 8);
+    eager.insert_child_tree(eager.begin(), sub.begin(), sub.end());
+
+    vt::edit_transaction<int_tree> tx(t);
+    tx.insert_first_child(1, 20);
+    tx.insert_first_child(1, 21);
+    tx.insert_sibling(4, 40);
+    tx.erase_leaf(5);
+    tx.insert_child_tree(0, sub.begin(), sub.end());
+    auto sp = tx.save();
+    tx.erase_children(1);
+    auto inner = tx.save();
+    tx.insert_first_child(3, 99);
+    tx.rollback(inner);
+    QCOMPARE(tx.size(), size_t(6));
+    tx.rollback(sp);
+    QCOMPARE(tx.size(), size_t(5));
+    QCOMPARE(t.size(), size_t(6));
+
+    std::vector<size_t> positions(t.size(), size_t(-1));
+    tx.commit([&](size_t original, size_t position) { positions[original] = position; });
+    QVERIFY(tx.empty());
+    QCOMPARE(t.size(), eager.size());
+    QVERIFY(std::equal(t.begin(), t.end(), eager.begin(), [](const auto& l, const auto& r) {
+        return l.data == r.data && l.drift == r.drift;
+    }));
+    QVERIFY((positions == std::vector<size_t>{0, 3, 6, 7, 9, size_t(-1)}));
+    checkInvariant(t);
+
+    // erase_children drops the children inserted before it
+    vt::edit_transaction<int_tree> erase(t);
+    erase.insert_first_child(3, 30);
+    erase.insert_first_child(7, 70);
+    erase.erase_children(3);
+    erase.insert_first_child(3, 31);
+    erase.insert_sibling(0, 0);
+    erase.commit();
+    std::vector<int> data;
+    for (const auto& node : t) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{0, 1, 7, 8, 2, 31, 40, 5}));
+    std::vector<size_t> drifts;
+    for (const auto& node : t) drifts.push_back(node.drift);
+    QVERIFY((drifts == std::vector<size_t>{1, 0, 0, 2, 0, 2, 1, 2}));
+
+    // edits recorded below a node before its erase_children() are dropped like the eager edits
+    int_tree dropped_eager = t;
+    dropped_eager.insert_first_child(dropped_eager.begin() + 4, 50);
+    dropped_eager.insert_sibling(dropped_eager.begin() + 6, 51);
+    dropped_eager.erase_subtree(vt::subtree<int_tree>(dropped_eager.begin() + 1));
+    vt::edit_transaction<int_tree> dropped(t);
+    dropped.insert_first_child(4, 50);
+    dropped.insert_sibling(5, 51);
+    dropped.erase_children(1);
+    dropped.insert_first_child(1, 52);
+    dropped.commit();
+    dropped_eager.insert_first_child(dropped_eager.begin() + 1, 52);
+    data.clear();
+    for (const auto& node : t) data.push_back(node.data);
+    QVERIFY((data == std::vector<int>{0, 1, 52}));
+    QVERIFY(std::equal(t.begin(), t.end(), dropped_eager.begin(), dropped_eager.end(), [](const auto& l, const auto& r) {
+        return l.data == r.data && l.drift == r.drift;
+    }));
+    checkInvariant(t);
+
+    // narrow drifts are checked before the tree changes
+    vt::drift_tree<int, uint8_t> narrow;
+    narrow.push_root(0);
+    for (int i = 1; i < 255; ++i) narrow.push_back_child(i);
+    vt::edit_transaction<vt::drift_tree<int, uint8_t>> deep(narrow);
+    deep.insert_first_child(254, 255);
+    deep.insert_first_child(0, -1);
+    bool thrown = false;
+    try {
+        deep.commit();
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(narrow.size(), size_t(255));
+    QCOMPARE(narrow.front().data, 0);
+    QCOMPARE(narrow.back().data, 254);
+
+    // a failed commit keeps the recorded order, savepoints still work
+    vt::edit_transaction<vt::drift_tree<int, uint8_t>> retry(narrow);
+    retry.insert_first_child(10, 100);
+    auto before_overflow = retry.save();
+    retry.insert_first_child(254, 255);
+    retry.insert_first_child(0, -1);
+    thrown = false;
+    try {
+        retry.commit();
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(retry.size(), size_t(3));
+    retry.rollback(before_overflow);
+    QCOMPARE(retry.size(), size_t(1));
+    retry.commit();
+    QCOMPARE(narrow.size(), size_t(256));
+    QCOMPARE(narrow[11].data, 100);
+    QCOMPARE(narrow[12].data, 11);
+    QCOMPARE(narrow.back().drift, uint8_t(255));
+}
+
+namespace {
+
+// the drift goes into the unused member
+struct spare_item {
+    spare_item() = default;
+    spare_item(int id) : id(id), key(uint64_t(id) * 3) {}
+    uint32_t id;
+    uint32_t spare;
+    uint64_t key;
+};
+
+// the drift goes into the upper byte of key
+struct tagged_item {
+    tagged_item() = default;
+    tagged_item(int id) : key(uint64_t(id) * 3), id(id) {}
+    uint64_t key;
+    uint32_t id;
+};
+
+// the drift follows the data without padding
+struct packed_item {
+    packed_item() = default;
+    packed_item(int id) : key(uint64_t(id) * 3) {}
+    uint64_t key;
+};
+
+struct plain_item {
+    plain_item(int id) : id(id) {}
+    int id;
+};
+
+int item_id(const plain_item& item) { return item.id; }
+int item_id(const spare_item& item) { return int(item.id); }
+int item_id(const tagged_item& item) { return int(item.id); }
+int item_id(const packed_item& item) { return int(item.key / 3); }
+
+template<typename node_t>
+int node_id(const node_t& node) { return item_id(node.data); }
+template<typename drift_t>
+int node_id(const vt::packed_drift_node<packed_item, drift_t>& node) { return item_id(node.load()); }
+
+// the same edits for every layout, returns ids and drifts in order
+template<typename tree_t>
+std::vector<std::pair<int, size_t>> layoutEdits() {
+    tree_t t;
+    t.push_root(1);
+    for (int i = 2; i < 40; ++i) {
+        if (i % 3) t.push_back_child(i);
+        else if (i % 5) t.push_back_sibling(i);
+        else t.push_back_level(i, 1);
+    }
+    t.emplace_root(0);
+    for (int i = 40; i < 50; ++i) t.emplace_first_child(t.begin() + i % 7, i);
+    tree_t sub;
+    sub.push_root(60);
+    sub.push_back_child(61);
+    sub.push_back_sibling(62);
+    t.insert_child_tree(t.begin() + 5, sub.begin(), sub.end());
+    auto leaf = std::find_if(t.begin() + 1, t.end(), [](const auto& n) { return vt::drift_of(n) != 0; });
+    t.erase_leaf(leaf);
+    t.erase_subtree(vt::subtree<tree_t>(t.begin() + 3));
+    t.pop_back();
+
+    std::vector<std::pair<int, size_t>> result;
+    for (const auto& node : t) result.emplace_back(node_id(node), size_t(vt::drift_of(node)));
+
+    // traversals see the same levels
+    size_t post = 0, level_sum = 0;
+    for (auto it = vt::post_order(t).begin(); it != vt::post_order(t).end(); ++it) post += it.level();
+    for (auto level : vt::level_order(t))
+        for (auto& node : level) level_sum += level.level() * size_t(node_id(node));
+    result.emplace_back(int(post), level_sum);
+    return result;
+}
+
+} // namespace
+
+namespace vt {
+template<typename drift_t>
+struct node_layout<spare_item, drift_t> { using type = field_drift_node<spare_item, uint32_t, &spare_item::spare>; };
+template<typename drift_t>
+struct node_layout<tagged_item, drift_t> { using type = bits_drift_node<tagged_item, uint64_t, &tagged_item::key, 56, 8>; };
+template<typename drift_t>
+struct node_layout<packed_item, drift_t> { using type = packed_drift_node<packed_item, uint8_t>; };
+} // namespace vt
+
+void
+BuilderTest::nodeLayout() {
+    static_assert(sizeof(vt::drift_node<spare_item, uint32_t>) == 24, "padding between drift and data");
+    static_assert(sizeof(vt::drift_tree<spare_item>::node_t) == 16, "drift in the spare member");
+    static_assert(sizeof(vt::drift_tree<tagged_item>::node_t) == 16, "drift in the tag bits");
+    static_assert(sizeof(vt::drift_tree<packed_item>::node_t) == 9, "drift behind the data");
+    static_assert(std::is_same<vt::relocating_drift_tree<tagged_item>::vector_t,
+                               vt::relocatable_vector<vt::drift_tree<tagged_item>::node_t>>::value,
+                  "layouts relocate like their payload");
+
+    // reference with the default layout
+    auto expected = layoutEdits<vt::drift_tree<plain_item>>();
+    QCOMPARE(expected.size(), size_t(45));
+    QVERIFY(layoutEdits<vt::drift_tree<spare_item>>() == expected);
+    QVERIFY(layoutEdits<vt::drift_tree<tagged_item>>() == expected);
+    QVERIFY(layoutEdits<vt::drift_tree<packed_item>>() == expected);
+    QVERIFY(layoutEdits<vt::relocating_drift_tree<tagged_item>>() == expected);
+    QVERIFY(layoutEdits<vt::double_ended_drift_tree<spare_item>>() == expected);
+
+    // the payload bits survive drift updates
+    vt::drift_tree<tagged_item> tagged;
+    tagged.push_root(7);
+    tagged.push_back_child(8);
+    tagged.push_back_child(9);
+    tagged.push_back_level(10, 1);
+    QCOMPARE(tagged.front().payload_bits(), uint64_t(21));
+    QCOMPARE(tagged[2].payload_bits(), uint64_t(27));
+    QCOMPARE(vt::drift_of(tagged[2]), uint64_t(2));
+    QCOMPARE(vt::drift_of(tagged.back()), uint64_t(2));
+
+    // the bit range limits the depth
+    tagged.clear();
+    tagged.push_root(0);
+    for (int i = 1; i < 255; ++i) tagged.push_back_child(i);
+    QCOMPARE(vt::drift_of(tagged.back()), uint64_t(255));
+    bool thrown = false;
+    try {
+        tagged.push_back_child(255);
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(tagged.size(), size_t(255));
+    QCOMPARE(vt::drift_of(tagged.back()), uint64_t(255));
+    QCOMPARE(tagged.back().payload_bits(), uint64_t(254 * 3));
+
+    // the static tree follows the layout as well
+    vt::static_drift_tree<spare_item, 4> fixed;
+    fixed.push_root(1);
+    fixed.push_back_child(2);
+    fixed.push_back_sibling(3);
+    QCOMPARE(vt::drift_of(fixed[0]), uint32_t(0));
+    QCOMPARE(vt::drift_of(fixed[1]), uint32_t(1));
+    QCOMPARE(vt::drift_of(fixed[2]), uint32_t(2));
+    QCOMPARE(fixed[2].data.key, uint64_t(9));
+}
+
+namespace {
+
+// new entries are 0, they take the data of their node, existing entries have to match it
+template<typename tree_t>
+bool syncColumn(tree_t& tree, vt::column_handle<int> handle) {
+    auto& column = tree.column(handle);
+    if (column.size() != tree.size()) return false;
+    for (size_t i = 0; i < tree.size(); ++i) {
+        if (0 == column[i]) column[i] = tree[i].data;
+        else if (column[i] != tree[i].data) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void
+BuilderTest::sideColumns() {
+    int_tree t;
+    t.push_root(1);
+    auto mirror = t.attach_column<int>();
+    auto owned = t.attach_column<std::unique_ptr<int>>();
+    // data of the single node with an owned value
+    auto ownedData = [owned](const int_tree& tree) {
+        auto& column = tree.column(owned);
+        auto it = std::find_if(column.begin(), column.end(), [](const auto& p) { return bool(p); });
+        return it == column.end() ? -1 : tree[size_t(it - column.begin())].data;
+    };
+    QVERIFY(t.columns().attached());
+    QVERIFY(syncColumn(t, mirror));
+
+    for (int i = 2; i < 30; ++i) {
+        if (i % 3) t.push_back_child(i);
+        else if (i % 5) t.emplace_back_sibling(i);
+        else t.push_back_level(i, 1);
+        QVERIFY(syncColumn(t, mirror));
+    }
+    t.push_root(30);
+    QVERIFY(syncColumn(t, mirror));
+    t.column(owned)[1].reset(new int(1));
+    t.insert_first_child(t.begin() + 4, 31);
+    QVERIFY(syncColumn(t, mirror));
+    t.insert_sibling(t.begin() + 1, 32);
+    QVERIFY(syncColumn(t, mirror));
+    QCOMPARE(ownedData(t), 1);
+
+    int_tree sub;
+    sub.push_root(40);
+    sub.push_back_child(41);
+    t.insert_child_tree(t.begin() + 7, sub.begin(), sub.end());
+    QVERIFY(syncColumn(t, mirror));
+    std::vector<std::pair<size_t, int_tree>> entries{{0, sub}, {3, sub}, {3, sub}, {t.size() - 1, sub}};
+    t.insert_child_trees(entries.begin(), entries.end());
+    QVERIFY(syncColumn(t, mirror));
+
+    auto leaf = std::find_if(t.begin() + 1, t.end(), [](const auto& n) { return n.is_leaf(); });
+    t.erase_leaf(leaf);
+    QVERIFY(syncColumn(t, mirror));
+    t.erase_subtree(vt::subtree<int_tree>(t.begin() + 5));
+    QVERIFY(syncColumn(t, mirror));
+    t.pop_back();
+    QVERIFY(syncColumn(t, mirror));
+    QCOMPARE(t.column(owned).size(), t.size());
+    QCOMPARE(ownedData(t), 1);
+
+    // transactions keep the values of the original nodes
+    vt::edit_transaction<int_tree> tx(t);
+    tx.insert_first_child(2, 60);
+    tx.insert_sibling(4, 61);
+    tx.erase_children(6);
+    tx.commit();
+    QVERIFY(syncColumn(t, mirror));
+    QCOMPARE(ownedData(t), 1);
+
+    // move only values cannot be copied with the tree
+    bool thrown = false;
+    try {
+        int_tree failed(t);
+    }
+    catch (const std::logic_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    t.detach_column(owned);
+    checkInvariant(t);
+
+    // copies carry their own columns with the same handles
+    auto copy = t;
+    copy.column(mirror)[0] = -1;
+    QCOMPARE(t.column(mirror)[0], t[0].data);
+    copy.push_back_sibling(50);
+    QVERIFY(!syncColumn(copy, mirror));
+    copy.column(mirror)[0] = copy[0].data;
+    QVERIFY(syncColumn(copy, mirror));
+
+    // detached storage is reused by the next batch
+    auto values = t.detach_column(mirror);
+    QCOMPARE(values.size(), t.size());
+    QVERIFY(!t.columns().attached());
+    t.push_back_sibling(70);
+    auto capacity = values.capacity();
+    auto data = values.data();
+    auto batch = t.attach_column(std::move(values));
+    QCOMPARE(t.column(batch).data(), data);
+    QVERIFY(capacity >= t.size());
+    QVERIFY(std::all_of(t.column(batch).begin(), t.column(batch).end(), [](int v) { return v == 0; }));
+    QVERIFY(syncColumn(t, batch));
+    t.clear();
+    QCOMPARE(t.column(batch).size(), size_t(0));
+    t.assign(sub.begin(), sub.end());
+    QVERIFY(syncColumn(t, batch));
+
+    // the columns move along when the drifts widen
+    vt::widening_drift_tree<int> wide;
+    wide.push_root(1);
+    auto depth = wide.attach_column<int>();
+    for (int i = 2; i < 600; ++i) {
+        wide.push_back_child(i);
+        wide.column(depth)[size_t(i - 1)] = i;
+    }
+    QCOMPARE(wide.drift_size(), size_t(2));
+    QCOMPARE(wide.column(depth).size(), size_t(599));
+    QCOMPARE(wide.column(depth)[598], 599);
+    QCOMPARE(wide.column(depth)[200], 201);
+}
+
+namespace {
+
+template<typename tree_t>
+std::vector<size_t> treeLevels(const tree_t& tree) {
+    std::vector<size_t> levels;
+    size_t level = 0;
+    for (const auto& node : tree) {
+        levels.push_back(level);
+        level = level + 1 - vt::drift_of(node);
+    }
+    return levels;
+}
+
+} // namespace
+
+void
+BuilderTest::treeShapes() {
+    int_tree t;
+    auto make = [](size_t i, size_t) { return int(i); };
+
+    vt::chain_shape chains(3);
+    vt::generate_tree(t, chains, 7, make);
+    checkInvariant(t);
+    QVERIFY((treeLevels(t) == std::vector<size_t>{0, 1, 2, 3, 1, 2, 3}));
+    QCOMPARE(t[6].data, 6);
+
+    vt::kary_shape binary(2, 6);
+    vt::generate_tree(t, binary, 6, make);
+    checkInvariant(t);
+    QVERIFY((treeLevels(t) == std::vector<size_t>{0, 1, 2, 2, 1, 2}));
+
+    vt::kary_shape star(size_t(-1), 5);
+    vt::generate_tree(t, star, 5, make);
+    QVERIFY((treeLevels(t) == std::vector<size_t>{0, 1, 1, 1, 1}));
+
+    // a complete 3-ary tree with 1 + 3 + 9 + 27 nodes
+    vt::kary_shape ternary(3, 40);
+    vt::generate_tree(t, ternary, 40, [](size_t, size_t level) { return int(level); });
+    checkInvariant(t);
+    QCOMPARE(std::count_if(t.begin(), t.end(), [](const auto& n) { return n.data == 3; }), std::ptrdiff_t(27));
+
+    // seeded shapes are reproducible
+    for (auto seed : {1ull, 2ull}) {
+        vt::random_shape a(16, seed), b(16, seed);
+        std::vector<size_t> first, second;
+        vt::generate_levels(a, 1000, std::back_inserter(first));
+        vt::generate(b, 1000, [&](size_t i, size_t level) {
+            QCOMPARE(i, second.size());
+            second.push_back(level);
+        });
+        QVERIFY(first == second);
+        QVERIFY(*std::max_element(first.begin(), first.end()) <= 16);
+    }
+    vt::random_shape one(16, 1), two(16, 2);
+    std::vector<size_t> first, second;
+    vt::generate_levels(one, 100, std::back_inserter(first));
+    vt::generate_levels(two, 100, std::back_inserter(second));
+    QVERIFY(first != second);
+
+    for (auto shape : {vt::dom_shape(7), vt::filesystem_shape(7)}) {
+        auto copy = shape;
+        vt::generate_tree(t, shape, 10000, make);
+        checkInvariant(t);
+        auto levels = treeLevels(t);
+        std::vector<size_t> expected;
+        vt::generate_levels(copy, 10000, std::back_inserter(expected));
+        QVERIFY(levels == expected);
+        QVERIFY(*std::max_element(levels.begin(), levels.end()) <= 48);
+        QCOMPARE(std::count(levels.begin(), levels.end(), size_t(0)), std::ptrdiff_t(1));
+    }
+
+    // narrow drifts are checked while the nodes are written
+    vt::drift_tree<int, uint8_t> narrow;
+    vt::chain_shape chain;
+    bool thrown = false;
+    try {
+        vt::generate_tree(narrow, chain, 300, make);
+    } catch (const std::overflow_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QVERIFY(narrow.empty());
+    vt::chain_shape short_chain;
+    vt::generate_tree(narrow, short_chain, 255, make);
+    QCOMPARE(narrow.back().drift, uint8_t(255));
+}
+
+void
+BuilderTest::instrumentation() {
+    // the default policy adds nothing to the tree
+    static_assert(sizeof(vt::drift_tree<int>) == sizeof(std::vector<vt::drift_node<int>>) + sizeof(vt::column_registry),
+                  "no_instrumentation has to be empty");
+
+    using counted_tree = vt::drift_tree<int, size_t, std::allocator<vt::drift_node<int>>,
+                                        std::vector<vt::drift_node<int>>, vt::counting_instrumentation<>>;
+    counted_tree t;
+    t.reserve(16);
+    t.push_root(0);
+    t.push_back_child(1);
+    t.push_back_child(2);
+    t.push_back_level(3, 1);
+    t.push_root(4);
+    // <0,4> <0,0> <0,1> <2,2> <2,3>
+    auto stats = t.instrumentation().snapshot();
+    QCOMPARE(stats[vt::tree_op::storage].calls, uint64_t(1));
+    QCOMPARE(stats[vt::tree_op::push_back].calls, uint64_t(3));
+    QCOMPARE(stats[vt::tree_op::push_back].moved_nodes, uint64_t(0));
+    QCOMPARE(stats[vt::tree_op::push_root].calls, uint64_t(2));
+    QCOMPARE(stats[vt::tree_op::push_root].moved_nodes, uint64_t(4));
+    QCOMPARE(stats[vt::tree_op::push_root].moved_bytes, uint64_t(4 * sizeof(vt::drift_node<int>)));
+    QCOMPARE(stats.total().reallocations, uint64_t(1));
+
+    t.insert_first_child(t.begin() + 2, 5);
+    t.erase_leaf(t.begin() + 3);
+    t.erase_subtree(vt::subtree<counted_tree>(t.begin() + 1));
+    stats = t.instrumentation().snapshot();
+    QCOMPARE(stats[vt::tree_op::insert_first_child].moved_nodes, uint64_t(2));
+    QCOMPARE(stats[vt::tree_op::erase_leaf].moved_nodes, uint64_t(2));
+    // the subtree of node 0 spans 4 nodes, nothing is behind it
+    QCOMPARE(stats[vt::tree_op::erase_subtree].scanned_nodes, uint64_t(4));
+    QCOMPARE(stats[vt::tree_op::erase_subtree].moved_nodes, uint64_t(0));
+    QCOMPARE(t.size(), size_t(2));
+
+    // a transaction keeps the counts and adds one rebuild of the storage
+    vt::edit_transaction<counted_tree> tx(t);
+    tx.insert_first_child(0, 6);
+    tx.commit();
+    auto committed = t.instrumentation().snapshot();
+    QCOMPARE(t.size(), size_t(3));
+    QCOMPARE(committed[vt::tree_op::push_root].calls, stats[vt::tree_op::push_root].calls);
+    QCOMPARE(committed[vt::tree_op::push_back].calls, stats[vt::tree_op::push_back].calls);
+    QCOMPARE(committed[vt::tree_op::storage].calls, stats[vt::tree_op::storage].calls + 1);
+    QCOMPARE(committed[vt::tree_op::storage].moved_nodes, stats[vt::tree_op::storage].moved_nodes + 3);
+    QCOMPARE(committed.total().reallocations, stats.total().reallocations + 1);
+
+    // the buffer grows while there is no free capacity, all nodes move
+    counted_tree g;
+    g.push_root(0);
+    uint64_t reallocations = 0, moved = 0;
+    for (int i = 1; i < 100; ++i) {
+        auto capacity = g.capacity();
+        g.push_back_child(i);
+        if (g.capacity() != capacity) {
+            reallocations += 1;
+            moved += uint64_t(i);
+        }
+    }
+    stats = g.instrumentation().snapshot();
+    QVERIFY(0 < reallocations);
+    QCOMPARE(stats[vt::tree_op::push_back].reallocations, reallocations);
+    QCOMPARE(stats[vt::tree_op::push_back].moved_nodes, moved);
+    std::vector<std::string> names;
+    stats.for_each([&](const char* name, const vt::operation_stats&) { names.push_back(name); });
+    QCOMPARE(names.size(), vt::tree_op_count);
+    QCOMPARE(names.front(), std::string("push_root"));
+    g.instrumentation().reset();
+    QCOMPARE(g.instrumentation().snapshot().total().calls, uint64_t(0));
+
+    // double ended storage moves the shorter side
+    using counted_de_tree = vt::drift_tree<int, size_t, std::allocator<vt::drift_node<int>>,
+                                           vt::double_ended_vector<vt::drift_node<int>>, vt::counting_instrumentation<true>>;
+    counted_de_tree d;
+    d.reserve_front(64);
+    d.reserve(64);
+    d.push_root(0);
+    for (int i = 1; i < 10; ++i) d.push_root(i);
+    d.insert_first_child(d.begin() + 1, 10);
+    auto de_stats = d.instrumentation().snapshot();
+    QCOMPARE(de_stats[vt::tree_op::push_root].moved_nodes, uint64_t(0));
+    QCOMPARE(de_stats[vt::tree_op::push_root].reallocations, uint64_t(0));
+    QCOMPARE(de_stats[vt::tree_op::insert_first_child].moved_nodes, uint64_t(2));
+    uint64_t timed = 0;
+    for (auto count : de_stats.latency[size_t(vt::tree_op::push_root)]) timed += count;
+    QCOMPARE(timed, uint64_t(10));
+}
+
+void
+BuilderTest::memoryReport() {
+    // the allocator counts the nodes and the characters of the strings
+    using string_t = std::basic_string<char, std::char_traits<char>, vt::tracking_allocator<char>>;
+    using node_t = vt::drift_node<string_t, uint8_t>;
+    vt::allocation_stats stats;
+    {
+        vt::drift_tree<string_t, uint8_t, vt::tracking_allocator<node_t>> t{vt::tracking_allocator<node_t>(stats)};
+        vt::tracking_allocator<char> chars(stats);
+        t.reserve(4);
+        t.push_root(string_t("a string longer than the small buffer", chars));
+        t.push_back_child(string_t("b", chars));
+        QCOMPARE(stats.allocations, size_t(2));
+        QVERIFY(stats.bytes > 4 * sizeof(node_t) + 37);
+
+        auto usage = vt::memory_report(t, [](const string_t& s) {
+            return s.capacity() + 1 > 16 ? s.capacity() + 1 : size_t(0);
+        });
+        QCOMPARE(usage.nodes, size_t(2));
+        QCOMPARE(usage.slack_bytes, 2 * sizeof(node_t));
+        QCOMPARE(usage.payload_heap_bytes, stats.bytes - 4 * sizeof(node_t));
+        QCOMPARE(usage.tracked_heap_bytes, stats.bytes);
+        QCOMPARE(usage.total_bytes(), stats.bytes);
+        QCOMPARE(usage.max_level, size_t(1));
+    }
+    QCOMPARE(stats.bytes, size_t(0));
+    QCOMPARE(stats.allocations, stats.deallocations);
+
+    // {uint32_t id; uint64_t key;} with size_t drifts: 16 + 8 bytes per node
+    struct item { uint32_t id; uint64_t key; };
+    vt::drift_tree<item> wide;
+    wide.reserve(100000);
+    vt::chain_shape chains(10);
+    vt::generate_tree(wide, chains, 1000, [](size_t i, size_t) { return item{uint32_t(i), i}; });
+    vt::subtree_index<vt::drift_tree<item>> index(wide);
+    auto usage = vt::memory_report(wide);
+    usage.add_sidecar(index.memory_bytes());
+    QCOMPARE(usage.node_bytes, size_t(24));
+    QCOMPARE(usage.drift_bytes, size_t(8));
+    QCOMPARE(usage.padding_bytes, size_t(0));
+    QCOMPARE(usage.max_level, size_t(10));
+    QCOMPARE(usage.sidecar_bytes, 1000 * sizeof(size_t));
+    QCOMPARE(usage.total_bytes(), 100000 * size_t(24) + 1000 * sizeof(size_t));
+
+    auto advice = vt::advise_layout(usage);
+    QCOMPARE(advice.drift_bytes, size_t(1));
+    QCOMPARE(advice.node_bytes, size_t(24));
+    QVERIFY(advice.pack);
+    QCOMPARE(advice.packed_node_bytes, size_t(17));
+    QCOMPARE(advice.saved_bytes_per_node(usage), size_t(7));
+    QVERIFY(advice.split_payload);
+    QVERIFY(advice.shrink_to_fit);
+    QVERIFY(!advice.describe().empty());
+
+    // side columns count with the tree
+    auto column = wide.attach_column<uint64_t>();
+    QVERIFY(vt::memory_report(wide).column_bytes >= 1000 * sizeof(uint64_t));
+    wide.detach_column(column);
+    wide.shrink_to_fit();
+    QVERIFY(!vt::advise_layout(vt::memory_report(wide)).shrink_to_fit);
+
+    // small payloads stay in the nodes
+    vt::drift_tree<uint32_t, uint32_t> small;
+    small.push_root(0);
+    auto small_advice = vt::advise_layout(vt::memory_report(small));
+    QVERIFY(!small_advice.split_payload);
+    QCOMPARE(small_advice.node_bytes, size_t(8));
+    QCOMPARE(small_advice.packed_node_bytes, size_t(5));
+
+    // push_root on std::vector storage moves all nodes each time
+    using counted_tree = vt::drift_tree<int, size_t, std::allocator<vt::drift_node<int>>,
+                                        std::vector<vt::drift_node<int>>, vt::counting_instrumentation<>>;
+    counted_tree roots;
+    roots.push_root(0);
+    for (int i = 1; i < 1000; ++i) roots.push_root(i);
+    auto usage_advice = vt::advise_layout(vt::memory_report(roots), roots.instrumentation().snapshot());
+    QVERIFY(usage_advice.double_ended);
+    QVERIFY(!usage_advice.batch_edits);
+
+    // the headroom of a double ended storage is free capacity as well
+    vt::double_ended_drift_tree<int> front_roots;
+    front_roots.push_root(0);
+    for (int i = 1; i < 1000; ++i) front_roots.push_root(i);
+    auto front_usage = vt::memory_report(front_roots);
+    const auto& storage = front_roots.storage();
+    QCOMPARE(front_usage.capacity, storage.front_capacity() + storage.capacity() - storage.size());
+    QVERIFY(front_usage.capacity > front_roots.capacity());
+    QCOMPARE(front_usage.slack_bytes, (front_usage.capacity - 1000) * front_usage.node_bytes);
+}
+
+void
+BuilderTest::driftTrie() {
+    using trie_t = vt::drift_trie<int>;
+    std::vector<std::pair<std::string, int>> keys = {{"in", 1}, {"inn", 2}, {"tea", 3}, {"ted", 4}, {"ten", 5}};
+    trie_t trie(keys.begin(), keys.end());
+    QCOMPARE(trie.size(), size_t(5));
+
+    // <0,""> <0,"in"> <2,"n"> <0,"te"> <1,"a"> <1,"d"> <3,"n">
+    const auto& tree = trie.tree();
+    QCOMPARE(tree.size(), size_t(7));
+    size_t drifts[] = {0, 0, 2, 0, 1, 1, 3};
+    for (size_t i = 0; i < 7; ++i) QCOMPARE(size_t(vt::drift_of(tree[i])), drifts[i]);
+
+    for (const auto& key : keys) {
+        QVERIFY(trie.find(key.first));
+        QCOMPARE(*trie.find(key.first), key.second);
+    }
+    QVERIFY(!trie.find(""));
+    QVERIFY(!trie.find("i"));
+    QVERIFY(!trie.find("te"));
+    QVERIFY(!trie.find("tex"));
+    QVERIFY(!trie.find("inns"));
+    QVERIFY(!trie.contains("x"));
+
+    auto match = trie.longest_prefix("innkeeper");
+    QVERIFY(match);
+    QCOMPARE(match.length, size_t(3));
+    QCOMPARE(*match.value, 2);
+    QCOMPARE(trie.longest_prefix("ink").length, size_t(2));
+    QVERIFY(!trie.longest_prefix("tex"));
+    QVERIFY(!trie.longest_prefix("i"));
+
+    // the keys of a prefix are one contiguous range, also if the prefix ends inside a label
+    auto range = std::make_pair(size_t(3), size_t(7));
+    QVERIFY(trie.prefix_range("te") == range);
+    QVERIFY(trie.prefix_range("t") == range);
+    QCOMPARE(trie.prefix_range("x").first, trie.prefix_range("x").second);
+    QCOMPARE(trie.count_prefixed("te"), size_t(3));
+    QCOMPARE(trie.count_prefixed(""), size_t(5));
+    QCOMPARE(trie.count_prefixed("inn"), size_t(1));
+    QCOMPARE(trie.count_prefixed("tx"), size_t(0));
+
+    std::vector<std::pair<std::string, int>> found;
+    trie.for_each_prefixed("t", [&](const std::string& key, int value) { found.emplace_back(key, value); });
+    QVERIFY(found == decltype(keys)(keys.begin() + 2, keys.end()));
+    found.clear();
+    trie.for_each([&](const std::string& key, int value) { found.emplace_back(key, value); });
+    QVERIFY(found == keys);
+
+    // the empty key and a single key
+    std::vector<std::pair<std::string, int>> edge = {{"", 7}, {"abc", 8}};
+    trie_t small(edge.begin(), edge.end());
+    QCOMPARE(*small.find(""), 7);
+    QCOMPARE(small.longest_prefix("ab").length, size_t(0));
+    QCOMPARE(*small.longest_prefix("abcd").value, 8);
+    QVERIFY(trie_t().empty());
+    QVERIFY(!trie_t().find("a"));
+
+    // wide nodes use the binary search, byte values above 127 sort last
+    std::vector<std::pair<std::string, int>> wide;
+    for (int b = 1; b < 256; b += 3) wide.emplace_back(std::string(1, char(b)) + "x", b);
+    trie_t wide_trie(wide.begin(), wide.end());
+    QCOMPARE(wide_trie.tree()[0].data.child_count, uint32_t(wide.size()));
+    for (const auto& key : wide) QCOMPARE(*wide_trie.find(key.first), key.second);
+    QVERIFY(!wide_trie.find(std::string(1, char(2)) + "x"));
+    std::vector<std::pair<std::string, int>> narrow(wide.begin(), wide.begin() + 16);
+    trie_t narrow_trie(narrow.begin(), narrow.end());
+    for (const auto& key : narrow) QCOMPARE(*narrow_trie.find(key.first), key.second);
+    QVERIFY(!narrow_trie.find(wide[16].first));
+
+    // every key extends the previous one, the nodes form one long chain
+    std::vector<std::pair<std::string, int>> chain;
+    for (int i = 1; i <= 2000; ++i) chain.emplace_back(std::string(size_t(i), 'a'), i);
+    trie_t chain_trie(chain.begin(), chain.end());
+    QCOMPARE(chain_trie.tree().size(), chain.size());
+    QCOMPARE(size_t(chain_trie.tree().back().drift), chain.size());
+    QCOMPARE(*chain_trie.find(chain.back().first), 2000);
+    QCOMPARE(chain_trie.longest_prefix(std::string(3000, 'a')).length, size_t(2000));
+    QCOMPARE(chain_trie.count_prefixed(std::string(1000, 'a')), size_t(1001));
+
+    QVERIFY(trie.memory_bytes() > 0);
+    std::vector<std::pair<std::string, int>> unsorted = {{"b", 1}, {"a", 2}};
+    bool thrown = false;
+    try {
+        trie_t(unsorted.begin(), unsorted.end());
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    std::vector<std::pair<std::string, int>> duplicate = {{"a", 1}, {"a", 2}};
+    thrown = false;
+    try {
+        trie_t(duplicate.begin(), duplicate.end());
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+void
+BuilderTest::driftBvh() {
+    // a grid of unit boxes with gaps, the last two boxes share a center
+    std::vector<vt::aabb> boxes;
+    for (int x = 0; x < 8; ++x)
+        for (int y = 0; y < 8; ++y)
+            for (int z = 0; z < 4; ++z)
+                boxes.emplace_back(2.f * x, 2.f * y, 2.f * z, 2.f * x + 1, 2.f * y + 1, 2.f * z + 1);
+    boxes.emplace_back(0.25f, 0.25f, 0.25f, 0.75f, 0.75f, 0.75f);
+
+    auto brute_ray = [&](const vt::ray& r) {
+        float inverse[3] = {1 / r.direction[0], 1 / r.direction[1], 1 / r.direction[2]};
+        std::vector<uint32_t> hits;
+        for (uint32_t i = 0; i < boxes.size(); ++i)
+            if (vt::intersects(r.origin, inverse, r.t_min, r.t_max, boxes[i])) hits.push_back(i);
+        return hits;
+    };
+    std::vector<vt::ray> rays = {
+        {{-1.f, 0.5f, 0.5f}, {1.f, 0.f, 0.f}},            // along a row of boxes
+        {{-1.f, 1.5f, 0.5f}, {1.f, 0.f, 0.f}},            // through a gap
+        {{-1.f, -1.f, -1.f}, {1.f, 1.f, 1.f}},            // the diagonal
+        {{0.5f, 0.5f, 20.f}, {0.f, 0.f, -1.f}, 0.f, 15.f}, // limited interval
+        {{30.f, 30.f, 30.f}, {1.f, 0.f, 0.f}},            // outside
+    };
+
+    for (auto builder : {vt::bvh_builder::binned_sah, vt::bvh_builder::sweep_sah}) {
+        vt::bvh_options options;
+        options.builder = builder;
+        options.max_leaf_size = 2;
+        vt::drift_bvh bvh(boxes, options);
+        const auto& tree = bvh.tree();
+
+        // subtree ends match the drifts, every primitive is in one leaf
+        static_assert(sizeof(vt::drift_bvh::tree_t::node_t) == 32, "the drift is stored in the count");
+        std::vector<int> seen(boxes.size());
+        for (auto it = tree.begin(); it != tree.end(); ++it) {
+            auto pos = size_t(it - tree.begin());
+            QCOMPARE(bvh.subtree_end(pos), size_t(vt::find_subtree_end(it) - tree.begin()));
+            QVERIFY(it->data.is_leaf() == (0 != vt::drift_of(*it)));
+            QVERIFY(it->data.count() <= 2);
+            for (auto i = it->data.link; i < it->data.link + it->data.count(); ++i) {
+                seen[bvh.primitives()[i]] += 1;
+                auto bounds = it->data.bounds;
+                bounds.extend(boxes[bvh.primitives()[i]]);
+                QCOMPARE(bounds.area(), it->data.bounds.area());
+            }
+        }
+        QVERIFY(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+
+        for (auto r : rays) {
+            std::vector<uint32_t> hits;
+            bvh.intersect(r, [&](uint32_t primitive, vt::ray& ray) {
+                if (vt::intersects(ray.origin, std::array<float, 3>{{1 / ray.direction[0], 1 / ray.direction[1],
+                                                                     1 / ray.direction[2]}}.data(),
+                                   ray.t_min, ray.t_max, boxes[primitive]))
+                    hits.push_back(primitive);
+            });
+            std::sort(hits.begin(), hits.end());
+            QVERIFY(hits == brute_ray(r));
+        }
+
+        // the packet masks match the single rays
+        vt::ray_packet packet(rays.data(), 3);
+        std::vector<std::vector<uint32_t>> lanes(4);
+        bvh.intersect(packet, [&](uint32_t primitive, unsigned mask, const vt::ray_packet& p) {
+            for (size_t k = 0; k < 4; ++k) {
+                float origin[3] = {p.origin[0][k], p.origin[1][k], p.origin[2][k]};
+                float inverse[3] = {p.inverse[0][k], p.inverse[1][k], p.inverse[2][k]};
+                if (mask & (1u << k)
+                    && vt::intersects(origin, inverse, p.t_min[k], p.t_max[k], boxes[primitive]))
+                    lanes[k].push_back(primitive);
+            }
+        });
+        for (size_t k = 0; k < 3; ++k) {
+            std::sort(lanes[k].begin(), lanes[k].end());
+            QVERIFY(lanes[k] == brute_ray(rays[k]));
+        }
+        QVERIFY(lanes[3].empty());
+
+        // axis parallel rays starting on a slab face give 0 * inf = NaN, packets agree with single rays
+        std::vector<vt::ray> faces = {
+            {{0.f, 0.5f, -1.f}, {0.f, 0.f, 1.f}},
+            {{1.f, 0.5f, -1.f}, {-0.f, 0.f, 1.f}},
+            {{0.5f, 0.f, -1.f}, {0.f, 0.f, 1.f}},
+            {{0.5f, 1.f, -1.f}, {0.f, -0.f, 1.f}},
+        };
+        vt::ray_packet face_packet(faces.data(), faces.size());
+        for (size_t k = 0; k < faces.size(); ++k) {
+            float inverse[3] = {1 / faces[k].direction[0], 1 / faces[k].direction[1], 1 / faces[k].direction[2]};
+            QVERIFY(vt::intersects(faces[k].origin, inverse, faces[k].t_min, faces[k].t_max, boxes[0]));
+            QVERIFY(0 != (face_packet.hit_mask(boxes[0]) & (1u << k)));
+        }
+        std::vector<std::vector<uint32_t>> face_lanes(4);
+        bvh.intersect(face_packet, [&](uint32_t primitive, unsigned mask, const vt::ray_packet& p) {
+            for (size_t k = 0; k < 4; ++k)
+                if (mask & p.hit_mask(boxes[primitive]) & (1u << k)) face_lanes[k].push_back(primitive);
+        });
+        for (size_t k = 0; k < faces.size(); ++k) {
+            std::sort(face_lanes[k].begin(), face_lanes[k].end());
+            QVERIFY(face_lanes[k] == brute_ray(faces[k]));
+        }
+
+        vt::aabb query(1.5f, 1.5f, 1.5f, 4.5f, 2.5f, 2.5f);
+        std::vector<uint32_t> overlapping;
+        bvh.overlap(query, [&](uint32_t primitive) {
+            if (boxes[primitive].overlaps(query)) overlapping.push_back(primitive);
+        });
+        std::sort(overlapping.begin(), overlapping.end());
+        QCOMPARE(overlapping.size(), size_t(2));
+        QVERIFY(boxes[overlapping[0]].overlaps(query) && boxes[overlapping[1]].overlaps(query));
+
+        // moved boxes are found after the refit
+        auto moved = boxes;
+        for (auto& box : moved) {
+            box.lo[2] += 100;
+            box.hi[2] += 100;
+        }
+        bvh.refit(moved);
+        QCOMPARE(tree[0].data.bounds.lo[2], 100.f);
+        QCOMPARE(tree[0].data.bounds.hi[2], 107.f);
+        size_t found = 0;
+        bvh.overlap(vt::aabb(-1, -1, 99, 100, 100, 200), [&](uint32_t) { ++found; });
+        QCOMPARE(found, boxes.size());
+    }
+
+    // boxes with equal centers fall back to median splits
+    std::vector<vt::aabb> same(100, vt::aabb(0, 0, 0, 1, 1, 1));
+    vt::drift_bvh stacked(same);
+    QCOMPARE(stacked.primitives().size(), size_t(100));
+    size_t found = 0;
+    stacked.overlap(vt::aabb(0.5f, 0.5f, 0.5f, 2, 2, 2), [&](uint32_t) { ++found; });
+    QCOMPARE(found, size_t(100));
+    QVERIFY(vt::drift_bvh().empty());
+}
+
+void
+BuilderTest::evalReverse() {
+    // an operator or a leaf with a constant or the input of variable index
+    struct expr {
+        char op;
+        double value;
+    };
+    auto eval_row = [](const std::vector<double>& inputs) {
+        return [&inputs](const expr& e, const double* args, size_t arity) {
+            switch (e.op) {
+            case '+': return std::accumulate(args, args + arity, 0.0);
+            case '*': return std::accumulate(args, args + arity, 1.0, std::multiplies<double>());
+            case '-': return arity == 1 ? -args[0] : args[0] - args[1];
+            case 'x': return inputs[size_t(e.value)];
+            default: return e.value;
+            }
+        };
+    };
+
+    // (1 + 2 + 3) * -(x0 - 4)
+    vt::drift_tree<expr> tree;
+    tree.push_root({'*', 0});
+    tree.push_back_child({'+', 0});
+    tree.push_back_child({'c', 1});
+    tree.push_back_sibling({'c', 2});
+    tree.push_back_sibling({'c', 3});
+    tree.push_back_level({'-', 0}, 1);
+    tree.push_back_child({'-', 0});
+    tree.push_back_child({'x', 0});
+    tree.push_back_sibling({'c', 4});
+
+    std::vector<double> inputs = {10};
+    auto op = eval_row(inputs);
+    QCOMPARE(vt::eval_reverse(tree, op), -36.0);
+
+    // the evaluator keeps its stacks, subtrees are evaluated on their own
+    vt::reverse_evaluator<double> eval;
+    inputs[0] = 1;
+    QCOMPARE(eval(tree, op), 18.0);
+    QCOMPARE(eval(vt::subtree<const vt::drift_tree<expr>>(tree.begin() + 1), op), 6.0);
+    QCOMPARE(eval(vt::subtree<const vt::drift_tree<expr>>(tree.begin() + 6), op), -3.0);
+    QCOMPARE(eval(vt::subtree<const vt::drift_tree<expr>>(tree.begin() + 4), op), 3.0);
+
+    // the arities seen in tree order
+    std::vector<size_t> arities;
+    vt::eval_reverse<int>(tree, [&](const expr&, const int*, size_t arity) {
+        arities.push_back(arity);
+        return 0;
+    });
+    std::reverse(arities.begin(), arities.end());
+    QVERIFY(arities == std::vector<size_t>({2, 3, 0, 0, 0, 1, 2, 0, 0}));
+
+    // a single leaf
+    vt::drift_tree<expr> leaf;
+    leaf.push_root({'c', 7});
+    QCOMPARE(vt::eval_reverse(leaf, op), 7.0);
+
+    // batches give the results of the single rows, also for a partial last batch
+    using lanes_t = vt::value_lanes<double, 4>;
+    std::vector<double> xs;
+    for (int i = 0; i < 11; ++i) xs.push_back(i * 0.5);
+    std::vector<double> results(xs.size());
+    vt::eval_reverse_batch<double, 4>(tree, xs.size(), results.data(),
+                                      [&](const expr& e, const lanes_t* args, size_t arity, lanes_t& out,
+                                          vt::lane_rows rows) {
+        for (size_t k = 0; k < 4; ++k) {
+            double lane_args[3];
+            for (size_t a = 0; a < arity; ++a) lane_args[a] = args[a][k];
+            inputs[0] = xs[std::min(rows.first + k, xs.size() - 1)];
+            out[k] = op(e, lane_args, arity);
+        }
+    });
+    for (size_t i = 0; i < xs.size(); ++i) {
+        inputs[0] = xs[i];
+        QCOMPARE(results[i], vt::eval_reverse(tree, op));
+    }
+}
+
 QTEST_APPLESS_MAIN(BuilderTest)
 
 #include "tst_BuilderTest.moc"
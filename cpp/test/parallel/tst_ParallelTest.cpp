@@ -0,0 +1,463 @@
+/* vector_tree
+ * Copyright 2016 HicknHack Software GmbH
+ *
+ * The original code can be found at:
+ *    https://github.com/hicknhack-software/vector_tree
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "vector_tree/drift_tree.h"
+#include "vector_tree/parallel_builder.h"
+#include "vector_tree/parallel_traversal.h"
+#include "vector_tree/partition.h"
+#include "vector_tree/relocatable_vector.h"
+#include "vector_tree/submission_queue.h"
+
+#include <QString>
+#include <QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+namespace {
+
+// throws on a copy once copies_left is used up, moves never throw
+struct throwing_copy {
+    static int copies_left;
+
+    explicit throwing_copy(int v = 0) : value(v) {}
+    throwing_copy(const throwing_copy& other) : value(other.value) {
+        if (copies_left-- <= 0) throw std::runtime_error("throwing_copy");
+    }
+    throwing_copy(throwing_copy&&) noexcept = default;
+    throwing_copy& operator=(const throwing_copy&) = default;
+    throwing_copy& operator=(throwing_copy&&) noexcept = default;
+
+    int value;
+};
+
+int throwing_copy::copies_left = 0;
+
+// throws on a move once moves_left is used up, counts the live objects
+struct throwing_move {
+    static std::atomic<int> moves_left;
+    static std::atomic<int> live;
+
+    explicit throwing_move(int v = 0) : value(v) { ++live; }
+    throwing_move(const throwing_move& other) : value(other.value) { ++live; }
+    throwing_move(throwing_move&& other) : value(other.value) {
+        if (moves_left-- <= 0) throw std::runtime_error("throwing_move");
+        ++live;
+    }
+    throwing_move& operator=(const throwing_move&) = default;
+    throwing_move& operator=(throwing_move&& other) {
+        if (moves_left-- <= 0) throw std::runtime_error("throwing_move");
+        value = other.value;
+        return *this;
+    }
+    ~throwing_move() { --live; }
+
+    int value;
+};
+
+std::atomic<int> throwing_move::moves_left{0};
+std::atomic<int> throwing_move::live{0};
+
+} // namespace
+
+// the bytes of throwing_move can be moved, so relocating_drift_tree stores it in a relocatable_vector
+template<>
+struct vt::is_trivially_relocatable<throwing_move> : std::true_type {};
+
+class ParallelTest : public QObject {
+    Q_OBJECT
+    using int_tree = vt::drift_tree<int>;
+
+public:
+    ParallelTest();
+
+private:
+    template <typename T>
+    void checkInvariant(const typename vt::drift_tree<T>& tree) const;
+    int_tree mixedTree(int size) const;
+    template <typename tree_t>
+    void concatMoves() const;
+
+private Q_SLOTS:
+    void submissionQueue();
+    void parallelBuilder();
+    void subtreeIndex();
+    void parallelTraversal();
+    void partition();
+};
+
+ParallelTest::ParallelTest() {}
+
+template <typename T>
+void
+ParallelTest::checkInvariant(const typename vt::drift_tree<T>& tree) const {
+    auto sum = std::accumulate(tree.begin(), tree.end(), size_t(),
+                               [](auto s, const auto& n) { return s + n.drift; });
+    QVERIFY(sum == tree.size());
+    QVERIFY(0 == tree.size() || tree.back().is_leaf());
+}
+
+ParallelTest::int_tree
+ParallelTest::mixedTree(int size) const {
+    // deep chains mixed with wide fans
+    int_tree t;
+    t.push_root(0);
+    size_t level = 0;
+    for (int i = 1; i < size; ++i) {
+        if (i % 7 == 0 || level == 0) {
+            t.push_back_child(i);
+            level++;
+        }
+        else if (i % 97 == 0) {
+            level = std::min(level, size_t(i % 3 == 0 ? 1 : 2));
+            t.push_back_level(i, level);
+        }
+        else {
+            t.push_back_sibling(i);
+        }
+    }
+    return t;
+}
+
+void
+ParallelTest::submissionQueue() {
+    int_tree t;
+    /* 0
+     *  1 2
+     */
+    t.push_root(0);
+    t.push_back_child(1);
+    t.push_back_sibling(2);
+
+    const int threads = 4;
+    const int per_thread = 100;
+    vt::submission_queue<int_tree> queue;
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&queue, w] {
+            for (int i = 0; i < per_thread; ++i) {
+                int_tree sub;
+                sub.push_root(w);
+                sub.push_back_child(i);
+                queue.submit(1 + (i % 2), std::move(sub));
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    QVERIFY(!queue.empty());
+    QCOMPARE(queue.commit(t), size_t(threads * per_thread));
+    QVERIFY(queue.empty());
+    QCOMPARE(queue.commit(t), size_t(0));
+    checkInvariant<int>(t);
+    QCOMPARE(t.size(), size_t(3 + 2 * threads * per_thread));
+
+    using std::begin;
+    using std::end;
+
+    // every submission is attached as a child of its parent
+    auto st0 = vt::subtree<int_tree>(t.begin());
+    QCOMPARE(std::distance(begin(st0), end(st0)), 2 + 2 * threads * per_thread);
+    auto st1 = vt::subtree<int_tree>(t.begin() + 1);
+    QCOMPARE(std::distance(begin(st1), end(st1)), threads * per_thread);
+    auto grand_children = 0;
+    for (auto it = begin(st1); it != end(st1); ++it) {
+        if (it.level() == 2) {
+            QCOMPARE((*it).data % 2, 0);
+            grand_children++;
+        }
+    }
+    QCOMPARE(grand_children, threads * per_thread / 2);
+    QCOMPARE(t[1 + threads * per_thread + 1].data, 2);
+
+    // a parent position behind the tree drops that submission, the others stay queued
+    auto size = t.size();
+    int_tree leaf;
+    leaf.push_root(-1);
+    queue.submit(size, leaf);
+    queue.submit(0, leaf);
+    bool thrown = false;
+    try {
+        queue.commit(t);
+    }
+    catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(t.size(), size);
+    QVERIFY(!queue.empty());
+    QCOMPARE(queue.commit(t), size_t(1));
+    QCOMPARE(t[1].data, -1);
+
+    // a throwing copy leaves the tree unchanged and keeps the submissions in order
+    using copy_tree = vt::drift_tree<throwing_copy>;
+    copy_tree c;
+    c.push_root(throwing_copy(0));
+    c.push_back_child(throwing_copy(1));
+    vt::submission_queue<copy_tree> copy_queue;
+    for (int i = 0; i < 3; ++i) {
+        copy_tree sub;
+        sub.push_root(throwing_copy(10 + i));
+        copy_queue.submit(1, std::move(sub));
+    }
+    throwing_copy::copies_left = 2;
+    thrown = false;
+    try {
+        copy_queue.commit(c);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(c.size(), size_t(2));
+    QCOMPARE(c[0].data.value, 0);
+    QCOMPARE(c[1].data.value, 1);
+    copy_tree late;
+    late.push_root(throwing_copy(13));
+    copy_queue.submit(1, std::move(late));
+    throwing_copy::copies_left = 100;
+    QCOMPARE(copy_queue.commit(c), size_t(4));
+    QCOMPARE(c.size(), size_t(6));
+    for (int i = 0; i < 4; ++i) QCOMPARE(c[2 + i].data.value, 10 + i);
+}
+
+void
+ParallelTest::parallelBuilder() {
+    const int fragments = 8;
+    const int per_fragment = 1000;
+
+    // serial reference: root with fragments * per_fragment small subtrees
+    int_tree serial;
+    serial.push_root(-1);
+    for (int f = 0; f < fragments; ++f) {
+        for (int i = 0; i < per_fragment; ++i) {
+            if (1 == serial.size())
+                serial.push_back_child(f);
+            else
+                serial.push_back_level(f, 1);
+            if (i % 3 == 0) serial.push_back_child(i);
+            if (i % 5 == 0) serial.push_back_child(i);
+        }
+    }
+
+    vt::parallel_builder<int_tree> builder(1 + fragments);
+    auto column = builder.attach_column<int>();
+    builder.fragment(0).push_root(-1);
+    builder.fragment(0).column(column)[0] = -1;
+    std::vector<std::thread> workers;
+    for (int f = 0; f < fragments; ++f) {
+        builder.set_level(1 + f, 1);
+        workers.emplace_back([&builder, f, column] {
+            auto& t = builder.fragment(1 + f);
+            for (int i = 0; i < per_fragment; ++i) {
+                if (t.empty())
+                    t.push_root(f);
+                else
+                    t.push_back_level(f, 0);
+                if (i % 3 == 0) t.push_back_child(i);
+                if (i % 5 == 0) t.push_back_child(i);
+            }
+            for (size_t i = 0; i < t.size(); ++i) t.column(column)[i] = t[i].data;
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    auto t = builder.concat(3);
+    checkInvariant<int>(t);
+    QCOMPARE(t.size(), serial.size());
+    for (size_t i = 0; i < t.size(); ++i) {
+        QCOMPARE(t[i].data, serial[i].data);
+        QCOMPARE(t[i].drift, serial[i].drift);
+        QCOMPARE(t.column(column)[i], serial[i].data);
+    }
+    QVERIFY(builder.fragment(1).empty());
+    QCOMPARE(builder.fragment(0).column(column).size(), size_t(0));
+
+    // std::vector storage is value initialized first, relocatable_vector storage is constructed in place
+    concatMoves<vt::drift_tree<throwing_move>>();
+    concatMoves<vt::relocating_drift_tree<throwing_move>>();
+}
+
+template <typename tree_t>
+void
+ParallelTest::concatMoves() const {
+    const int fragments = 4;
+    const int per_fragment = 100;
+    throwing_move::moves_left = std::numeric_limits<int>::max();
+    {
+        vt::parallel_builder<tree_t> builder(fragments);
+        auto fill = [&] {
+            for (int f = 0; f < fragments; ++f) {
+                auto& t = builder.fragment(size_t(f));
+                t.push_root(throwing_move(f));
+                for (int i = 0; i < per_fragment; ++i) t.push_back_child(throwing_move(i));
+            }
+        };
+        fill();
+        auto t = builder.concat(fragments);
+        QCOMPARE(t.size(), size_t(fragments * (1 + per_fragment)));
+        for (int f = 0; f < fragments; ++f) {
+            auto root = size_t(f * (1 + per_fragment));
+            QCOMPARE(t[root].data.value, f);
+            QCOMPARE(size_t(t[root + per_fragment].drift), size_t(per_fragment + 1));
+        }
+
+        // a throwing move in one of the threads is rethrown here and leaks no node
+        fill();
+        auto live = throwing_move::live.load();
+        throwing_move::moves_left = 2 * per_fragment;
+        bool thrown = false;
+        try {
+            builder.concat(fragments);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        QVERIFY(thrown);
+        QCOMPARE(throwing_move::live.load(), live);
+        throwing_move::moves_left = std::numeric_limits<int>::max();
+    }
+    QCOMPARE(throwing_move::live.load(), int(0));
+}
+
+void
+ParallelTest::subtreeIndex() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+
+    vt::subtree_index<int_tree> index(t);
+    size_t expected[] = {6, 4, 3, 4, 6, 6};
+    for (size_t i = 0; i < t.size(); ++i) QCOMPARE(index.end(i), expected[i]);
+    QCOMPARE(index.subtree_size(1), size_t(3));
+
+    // subtree sizes agree with subtree iteration
+    auto m = mixedTree(5000);
+    vt::subtree_index<int_tree> mixed_index(m);
+    for (size_t i = 0; i < m.size(); i += 13) {
+        auto st = vt::subtree<int_tree>(m.begin() + i);
+        QCOMPARE(size_t(std::distance(st.begin(), st.end())) + 1, mixed_index.subtree_size(i));
+    }
+}
+
+void
+ParallelTest::parallelTraversal() {
+    auto t = mixedTree(20000);
+    vt::subtree_index<int_tree> index(t);
+
+    // parent position of every node
+    std::vector<size_t> parents(t.size(), size_t(-1));
+    for (size_t i = 0; i < t.size(); ++i) {
+        for (auto c = i + 1; c < index.end(i); c = index.end(c)) parents[c] = i;
+    }
+
+    for (auto order : {vt::traversal_order::pre_order, vt::traversal_order::post_order}) {
+        std::atomic<size_t> clock{0};
+        std::vector<size_t> stamps(t.size());
+        std::vector<size_t> levels(t.size());
+        vt::parallel_for_each(t, index,
+                              [&](const auto& node, size_t level) {
+                                  auto pos = size_t(&node - &t[0]);
+                                  stamps[pos] = ++clock;
+                                  levels[pos] = level;
+                              },
+                              order, 64, 4);
+        QCOMPARE(clock.load(), t.size());
+        for (size_t i = 1; i < t.size(); ++i) {
+            QVERIFY(stamps[i] != 0);
+            QCOMPARE(levels[i], levels[parents[i]] + 1);
+            if (vt::traversal_order::pre_order == order)
+                QVERIFY(stamps[parents[i]] < stamps[i]);
+            else
+                QVERIFY(stamps[parents[i]] > stamps[i]);
+        }
+    }
+}
+
+void
+ParallelTest::partition() {
+    int_tree t;
+    /* 1
+     *  2    5
+     *   3 4  6 7 8
+     */
+    t.push_root(1);
+    t.push_back_child(2);
+    t.push_back_child(3);
+    t.push_back_sibling(4);
+    t.push_back_level(5, 1);
+    t.push_back_child(6);
+    t.push_back_sibling(7);
+    t.push_back_sibling(8);
+
+    auto small = vt::partition(t, 3);
+    QCOMPARE(small.size(), size_t(4));
+    QCOMPARE(small[0].first, size_t(0));
+    QCOMPARE(small[0].last, size_t(1));
+    QCOMPARE(small[0].level, size_t(0));
+    QCOMPARE(small[1].first, size_t(1));
+    QCOMPARE(small[1].last, size_t(4));
+    QCOMPARE(small[1].level, size_t(1));
+    QCOMPARE(small[2].first, size_t(4));
+    QCOMPARE(small[2].last, size_t(7));
+    QCOMPARE(small[2].level, size_t(1));
+    QCOMPARE(small[3].first, size_t(7));
+    QCOMPARE(small[3].level, size_t(2));
+
+    QCOMPARE(vt::partition(t, 8).size(), size_t(1));
+
+    // ranges cover the tree in order and respect the target size
+    auto m = mixedTree(20000);
+    vt::subtree_index<int_tree> index(m);
+    std::vector<size_t> levels;
+    size_t level = 0;
+    for (const auto& node : m) {
+        levels.push_back(level);
+        level = level + 1 - node.drift;
+    }
+    for (size_t target : {1, 10, 100, 5000}) {
+        auto ranges = vt::partition(m, index, target);
+        size_t next = 0;
+        for (const auto& r : ranges) {
+            QCOMPARE(r.first, next);
+            QVERIFY(0 < r.size() && r.size() <= target);
+            QCOMPARE(r.level, levels[r.first]);
+            // only the first node may be cut off from its later children
+            for (auto i = r.first + 1; i < r.last; ++i) {
+                QVERIFY(levels[i] >= r.level);
+                QVERIFY(index.end(i) <= r.last);
+            }
+            next = r.last;
+        }
+        QCOMPARE(next, m.size());
+    }
+}
+
+QTEST_APPLESS_MAIN(ParallelTest)
+
+#include "tst_ParallelTest.moc"
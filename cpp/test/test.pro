@@ -18,4 +18,5 @@
 TEMPLATE = subdirs
 
 SUBDIRS += \
-	builder
+	builder \
+	parallel
@@ -23,7 +23,9 @@ TEMPLATE = subdirs
 
 SUBDIRS += src
 !CONFIG(NoTest): SUBDIRS += test
+!CONFIG(NoBench): SUBDIRS += bench
 
 test.depends = src
+bench.depends = src
 
 CONFIG += c++14